@@ -0,0 +1,113 @@
+#include <ksg/Text.hpp>
+#include <ksg/CompactText.hpp>
+
+#include <SFML/Graphics/Font.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace ksg;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const std::size_t k_label_count = 2000;
+
+// every allocation is prefixed by its size, so that live bytes may be
+// tracked
+constexpr const std::size_t k_header_size = alignof(std::max_align_t);
+std::size_t s_live_bytes = 0;
+std::size_t s_allocation_count = 0;
+
+// short labels, as a list of levels would have (some too long to be kept
+// inline by a compact text)
+std::vector<std::string> make_labels();
+
+double milliseconds_since(Clock::time_point);
+
+template <typename TextType>
+void report(const char * what, const sf::Font &, const std::vector<std::string> &);
+
+} // end of <anonymous> namespace
+
+void * operator new(std::size_t size) {
+    auto * ptr = static_cast<unsigned char *>(std::malloc(size + k_header_size));
+    if (!ptr) throw std::bad_alloc();
+    *reinterpret_cast<std::size_t *>(ptr) = size;
+    s_live_bytes += size;
+    ++s_allocation_count;
+    return ptr + k_header_size;
+}
+
+void operator delete(void * ptr) noexcept {
+    if (!ptr) return;
+    auto * block = static_cast<unsigned char *>(ptr) - k_header_size;
+    s_live_bytes -= *reinterpret_cast<std::size_t *>(block);
+    std::free(block);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept { operator delete(ptr); }
+
+int main() {
+    sf::Font font;
+    if (!font.loadFromFile("demos/font.ttf") && !font.loadFromFile("font.ttf")) {
+        std::cerr << "Cannot load font.ttf (run from the repository's root, "
+                     "or the demos directory)." << std::endl;
+        return 1;
+    }
+    const auto labels = make_labels();
+    // glyphs are rasterized by the font on first use, that is not the text's
+    Text::measure_text(font, 14, U"Level 0123456789 (locked)");
+
+    report<Text>("Text", font, labels);
+    report<CompactText>("CompactText", font, labels);
+    TextLayoutCache::instance().forget_font(&font);
+    FontRegistry::instance().forget_font(&font);
+}
+
+namespace {
+
+std::vector<std::string> make_labels() {
+    std::vector<std::string> rv;
+    rv.reserve(k_label_count);
+    for (std::size_t i = 0; i != k_label_count; ++i)
+        { rv.push_back("Level " + std::to_string(i) + (i % 10 ? "" : " (locked)")); }
+    return rv;
+}
+
+double milliseconds_since(Clock::time_point start) {
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename TextType>
+void report(const char * what, const sf::Font & font,
+            const std::vector<std::string> & labels)
+{
+    // (glyph tables and cached layouts are counted with the texts)
+    const auto bytes_before       = s_live_bytes;
+    const auto allocations_before = s_allocation_count;
+    auto start = Clock::now();
+    {
+    std::vector<TextType> texts(labels.size());
+    for (std::size_t i = 0; i != labels.size(); ++i) {
+        texts[i].assign_font(&font);
+        texts[i].set_character_size(14);
+        texts[i].set_location(0.f, float(i)*20.f);
+        texts[i].set_string(std::string_view(labels[i]));
+    }
+    double ms = milliseconds_since(start);
+    const auto bytes       = s_live_bytes - bytes_before;
+    const auto allocations = s_allocation_count - allocations_before;
+    std::cout << what << ": " << ms << "ms to lay out " << labels.size()
+              << " labels, " << bytes << " bytes (" << (bytes / labels.size())
+              << " per label), " << allocations << " allocations" << std::endl;
+    }
+}
+
+} // end of <anonymous> namespace
@@ -47,14 +47,18 @@ int main() {
         "Window Title");
     window.setFramerateLimit(20);
     bool has_events = true;
+    std::vector<sf::Event> events;
     while (window.isOpen()) {
         sf::Event event;
+        // typing (or pasting) polled together is handled as one edit
+        events.clear();
         while (window.pollEvent(event)) {
             has_events = true;
-            dialog.process_event(event);
+            events.push_back(event);
             if (event.type == sf::Event::Closed)
                 window.close();
         }
+        dialog.process_events(events);
         if (dialog.requesting_to_close())
             window.close();
         if (has_events) {
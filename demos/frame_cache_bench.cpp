@@ -0,0 +1,110 @@
+#include <ksg/Frame.hpp>
+#include <ksg/TextArea.hpp>
+#include <ksg/TextButton.hpp>
+
+#include <SFML/Graphics/RenderTexture.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ksg;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const int k_button_count  = 60;
+constexpr const int k_row_length    = 6;
+constexpr const int k_draw_count    = 600;
+// one label changes this often (in draws), as a "score" or "status" would
+constexpr const int k_change_period = 60;
+
+class LevelSelect final : public Frame {
+public:
+    void setup(const StyleMap &);
+
+    void relabel(int draw_number);
+
+private:
+    std::vector<TextButton> m_buttons;
+};
+
+double milliseconds_since(Clock::time_point);
+
+void report(const char * what, LevelSelect &, sf::RenderTexture &);
+
+} // end of <anonymous> namespace
+
+int main() {
+    auto styles = styles::construct_system_styles();
+    auto font   = styles::load_font("font.ttf");
+    if (!font.is_valid()) font = styles::load_font("demos/font.ttf");
+    if (!font.is_valid()) {
+        std::cerr << "Cannot load font.ttf (run from the repository's root, "
+                     "or the demos directory)." << std::endl;
+        return 1;
+    }
+    styles[styles::k_global_font] = font;
+
+    sf::RenderTexture target;
+    if (!target.create(1024, 768)) {
+        std::cerr << "Cannot create a render texture to draw to." << std::endl;
+        return 1;
+    }
+
+    LevelSelect frame;
+    frame.setup(styles);
+
+    report("drawn directly", frame, target);
+
+    frame.set_render_caching(true);
+    report("render cached", frame, target);
+
+    const auto & counters = frame.render_cache_counters();
+    std::cout << "hits: " << counters.hit_count << ", misses: "
+              << counters.miss_count << ", hit rate: "
+              << (counters.hit_rate()*100.) << "%, texture: "
+              << counters.byte_count << " bytes" << std::endl;
+}
+
+namespace {
+
+void LevelSelect::setup(const StyleMap & styles) {
+    set_title(U"Level Select");
+    m_buttons.resize(k_button_count);
+    auto adder = begin_adding_widgets(styles);
+    for (int i = 0; i != k_button_count; ++i) {
+        m_buttons[std::size_t(i)].set_string("Level " + std::to_string(i + 1));
+        adder.add(m_buttons[std::size_t(i)]);
+        if (i % k_row_length == k_row_length - 1) adder.add_line_seperator();
+    }
+}
+
+void LevelSelect::relabel(int draw_number) {
+    if (draw_number % k_change_period != 0) return;
+    auto & button = m_buttons[std::size_t(draw_number / k_change_period) % m_buttons.size()];
+    button.set_string("Level " + std::to_string(draw_number) + "!");
+}
+
+double milliseconds_since(Clock::time_point start) {
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void report(const char * what, LevelSelect & frame, sf::RenderTexture & target) {
+    auto start = Clock::now();
+    for (int i = 0; i != k_draw_count; ++i) {
+        frame.relabel(i);
+        target.clear();
+        target.draw(frame);
+        target.display();
+    }
+    // waits for the GPU to finish what was drawn
+    (void)target.getTexture().copyToImage();
+    std::cout << what << ": " << (milliseconds_since(start) / k_draw_count)
+              << "ms per draw" << std::endl;
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,89 @@
+#include <ksg/LogArea.hpp>
+#include <ksg/TextArea.hpp>
+
+#include <SFML/Graphics/Font.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace ksg;
+
+namespace {
+
+using UString = LogArea::UString;
+using Clock   = std::chrono::steady_clock;
+
+constexpr const int k_lines_per_second = 10000;
+constexpr const int k_seconds          = 10;
+constexpr const int k_naive_line_count = 2000;
+
+UString make_line(int number);
+
+double milliseconds_since(Clock::time_point);
+
+} // end of <anonymous> namespace
+
+int main() {
+    sf::Font font;
+    if (!font.loadFromFile("demos/font.ttf") && !font.loadFromFile("font.ttf")) {
+        std::cerr << "Cannot load font.ttf (run from the repository's root, "
+                     "or the demos directory)." << std::endl;
+        return 1;
+    }
+
+    LogArea log;
+    log.assign_font(font);
+    log.set_character_size(14);
+    log.set_size(800.f, 600.f);
+    log.set_location(0.f, 0.f);
+    log.set_capacity(5000);
+
+    // each "second" of log lines must take well under a second to append
+    int line_number = 0;
+    double worst_ms = 0.;
+    for (int second = 0; second != k_seconds; ++second) {
+        auto start = Clock::now();
+        for (int i = 0; i != k_lines_per_second; ++i) {
+            log.append_line(make_line(line_number++));
+        }
+        double ms = milliseconds_since(start);
+        worst_ms = std::max(worst_ms, ms);
+        std::cout << "second " << second << ": " << k_lines_per_second
+                  << " lines appended in " << ms << "ms\n";
+    }
+    std::cout << "worst: " << worst_ms << "ms for " << k_lines_per_second
+              << " lines (" << (worst_ms < 1000. ? "sustainable" : "too slow")
+              << "), " << log.line_count() << " lines kept\n";
+
+    // for comparison, what appending to a TextArea's whole string costs
+    TextArea area;
+    area.assign_font(font);
+    area.set_character_size(14);
+    area.set_max_width(800.f);
+    area.set_max_height(600.f);
+    UString whole;
+    auto start = Clock::now();
+    for (int i = 0; i != k_naive_line_count; ++i) {
+        whole += make_line(i);
+        whole += U'\n';
+        area.set_string(whole);
+    }
+    std::cout << "TextArea::set_string(whole + line), " << k_naive_line_count
+              << " lines: " << milliseconds_since(start) << "ms" << std::endl;
+}
+
+namespace {
+
+UString make_line(int number) {
+    auto str = "[" + std::to_string(number) + "] frame update: entity "
+             + std::to_string(number % 97) + " moved, 3 collisions resolved";
+    return UString(str.begin(), str.end());
+}
+
+double milliseconds_since(Clock::time_point start) {
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // end of <anonymous> namespace
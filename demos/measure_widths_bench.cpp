@@ -0,0 +1,76 @@
+#include <ksg/Text.hpp>
+
+#include <SFML/Graphics/Font.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ksg;
+
+namespace {
+
+using UString = Text::UString;
+using Clock   = std::chrono::steady_clock;
+
+constexpr const std::size_t k_option_count = 5000;
+
+// options like a settings slider's resolution list
+std::vector<UString> make_options();
+
+double milliseconds_since(Clock::time_point);
+
+} // end of <anonymous> namespace
+
+int main() {
+    sf::Font font;
+    if (!font.loadFromFile("demos/font.ttf") && !font.loadFromFile("font.ttf")) {
+        std::cerr << "Cannot load font.ttf (run from the repository's root, "
+                     "or the demos directory)." << std::endl;
+        return 1;
+    }
+    const auto options = make_options();
+    // glyphs are rasterized by the font on first use, that is not measuring
+    Text::measure_widths(font, 14, options);
+
+    auto start = Clock::now();
+    float one_by_one = 0.f;
+    for (const auto & option : options) {
+        one_by_one = std::max(one_by_one,
+            Text::measure_width(font, 14, option.begin(), option.end()));
+    }
+    std::cout << "one by one: " << milliseconds_since(start) << "ms" << std::endl;
+
+    for (bool in_parallel : { false, true }) {
+        start = Clock::now();
+        float batched = 0.f;
+        for (float w : Text::measure_widths(font, 14, options, in_parallel))
+            { batched = std::max(batched, w); }
+        std::cout << (in_parallel ? "batched (parallel): " : "batched: ")
+                  << milliseconds_since(start) << "ms"
+                  << (batched == one_by_one ? "" : " (widths differ!)")
+                  << std::endl;
+    }
+}
+
+namespace {
+
+std::vector<UString> make_options() {
+    std::vector<UString> rv;
+    rv.reserve(k_option_count);
+    for (std::size_t i = 0; i != k_option_count; ++i) {
+        auto str = std::to_string(640 + i*16) + " x " + std::to_string(480 + i*9)
+                 + " @ " + std::to_string(30 + i % 5*30) + "Hz";
+        rv.emplace_back(str.begin(), str.end());
+    }
+    return rv;
+}
+
+double milliseconds_since(Clock::time_point start) {
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,100 @@
+#include <ksg/Text.hpp>
+#include <ksg/ParallelTextLayout.hpp>
+
+#include <SFML/Graphics/Font.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ksg;
+
+namespace {
+
+using UString = Text::UString;
+using Clock   = std::chrono::steady_clock;
+
+constexpr const std::size_t k_entry_count = 5000;
+
+// entries like a file browser's, names of varied lengths
+std::vector<UString> make_entries();
+
+double milliseconds_since(Clock::time_point);
+
+void set_up(Text &, const sf::Font &, const UString &);
+
+} // end of <anonymous> namespace
+
+int main() {
+    sf::Font font;
+    if (!font.loadFromFile("demos/font.ttf") && !font.loadFromFile("font.ttf")) {
+        std::cerr << "Cannot load font.ttf (run from the repository's root, "
+                     "or the demos directory)." << std::endl;
+        return 1;
+    }
+    const auto entries = make_entries();
+    // glyphs are rasterized by the font on first use, that is not layout's
+    Text::measure_widths(font, 14, entries);
+    // neither is sharing layouts, which would hide most of the work
+    TextLayoutCache::instance().set_byte_limit(0);
+
+    std::vector<Text> serial(entries.size());
+    auto start = Clock::now();
+    for (std::size_t i = 0; i != entries.size(); ++i)
+        { set_up(serial[i], font, entries[i]); }
+    std::cout << "serial: " << milliseconds_since(start) << "ms" << std::endl;
+
+    std::vector<Text> parallel(entries.size());
+    start = Clock::now();
+    ParallelTextLayout layouts;
+    for (auto & text : parallel) layouts.defer(text);
+    for (std::size_t i = 0; i != entries.size(); ++i)
+        { set_up(parallel[i], font, entries[i]); }
+    layouts.run();
+    std::cout << "parallel (" << std::thread::hardware_concurrency()
+              << " threads): " << milliseconds_since(start) << "ms" << std::endl;
+
+    for (std::size_t i = 0; i != entries.size(); ++i) {
+        if (serial[i].width() != parallel[i].width() ||
+            serial[i].height() != parallel[i].height())
+        {
+            std::cout << "layouts differ at entry " << i << "!" << std::endl;
+            return 1;
+        }
+    }
+}
+
+namespace {
+
+std::vector<UString> make_entries() {
+    static const char * const k_names[] = {
+        "README.md", "CMakeLists.txt", "screenshot_of_the_main_menu.png",
+        "src", "inc", "save_0001.dat", "a rather long document name, with "
+        "spaces, for wrapping.odt", "font.ttf", "build", "LICENSE"
+    };
+    static constexpr const std::size_t k_name_count = sizeof(k_names) / sizeof(k_names[0]);
+    std::vector<UString> rv;
+    rv.reserve(k_entry_count);
+    for (std::size_t i = 0; i != k_entry_count; ++i) {
+        auto str = std::to_string(i) + "_" + k_names[i % k_name_count];
+        if (i % 3 == 0) str += " (directory)";
+        rv.emplace_back(str.begin(), str.end());
+    }
+    return rv;
+}
+
+double milliseconds_since(Clock::time_point start) {
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void set_up(Text & text, const sf::Font & font, const UString & str) {
+    text.assign_font(&font);
+    text.set_character_size(14);
+    text.set_limiting_dimensions(300.f, Text::k_inf);
+    text.set_string(str);
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,81 @@
+#include <ksg/PieceTable.hpp>
+
+#include <chrono>
+#include <iostream>
+
+using namespace ksg;
+
+namespace {
+
+using UString = PieceTable::UString;
+using Clock   = std::chrono::steady_clock;
+
+constexpr const std::size_t k_document_size  = 5*1024*1024;
+constexpr const std::size_t k_line_length    = 80;
+constexpr const int         k_insertion_count = 10000;
+
+UString make_document();
+
+double milliseconds_since(Clock::time_point);
+
+} // end of <anonymous> namespace
+
+int main() {
+    const auto original = make_document();
+
+    // typing into the middle of the document, one character at a time,
+    // with the cursor's line looked up after each keystroke (as the editor
+    // does to place its cursor)
+    PieceTable table(original);
+    auto position = table.size() / 2;
+    int line_sum = 0;
+    auto start = Clock::now();
+    for (int i = 0; i != k_insertion_count; ++i) {
+        table.insert(position++, (i % k_line_length) ? U"a" : U"\n");
+        line_sum += table.line_of(position);
+        line_sum += int(table.line_start(table.line_of(position)) % 2);
+    }
+    const double piece_table_ms = milliseconds_since(start);
+
+    UString flat(original);
+    position = flat.size() / 2;
+    start = Clock::now();
+    for (int i = 0; i != k_insertion_count; ++i) {
+        flat.insert(position++, 1, (i % k_line_length) ? U'a' : U'\n');
+    }
+    const double flat_ms = milliseconds_since(start);
+
+    start = Clock::now();
+    int undone = 0;
+    while (table.undo()) { ++undone; }
+    const double undo_ms = milliseconds_since(start);
+
+    std::cout << "document: " << original.size() << " characters, "
+              << PieceTable(original).line_count() << " lines\n"
+              << k_insertion_count << " insertions in the middle:\n"
+              << "    piece table    : " << piece_table_ms << "ms ("
+              << table.piece_count() << " pieces after undo)\n"
+              << "    flat u32string : " << flat_ms << "ms\n"
+              << "undoing " << undone << " records: " << undo_ms << "ms\n"
+              << "(checksum " << line_sum << ")" << std::endl;
+}
+
+namespace {
+
+UString make_document() {
+    UString rv;
+    rv.reserve(k_document_size);
+    while (rv.size() < k_document_size) {
+        for (std::size_t i = 0; i != k_line_length - 1; ++i)
+            rv += UString::value_type(U'a' + (rv.size() % 26));
+        rv += U'\n';
+    }
+    return rv;
+}
+
+double milliseconds_since(Clock::time_point start) {
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,109 @@
+#include <ksg/Text.hpp>
+
+#include <SFML/Graphics/Font.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace ksg;
+
+namespace {
+
+using UString = Text::UString;
+using Clock   = std::chrono::steady_clock;
+
+constexpr const int k_paragraph_count = 200;
+constexpr const int k_relayout_count  = 1000;
+
+// every allocation made by the program passes through the replacements below
+std::size_t s_allocation_count = 0;
+
+UString make_paragraphs();
+
+double milliseconds_since(Clock::time_point);
+
+template <typename Func>
+void report(const char * what, Func && f);
+
+} // end of <anonymous> namespace
+
+void * operator new(std::size_t size) {
+    ++s_allocation_count;
+    if (void * ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void * ptr) noexcept { std::free(ptr); }
+
+void operator delete(void * ptr, std::size_t) noexcept { std::free(ptr); }
+
+int main() {
+    sf::Font font;
+    if (!font.loadFromFile("demos/font.ttf") && !font.loadFromFile("font.ttf")) {
+        std::cerr << "Cannot load font.ttf (run from the repository's root, "
+                     "or the demos directory)." << std::endl;
+        return 1;
+    }
+
+    const UString paragraphs = make_paragraphs();
+    Text text;
+    text.assign_font(&font);
+    text.set_character_size(14);
+    text.set_limiting_dimensions(800.f, Text::k_inf);
+    text.set_string(paragraphs);
+
+    report("set_string (same string)", [&](int) {
+        text.set_string(paragraphs);
+    });
+    report("set_limiting_dimensions (resizing)", [&](int i) {
+        text.set_limiting_dimensions(i % 2 ? 600.f : 800.f, Text::k_inf);
+    });
+    report("set_limiting_dimensions (shrinking)", [&](int i) {
+        text.set_limiting_dimensions(800.f - float(i % 200), Text::k_inf);
+    });
+    report("set_location", [&](int i) {
+        text.set_location(float(i % 10), 0.f);
+    });
+}
+
+namespace {
+
+UString make_paragraphs() {
+    static const char * const k_sentence =
+        "The quick brown fox jumps over the lazy dog, while the dog naps "
+        "on and on in the afternoon sun. ";
+    UString rv;
+    for (int i = 0; i != k_paragraph_count; ++i) {
+        for (int j = 0; j != 4; ++j) {
+            for (const char * c = k_sentence; *c; ++c) rv += UString::value_type(*c);
+        }
+        rv += U'\n';
+    }
+    return rv;
+}
+
+double milliseconds_since(Clock::time_point start) {
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename Func>
+void report(const char * what, Func && f) {
+    // warm up, the first layouts at a width may still grow Text's buffers
+    // (rewrapping alternates between two line tables)
+    for (int i = 0; i != k_relayout_count; ++i) f(i);
+
+    auto allocations_before = s_allocation_count;
+    auto start = Clock::now();
+    for (int i = 0; i != k_relayout_count; ++i) f(i);
+    double ms = milliseconds_since(start);
+    auto allocations = s_allocation_count - allocations_before;
+    std::cout << what << ": " << (ms / k_relayout_count) << "ms per layout, "
+              << (double(allocations) / k_relayout_count)
+              << " allocations per layout" << std::endl;
+}
+
+} // end of <anonymous> namespace
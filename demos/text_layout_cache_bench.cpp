@@ -0,0 +1,93 @@
+#include <ksg/Text.hpp>
+#include <ksg/TextLayoutCache.hpp>
+
+#include <SFML/Graphics/Font.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ksg;
+
+namespace {
+
+using UString = Text::UString;
+using Clock   = std::chrono::steady_clock;
+
+constexpr const std::size_t k_text_count = 5000;
+
+// labels repeat, as file names with " (directory)" and button labels do
+std::vector<UString> make_labels();
+
+double milliseconds_since(Clock::time_point);
+
+void report(const char * what, const sf::Font &, const std::vector<UString> &);
+
+} // end of <anonymous> namespace
+
+int main() {
+    sf::Font font;
+    if (!font.loadFromFile("demos/font.ttf") && !font.loadFromFile("font.ttf")) {
+        std::cerr << "Cannot load font.ttf (run from the repository's root, "
+                     "or the demos directory)." << std::endl;
+        return 1;
+    }
+    const auto labels = make_labels();
+    // glyphs are rasterized by the font on first use, that is not the text's
+    for (const auto & label : labels) Text::measure_text(font, 14, label);
+
+    auto & cache = TextLayoutCache::instance();
+    cache.set_byte_limit(0);
+    report("without cache", font, labels);
+
+    cache.set_byte_limit(TextLayoutCache::k_suggested_byte_limit);
+    cache.reset_event_counters();
+    report("with cache", font, labels);
+    auto counters = cache.counters();
+    std::cout << "hits: " << counters.hit_count << ", misses: "
+              << counters.miss_count << ", entries: " << counters.entry_count
+              << ", cached bytes: " << counters.byte_count << std::endl;
+    cache.forget_font(&font);
+}
+
+namespace {
+
+std::vector<UString> make_labels() {
+    static const char * const k_names[] = {
+        "Apply", "Cancel", "OK", "Back", "Options", "Resume", "Quit",
+        "Save", "Load", "Delete", "Rename", "Refresh"
+    };
+    std::vector<UString> rv;
+    rv.reserve(k_text_count);
+    for (std::size_t i = 0; i != k_text_count; ++i) {
+        UString label;
+        for (const char * c = k_names[i % (sizeof(k_names) / sizeof(k_names[0]))]; *c; ++c)
+            label += UString::value_type(*c);
+        if (i % 3 == 0) label += U" (directory)";
+        rv.push_back(label);
+    }
+    return rv;
+}
+
+double milliseconds_since(Clock::time_point start) {
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void report(const char * what, const sf::Font & font,
+            const std::vector<UString> & labels)
+{
+    std::vector<Text> texts(labels.size());
+    auto start = Clock::now();
+    for (std::size_t i = 0; i != labels.size(); ++i) {
+        texts[i].assign_font(&font);
+        texts[i].set_character_size(14);
+        texts[i].set_location(0.f, float(i)*20.f);
+        texts[i].set_string(labels[i]);
+    }
+    std::cout << what << ": " << milliseconds_since(start) << "ms to lay out "
+              << labels.size() << " labels" << std::endl;
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,107 @@
+#include <ksg/Text.hpp>
+
+#include <SFML/Graphics/Font.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace ksg;
+
+namespace {
+
+using UString = Text::UString;
+using Clock   = std::chrono::steady_clock;
+
+constexpr const std::size_t k_character_count = 1000000;
+
+// every allocation is prefixed by its size, so that live bytes may be
+// tracked
+constexpr const std::size_t k_header_size = alignof(std::max_align_t);
+std::size_t s_live_bytes = 0;
+
+UString make_string();
+
+double milliseconds_since(Clock::time_point);
+
+} // end of <anonymous> namespace
+
+void * operator new(std::size_t size) {
+    auto * ptr = static_cast<unsigned char *>(std::malloc(size + k_header_size));
+    if (!ptr) throw std::bad_alloc();
+    *reinterpret_cast<std::size_t *>(ptr) = size;
+    s_live_bytes += size;
+    return ptr + k_header_size;
+}
+
+void operator delete(void * ptr) noexcept {
+    if (!ptr) return;
+    auto * block = static_cast<unsigned char *>(ptr) - k_header_size;
+    s_live_bytes -= *reinterpret_cast<std::size_t *>(block);
+    std::free(block);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept { operator delete(ptr); }
+
+int main() {
+    sf::Font font;
+    if (!font.loadFromFile("demos/font.ttf") && !font.loadFromFile("font.ttf")) {
+        std::cerr << "Cannot load font.ttf (run from the repository's root, "
+                     "or the demos directory)." << std::endl;
+        return 1;
+    }
+    // glyphs are rasterized by the font on first use, that is not the text's
+    Text::measure_text(font, 14, make_string().substr(0, 256));
+
+    UString str = make_string();
+    Text text;
+    text.assign_font(&font);
+    text.set_character_size(14);
+    text.set_limiting_dimensions(1200.f, Text::k_inf);
+
+    const auto bytes_before = s_live_bytes;
+    auto start = Clock::now();
+    text.set_string(std::move(str));
+    double layout_ms = milliseconds_since(start);
+    // the string's memory is not counted, only what layout adds to it
+    const auto bytes = s_live_bytes - bytes_before;
+
+    start = Clock::now();
+    text.set_limiting_dimensions(900.f, Text::k_inf);
+    double rewrap_ms = milliseconds_since(start);
+
+    std::cout << k_character_count << " characters, " << text.line_count()
+              << " lines\n"
+              << "layout: " << layout_ms << "ms, rewrap: " << rewrap_ms << "ms\n"
+              << "memory: " << bytes << " bytes ("
+              << (double(bytes) / double(k_character_count))
+              << " bytes per character)" << std::endl;
+}
+
+namespace {
+
+UString make_string() {
+    static const char * const k_words[] = {
+        "lorem", "ipsum", "dolor", "sit", "amet,", "consectetur",
+        "adipiscing", "elit.", "Sed", "do", "eiusmod", "tempor"
+    };
+    static constexpr const std::size_t k_word_count = sizeof(k_words) / sizeof(k_words[0]);
+    UString rv;
+    rv.reserve(k_character_count);
+    for (std::size_t i = 0; rv.size() < k_character_count; ++i) {
+        for (const char * c = k_words[i % k_word_count]; *c; ++c)
+            rv += UString::value_type(*c);
+        rv += (i % 40 == 39) ? U'\n' : U' ';
+    }
+    rv.resize(k_character_count);
+    return rv;
+}
+
+double milliseconds_since(Clock::time_point start) {
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // end of <anonymous> namespace
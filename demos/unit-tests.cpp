@@ -0,0 +1,1462 @@
+#include <ksg/TextureBudget.hpp>
+#include <ksg/GlyphAtlas.hpp>
+#include <ksg/Text.hpp>
+#include <ksg/PieceTable.hpp>
+#include <ksg/TextLayoutCache.hpp>
+#include <ksg/QuadKernels.hpp>
+#include <ksg/TextMarkup.hpp>
+#include <ksg/FontRegistry.hpp>
+#include <ksg/Utf8.hpp>
+#include <ksg/Frame.hpp>
+#include <ksg/TextButton.hpp>
+#include <ksg/TextArea.hpp>
+#include <ksg/GlyphPrewarmer.hpp>
+#include <ksg/EditableText.hpp>
+#include <ksg/LogArea.hpp>
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/Graphics/View.hpp>
+#include <SFML/Window/Event.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// unlike assert, checks are made in release builds too
+#define MACRO_CHECK(expr) check(expr, #expr, __LINE__)
+
+namespace {
+
+using TextureBudget   = ksg::TextureBudget;
+using BudgetedTexture = ksg::detail::BudgetedTexture;
+using UString         = ksg::Text::UString;
+using VectorF         = ksg::Text::VectorF;
+
+// without a monospaced font given, the first of these found is used
+constexpr const char * const k_monospaced_fonts[] = {
+    "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+    "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+    "/usr/share/fonts/dejavu/DejaVuSansMono.ttf",
+    "/Library/Fonts/Courier New.ttf",
+    "C:/Windows/Fonts/consola.ttf"
+};
+
+void check(bool, const char * expression, int line);
+
+void test_texture_budget();
+
+// a frame's characters, at each of its sizes, are in the font's glyph
+// cache once prewarmed
+void test_glyph_prewarmer(const sf::Font &);
+
+void test_distance_field_metrics(const sf::Font &);
+
+// a square's field, against distances worked out by hand
+void test_distance_field_generator();
+
+// monospaced fonts (with or without the hint) must lay out exactly as any
+// other font would
+void test_monospace_layout(const sf::Font &);
+
+// random edits, undos and redos, checked against a plain string
+void test_piece_table();
+
+// changing only the width rewraps the old layout, this must place every
+// character as laying out anew does
+void test_rewrap(const sf::Font &);
+
+// every kernel this processor supports must give exactly the scalar
+// kernel's quads
+void test_quad_kernels();
+
+void test_markup(const sf::Font &);
+
+// points to character indices to offsets and back, across wrapped lines,
+// and prefixes which end exactly on glyph boundaries
+void test_character_queries(const sf::Font &);
+
+// random inserts and erases must leave the text laid out exactly as laying
+// out the edited string anew does
+void test_incremental_edits(const sf::Font &);
+
+// malformed sequences of every kind, and ASCII runs around the length
+// checked at once
+void test_utf8();
+
+// a font of another family, made where a destroyed font was, must not be
+// given layouts cached for the old font
+void test_layout_cache_font_reuse
+    (const std::string & filename, const std::string & other_filename);
+
+// a cached frame is redrawn after a widget changes or the mouse hovers onto
+// another widget, and not otherwise
+void test_frame_render_cache(const sf::Font &);
+
+// typing (with the key presses and releases around each character) is one
+// edit, and text typed before a click goes where the cursor was
+void test_held_text_events(const sf::Font &);
+
+// edits for typing, backspace, delete and bursts; rejected edits change
+// nothing, and the character filter sees the string an edit would produce
+void test_edit_filters(const sf::Font &);
+
+// scrolling within the laid out margin lays out no lines, scrolling past it
+// lays out only lines new to the window, offsets are clamped to the content
+void test_virtual_lines(const sf::Font &);
+
+// clipped views against viewports worked out by hand
+void test_clip_view_vertically();
+
+// the ring evicts the oldest lines, resizing keeps the newest, and a view
+// scrolled back stays on its lines as new ones arrive
+void test_log_area(const sf::Font &);
+
+// counters for hits and misses, strings are inserted only on their second
+// miss, and evicted least recently used first over the byte limit
+void test_layout_cache(const sf::Font &);
+
+} // end of <anonymous> namespace
+
+// usage: unit-tests [monospaced font file]
+int main(int argc, char ** argv) {
+    std::string font_filename = "demos/font.ttf";
+    sf::Font font;
+    if (!font.loadFromFile(font_filename)) font_filename = "font.ttf";
+    if (!font.loadFromFile(font_filename)) {
+        std::cerr << "Cannot load font.ttf (run from the repository's root, "
+                     "or the demos directory)." << std::endl;
+        return 1;
+    }
+    sf::Font monospaced_font;
+    std::string monospaced_filename;
+    if (argc > 1) {
+        if (monospaced_font.loadFromFile(argv[1])) monospaced_filename = argv[1];
+    } else {
+        for (const char * filename : k_monospaced_fonts) {
+            if (!monospaced_font.loadFromFile(filename)) continue;
+            monospaced_filename = filename;
+            break;
+        }
+    }
+    const bool has_monospaced_font = !monospaced_filename.empty();
+    try {
+        test_texture_budget();
+        test_piece_table();
+        test_quad_kernels();
+        test_utf8();
+        test_glyph_prewarmer(font);
+        test_distance_field_generator();
+        test_distance_field_metrics(font);
+        test_monospace_layout(font);
+        test_rewrap(font);
+        test_markup(font);
+        test_character_queries(font);
+        test_incremental_edits(font);
+        test_frame_render_cache(font);
+        test_held_text_events(font);
+        test_edit_filters(font);
+        test_virtual_lines(font);
+        test_clip_view_vertically();
+        test_log_area(font);
+        test_layout_cache(font);
+        ksg::Text::run_tests();
+        // (serial and parallel layouts from glyph metric snapshots)
+        ksg::Text::run_tests(font);
+        if (has_monospaced_font) {
+            test_monospace_layout(monospaced_font);
+            ksg::Text::run_tests(monospaced_font);
+            test_layout_cache_font_reuse(font_filename, monospaced_filename);
+        } else {
+            std::cout << "No monospaced font found, the monospace layout "
+                         "test was run only with a proportional font, and "
+                         "the layout cache's font reuse test was skipped." << std::endl;
+        }
+    } catch (std::exception & exp) {
+        std::cout << exp.what() << std::endl;
+        return 1;
+    }
+    std::cout << "All tests passed." << std::endl;
+    return 0;
+}
+
+namespace {
+
+void check(bool b, const char * expression, int line) {
+    if (b) return;
+    throw std::runtime_error("Check failed (line " + std::to_string(line)
+                             + "): " + expression);
+}
+
+void test_texture_budget() {
+    auto atlas = std::make_shared<sf::Image>();
+    atlas->create(16, 16, sf::Color::White);
+    // textures span the whole atlas, so each is 16*16*4 bytes
+    static constexpr const std::size_t k_texture_bytes = 16*16*4;
+
+    auto & budget = TextureBudget::instance();
+    budget.set_byte_limit(TextureBudget::k_no_limit);
+    budget.reset_event_counters();
+    const auto resident_before = budget.counters().resident_count;
+
+    BudgetedTexture a(atlas, sf::IntRect()), b(atlas, sf::IntRect()),
+                    c(atlas, sf::IntRect());
+    MACRO_CHECK(a.acquire() && b.acquire());
+    // a is now the most recently used, and b the least
+    MACRO_CHECK(a.acquire());
+    MACRO_CHECK(budget.counters().resident_count == resident_before + 2);
+
+    // room for just the two
+    budget.set_byte_limit(budget.counters().resident_bytes);
+    MACRO_CHECK(budget.counters().eviction_count == 0);
+    MACRO_CHECK(c.acquire());
+    MACRO_CHECK(!b.is_resident());
+    MACRO_CHECK(a.is_resident() && c.is_resident());
+    MACRO_CHECK(b.texture().getSize() == sf::Vector2u());
+    MACRO_CHECK(budget.counters().eviction_count == 1);
+    MACRO_CHECK(budget.counters().reload_count   == 0);
+    MACRO_CHECK(budget.counters().resident_count == resident_before + 2);
+    MACRO_CHECK(c.byte_size() == k_texture_bytes);
+
+    // drawing b again reloads it, evicting a (now least recently used)
+    MACRO_CHECK(b.acquire());
+    MACRO_CHECK(b.is_resident() && b.texture().getSize() == sf::Vector2u(16, 16));
+    MACRO_CHECK(!a.is_resident() && c.is_resident());
+    MACRO_CHECK(budget.counters().reload_count   == 1);
+    MACRO_CHECK(budget.counters().eviction_count == 2);
+
+    // a texture without a source can never be made resident
+    BudgetedTexture empty;
+    MACRO_CHECK(!empty.acquire());
+
+    budget.set_byte_limit(TextureBudget::k_no_limit);
+    budget.reset_event_counters();
+}
+
+void test_distance_field_generator() {
+    using ksg::detail::make_distance_field;
+    static constexpr const int k_width  = 10;
+    static constexpr const int k_height = 10;
+    static constexpr const int k_spread =  4;
+    static constexpr const int k_field_width = k_width + k_spread*2;
+    // a four by four square, from (3, 3) to (6, 6)
+    auto is_inside = [](int x, int y)
+        { return x >= 3 && x <= 6 && y >= 3 && y <= 6; };
+    std::vector<sf::Uint8> pixels(std::size_t(k_width*k_height)*4, 255);
+    for (int y = 0; y != k_height; ++y) {
+        for (int x = 0; x != k_width; ++x)
+            pixels[std::size_t(y*k_width + x)*4 + 3] = is_inside(x, y) ? 255 : 0;
+    }
+    std::vector<sf::Uint8> field;
+    make_distance_field(pixels, k_width, k_height, k_spread, field);
+    MACRO_CHECK(field.size() == std::size_t(k_field_width*k_field_width)*4);
+    // glyph coordinates
+    auto alpha_at = [&field](int x, int y) {
+        return int(field[std::size_t((y + k_spread)*k_field_width + x + k_spread)*4 + 3]);
+    };
+
+    for (int y = -k_spread; y != k_height + k_spread; ++y) {
+        for (int x = -k_spread; x != k_width + k_spread; ++x) {
+            const auto * texel = &field[std::size_t((y + k_spread)*k_field_width + x + k_spread)*4];
+            MACRO_CHECK(texel[0] == 255 && texel[1] == 255 && texel[2] == 255);
+            // the edge is at one half
+            MACRO_CHECK((alpha_at(x, y) > 127) == is_inside(x, y));
+            // symmetric, as the square is
+            MACRO_CHECK(alpha_at(x, y) == alpha_at(9 - x, y));
+            MACRO_CHECK(alpha_at(x, y) == alpha_at(x, 9 - y));
+        }
+    }
+    // 0.5 + distance / (spread*2), where distance is to the nearest pixel
+    // on the other side of the edge
+    MACRO_CHECK(alpha_at(4, 4) == 191); // two pixels in
+    MACRO_CHECK(alpha_at(3, 4) == 159); // one pixel in
+    MACRO_CHECK(alpha_at(2, 4) ==  96); // one pixel out
+    MACRO_CHECK(alpha_at(1, 4) ==  64); // two pixels out
+    // beyond the spread
+    MACRO_CHECK(alpha_at(-1, 4) == 0);
+    MACRO_CHECK(alpha_at(-k_spread, -k_spread) == 0);
+    // falls away from the glyph
+    for (int x = -k_spread; x != 4; ++x)
+        MACRO_CHECK(alpha_at(x, 4) <= alpha_at(x + 1, 4));
+
+    // no coverage at all gives no field
+    std::fill(pixels.begin(), pixels.end(), sf::Uint8(0));
+    make_distance_field(pixels, k_width, k_height, k_spread, field);
+    for (std::size_t i = 3; i < field.size(); i += 4) MACRO_CHECK(field[i] == 0);
+}
+
+void test_distance_field_metrics(const sf::Font & font) {
+    using GlyphAtlas = ksg::GlyphAtlas;
+    static constexpr const auto k_reference_size =
+        GlyphAtlas::k_distance_field_reference_size;
+    GlyphAtlas atlas(GlyphAtlas::Mode::k_distance_field);
+    for (unsigned size : { 12u, 30u, 100u }) {
+        for (char32_t c : U"Ag ") {
+            if (!c) continue;
+            const auto & entry     = atlas.glyph(font, size, c).glyph;
+            const auto & reference = atlas.glyph(font, k_reference_size, c);
+            const float scale = float(size) / float(k_reference_size);
+            // metrics are scaled from the one rasterized size
+            MACRO_CHECK(entry.advance       == reference.glyph.advance*scale);
+            MACRO_CHECK(entry.bounds.left   == reference.glyph.bounds.left*scale);
+            MACRO_CHECK(entry.bounds.top    == reference.glyph.bounds.top*scale);
+            MACRO_CHECK(entry.bounds.width  == reference.glyph.bounds.width*scale);
+            MACRO_CHECK(entry.bounds.height == reference.glyph.bounds.height*scale);
+            MACRO_CHECK(entry.textureRect   == reference.glyph.textureRect);
+            MACRO_CHECK(atlas.glyph(font, size, c).page == reference.page);
+        }
+    }
+}
+
+void test_monospace_layout(const sf::Font & font) {
+    // Text's widths are exact for monospaced fonts up to this, past it every
+    // advance is summed
+    static constexpr const float k_exact_limit = float(1 << 18);
+
+    for (int size : { 12, 17 }) {
+        const float advance = font.getGlyph(U'a', unsigned(size), false).advance;
+        // one chunk which measures past the limit
+        UString long_chunk(std::size_t(k_exact_limit / advance) + 5, U'a');
+        long_chunk += U" b";
+        for (const UString & str : { UString(U"int main() { return x->y[0] ~ 1; }"),
+                                     long_chunk })
+        {
+        // pen positions, as summed one character at a time
+        std::vector<float> offsets = { 0.f };
+        for (std::size_t i = 0; i != str.size(); ++i) {
+            float x = offsets.back() + font.getGlyph(str[i], unsigned(size), false).advance;
+            if (i + 1 != str.size())
+                { x += font.getKerning(str[i], str[i + 1], unsigned(size)); }
+            offsets.push_back(x);
+        }
+        for (bool hint : { false, true }) {
+            ksg::Text text;
+            text.assign_font(&font);
+            text.set_character_size(size);
+            text.set_monospace_hint(hint);
+            text.set_string(str);
+            for (std::size_t i = 0; i != str.size(); ++i) {
+                MACRO_CHECK(text.character_offset(int(i)) == offsets[i]);
+            }
+            MACRO_CHECK(text.character_offset(int(str.size())) == offsets.back());
+            MACRO_CHECK(text.measure_width(str.begin(), str.end()) == offsets.back());
+            MACRO_CHECK(ksg::Text::measure_width(font, size, str.begin(), str.end())
+                        == offsets.back());
+        }
+        }
+    }
+}
+
+void test_piece_table() {
+    using PieceTable = ksg::PieceTable;
+    // the reference's line starts, and which line each position is on
+    auto check_lines = [](const PieceTable & table, const UString & reference) {
+        MACRO_CHECK(table.size() == reference.size());
+        MACRO_CHECK(table.to_string() == reference);
+        int line = 0;
+        std::size_t line_start = 0;
+        for (std::size_t i = 0; i != reference.size() + 1; ++i) {
+            MACRO_CHECK(table.line_of(i) == line);
+            if (i == line_start) {
+                MACRO_CHECK(table.line_start(line) == line_start);
+            }
+            if (i != reference.size() && reference[i] == U'\n') {
+                MACRO_CHECK(table.line_end(line) == i);
+                ++line;
+                line_start = i + 1;
+            }
+        }
+        MACRO_CHECK(table.line_count() == line + 1);
+        MACRO_CHECK(table.line_end(line) == reference.size());
+    };
+
+    std::mt19937 rng(1234);
+    auto random_below = [&rng](std::size_t n)
+        { return std::uniform_int_distribution<std::size_t>(0, n - 1)(rng); };
+    auto random_text = [&random_below]() {
+        static constexpr const char32_t k_characters[] = U"ab \n\u00E9";
+        UString rv(random_below(6) + 1, U' ');
+        for (auto & c : rv) c = k_characters[random_below(5)];
+        return rv;
+    };
+
+    for (const UString & original : { UString(), UString(U"one\ntwo\n\nthree") }) {
+    PieceTable table(original);
+    // each state of the document, the last being the current one
+    std::vector<UString> history = { original };
+    // edits which made each state (after the first), typing is merged
+    // into one record as the piece table does
+    struct Record { bool is_insertion; std::size_t position; UString text; };
+    std::vector<Record> records;
+    // states (and their records) undone, which redo goes back to
+    std::vector<UString> undone;
+    std::vector<Record> undone_records;
+    for (int i = 0; i != 2000; ++i) {
+        const auto current  = history.back();
+        const auto position = random_below(current.size() + 1);
+        switch (random_below(5)) {
+        case 0: case 1: {
+            auto text = random_text();
+            table.insert(position, text);
+            auto next = UString(current).insert(position, text);
+            undone.clear();
+            undone_records.clear();
+            if (   !records.empty() && records.back().is_insertion
+                && records.back().text.back() != U'\n'
+                && records.back().position + records.back().text.size() == position)
+            {
+                records.back().text += text;
+                history.back() = next;
+            } else {
+                records.push_back(Record { true, position, text });
+                history.push_back(next);
+            }
+            } break;
+        case 2: {
+            const auto count = random_below(8);
+            if (position == current.size() || count == 0) break;
+            table.erase(position, count);
+            records.push_back(Record { false, position, UString() });
+            history.push_back(UString(current).erase(position, count));
+            undone.clear();
+            undone_records.clear();
+            } break;
+        case 3:
+            MACRO_CHECK(table.undo() == !records.empty());
+            if (!records.empty()) {
+                undone.push_back(history.back());
+                undone_records.push_back(records.back());
+                history.pop_back();
+                records.pop_back();
+            }
+            break;
+        case 4:
+            MACRO_CHECK(table.redo() == !undone.empty());
+            if (!undone.empty()) {
+                history.push_back(undone.back());
+                records.push_back(undone_records.back());
+                undone.pop_back();
+                undone_records.pop_back();
+            }
+            break;
+        }
+        if (i == 1000) {
+            table.clear_history();
+            MACRO_CHECK(!table.can_undo() && !table.can_redo());
+            history = { history.back() };
+            records.clear();
+            undone.clear();
+            undone_records.clear();
+        }
+        MACRO_CHECK(table.substring(position / 2, 7) ==
+                    history.back().substr(std::min(position / 2, history.back().size()), 7));
+        if (i % 50 == 0) check_lines(table, history.back());
+    }
+    check_lines(table, history.back());
+    // all the way back
+    while (table.undo()) {}
+    MACRO_CHECK(table.to_string() == history.front());
+    }
+}
+
+void test_rewrap(const sf::Font & font) {
+    // cached layouts would be shared, rather than laid out anew
+    auto & cache = ksg::TextLayoutCache::instance();
+    const auto old_limit = cache.byte_limit();
+    cache.set_byte_limit(0);
+
+    UString paragraph;
+    for (int i = 0; i != 40; ++i) {
+        paragraph += U"lorem ipsum dolor sit ";
+        if (i % 7 == 6) paragraph += U"\n";
+        if (i % 13 == 12) paragraph += U"\n\n\n";
+        if (i % 11 == 10) paragraph += U"averyveryverylongwordwhichfitsnowhere ";
+    }
+    const UString strings[] = {
+        paragraph, U"\n\nstarts with newlines", U"ends with newlines\n\n",
+        U"a \n b \n\n c  d", U"single"
+    };
+    // shrinking, growing, narrower than any character, and unlimited
+    const float widths[] = { 400.f, 250.f, 120.f, 60.f, 3.f, 90.f, 700.f,
+                             std::numeric_limits<float>::infinity(), 150.f };
+    auto check_rewraps = [&font, &widths](const UString & str, int size,
+                                          ksg::GlyphAtlas * atlas)
+    {
+        ksg::Text rewrapped;
+        rewrapped.assign_font(&font);
+        rewrapped.assign_glyph_atlas(atlas);
+        rewrapped.set_character_size(size);
+        rewrapped.set_limiting_width(widths[0]);
+        rewrapped.set_string(str);
+        for (float width : widths) {
+            rewrapped.set_limiting_width(width);
+
+            ksg::Text fresh;
+            fresh.assign_font(&font);
+            fresh.assign_glyph_atlas(atlas);
+            fresh.set_character_size(size);
+            fresh.set_limiting_width(width);
+            fresh.set_string(str);
+
+            MACRO_CHECK(rewrapped.line_count() == fresh.line_count());
+            MACRO_CHECK(rewrapped.width () == fresh.width ());
+            MACRO_CHECK(rewrapped.height() == fresh.height());
+            for (int i = 0; i != int(str.size()) + 1; ++i) {
+                MACRO_CHECK(rewrapped.character_location(i) == fresh.character_location(i));
+            }
+        }
+    };
+    for (const auto & str : strings) check_rewraps(str, 14, nullptr);
+    // distance field advances are scaled, and so are not multiples of 1/64th
+    ksg::GlyphAtlas atlas(ksg::GlyphAtlas::Mode::k_distance_field);
+    for (int size = 11; size != 24; ++size) check_rewraps(paragraph, size, &atlas);
+    cache.set_byte_limit(old_limit);
+}
+
+void test_quad_kernels() {
+    using namespace ksg::detail;
+    static constexpr const float k_inf = std::numeric_limits<float>::infinity();
+    // glyphs are placed in a row, each 8 by 12 pixels, a pixel apart
+    static constexpr const float k_width = 8.f, k_height = 12.f, k_step = 9.f;
+    static constexpr const float k_top = 10.f;
+
+    auto make_clip = [](float bottom, float right, float view_left, float view_right) {
+        QuadClip clip;
+        clip.bottom     = bottom;
+        clip.right      = right;
+        clip.view_left  = view_left;
+        clip.view_right = view_right;
+        clip.offset     = sf::Vector2f(3.5f, -2.f);
+        return clip;
+    };
+    const QuadClip clips[] = {
+        // wholly visible
+        make_clip(k_inf, k_inf, -k_inf, k_inf),
+        // cut on the bottom, and by the limiting width
+        make_clip(k_top + k_height / 2.f, k_inf, -k_inf, k_inf),
+        make_clip(k_inf, k_step*5.f + k_width / 2.f, -k_inf, k_inf),
+        // cut by the viewport's left and right edges
+        make_clip(k_inf, k_inf, k_step*2.f + 1.25f, k_inf),
+        make_clip(k_inf, k_inf, -k_inf, k_step*6.f + 2.75f),
+        make_clip(k_top + 3.f, k_step*20.f + 5.f, k_step*3.f + 0.5f, k_step*11.f + 7.f),
+        // wholly clipped away
+        make_clip(k_top, k_inf, -k_inf, k_inf),
+        make_clip(k_inf, 0.f, -k_inf, k_inf),
+        make_clip(k_inf, k_inf, k_step*GlyphRun::k_capacity, k_inf)
+    };
+    auto is_same_vertex = [](const sf::Vertex & lhs, const sf::Vertex & rhs) {
+        return lhs.position == rhs.position && lhs.texCoords == rhs.texCoords &&
+               lhs.color == rhs.color;
+    };
+    for (auto kernel : { QuadKernel::k_sse2, QuadKernel::k_avx2 }) {
+        if (!is_quad_kernel_supported(kernel)) continue;
+        // lengths not a multiple of either vector width, and ones that are
+        for (std::size_t length : { 1, 3, 4, 5, 7, 8, 9, 13, 16, 17, 31, 33, 63, 64 }) {
+            GlyphRun run;
+            for (std::size_t i = 0; i != length; ++i) {
+                const auto shade = sf::Uint8(i*4);
+                run.push(float(i)*k_step, k_top + float(i % 3)*0.25f, k_width, k_height,
+                         float(i)*k_width, 0.f, k_width, k_height,
+                         sf::Color(shade, 255, sf::Uint8(255 - shade)));
+            }
+            for (const auto & clip : clips) {
+                std::vector<sf::Vertex> expected(length*4), result(length*4);
+                const auto expected_count =
+                    make_clipped_quads(QuadKernel::k_scalar, run, clip, expected.data());
+                const auto count = make_clipped_quads(kernel, run, clip, result.data());
+                MACRO_CHECK(count == expected_count);
+                for (std::size_t i = 0; i != count*4; ++i) {
+                    MACRO_CHECK(is_same_vertex(result[i], expected[i]));
+                }
+            }
+        }
+    }
+}
+
+void test_markup(const sf::Font & font) {
+    using ksg::detail::compile_markup;
+    using ksg::detail::escape_markup;
+    ksg::StyleMap named_styles;
+    named_styles["accent"] = ksg::StylesField(sf::Color::Blue);
+    named_styles["mono"  ] = ksg::StylesField(&font);
+
+    // colors nest, and sizes and fonts nest within and across each other
+    {
+    auto compiled = compile_markup(
+        U"[color=#ff0000]a[size=20]b[color=accent]c[/color]d[/size][/color]e",
+        named_styles);
+    MACRO_CHECK(compiled.string == U"abcde");
+    const auto & spans = compiled.color_spans;
+    MACRO_CHECK(spans.size() == 3);
+    MACRO_CHECK(spans[0].begin == 0 && spans[0].end == 2 && spans[0].color == sf::Color::Red);
+    MACRO_CHECK(spans[1].begin == 2 && spans[1].end == 3 && spans[1].color == sf::Color::Blue);
+    MACRO_CHECK(spans[2].begin == 3 && spans[2].end == 4 && spans[2].color == sf::Color::Red);
+    MACRO_CHECK(compiled.styles.size() == 1 && compiled.styles[0].char_size == 20);
+    MACRO_CHECK(compiled.style_runs.size() == 1);
+    MACRO_CHECK(compiled.style_runs[0].begin == 1 && compiled.style_runs[0].end == 4);
+    }
+    {
+    auto compiled = compile_markup(U"[font=mono]x[size=9]y[/font]z[/size]w", named_styles);
+    MACRO_CHECK(compiled.string == U"xyzw");
+    MACRO_CHECK(compiled.color_spans.empty());
+    const auto & styles = compiled.styles;
+    MACRO_CHECK(styles.size() == 3);
+    MACRO_CHECK(styles[0].font == &font   && styles[0].char_size < 1);
+    MACRO_CHECK(styles[1].font == &font   && styles[1].char_size == 9);
+    MACRO_CHECK(styles[2].font == nullptr && styles[2].char_size == 9);
+    const auto & runs = compiled.style_runs;
+    MACRO_CHECK(runs.size() == 3);
+    for (int i = 0; i != 3; ++i) {
+        MACRO_CHECK(runs[std::size_t(i)].begin == i && runs[std::size_t(i)].end == i + 1);
+        MACRO_CHECK(runs[std::size_t(i)].style == i + 1);
+    }
+    }
+
+    // escaped strings compile to themselves, without any spans or runs
+    for (const UString & str : { UString(U"[color=#ff0000]a[/color]"), UString(U"[[["),
+                                 UString(U"]"), UString(U"a[b]c["), UString() })
+    {
+        auto compiled = compile_markup(escape_markup(str), named_styles);
+        MACRO_CHECK(compiled.string == str);
+        MACRO_CHECK(compiled.color_spans.empty() && compiled.style_runs.empty());
+    }
+
+    // error messages end with where in the markup the error is
+    auto error_of = [&named_styles](const UString & markup) {
+        try {
+            (void)compile_markup(markup, named_styles);
+        } catch (std::invalid_argument & exp) {
+            return std::string(exp.what());
+        }
+        return std::string();
+    };
+    auto ends_with = [](const std::string & str, const std::string & suffix) {
+        return str.size() >= suffix.size() &&
+               str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    // unknown names, and names of the other kind
+    MACRO_CHECK(ends_with(error_of(U"ab[color=nope]c"), "at index 2 of the markup."));
+    MACRO_CHECK(ends_with(error_of(U"[font=nope]c"   ), "at index 0 of the markup."));
+    MACRO_CHECK(ends_with(error_of(U"[font=accent]c" ), "at index 0 of the markup."));
+    MACRO_CHECK(ends_with(error_of(U"[color=mono]c"  ), "at index 0 of the markup."));
+    MACRO_CHECK(ends_with(error_of(U"a[bold]c"       ), "at index 1 of the markup."));
+    MACRO_CHECK(ends_with(error_of(U"a[weight=9]c"   ), "at index 1 of the markup."));
+    // unterminated tags, and closing tags which were never opened
+    MACRO_CHECK(ends_with(error_of(U"abc[color=#ff0000"), "at index 3 of the markup."));
+    MACRO_CHECK(ends_with(error_of(U"a[[b["            ), "at index 4 of the markup."));
+    MACRO_CHECK(ends_with(error_of(U"["                ), "at index 0 of the markup."));
+    MACRO_CHECK(ends_with(error_of(U"x[/size]"         ), "at index 1 of the markup."));
+    // tags may be left open
+    MACRO_CHECK(error_of(U"[color=accent][size=3]open").empty());
+}
+
+void test_layout_cache_font_reuse
+    (const std::string & filename, const std::string & other_filename)
+{
+    auto & cache = ksg::TextLayoutCache::instance();
+    const auto old_limit = cache.byte_limit();
+    cache.clear();
+    cache.set_byte_limit(ksg::TextLayoutCache::k_suggested_byte_limit);
+    cache.reset_event_counters();
+    auto lay_out = [](const sf::Font & font) {
+        ksg::Text text;
+        text.assign_font(&font);
+        text.set_character_size(14);
+        text.set_string(U"Options");
+    };
+
+    // fonts are made one after the other, at the same address
+    alignas(sf::Font) unsigned char storage[sizeof(sf::Font)];
+    auto * font = new (storage) sf::Font();
+    MACRO_CHECK(font->loadFromFile(filename));
+    // cached the second time it is laid out, and found the third
+    for (int i = 0; i != 3; ++i) lay_out(*font);
+    MACRO_CHECK(cache.counters().hit_count == 1);
+    const auto family = font->getInfo().family;
+    font->~Font();
+
+    font = new (storage) sf::Font();
+    MACRO_CHECK(font->loadFromFile(other_filename));
+    MACRO_CHECK(font->getInfo().family != family);
+    const auto misses = cache.counters().miss_count;
+    lay_out(*font);
+    MACRO_CHECK(cache.counters().hit_count  == 1);
+    MACRO_CHECK(cache.counters().miss_count == misses + 1);
+
+    // forgetting a font with the registry drops layouts cached for any font
+    // at its address
+    for (int i = 0; i != 2; ++i) lay_out(*font);
+    MACRO_CHECK(cache.counters().entry_count == 2);
+    ksg::FontRegistry::instance().forget_font(font);
+    MACRO_CHECK(cache.counters().entry_count == 0);
+    font->~Font();
+
+    cache.clear();
+    cache.set_byte_limit(old_limit);
+    cache.reset_event_counters();
+}
+
+void test_utf8() {
+    using ksg::Utf8Errors;
+    using ksg::decode_utf8;
+    using ksg::find_invalid_utf8;
+    static constexpr const char32_t k_rep = ksg::k_replacement_character;
+    struct Case {
+        std::string utf8;
+        // decoded with replacements, each malformed sequence (the longest
+        // prefix which could have begun a valid one) is replaced once
+        UString replaced;
+        // where the first malformed sequence is, the size if there is none
+        std::size_t invalid_at;
+    };
+    const Case cases[] = {
+        // the first and last code points of each length
+        { "\xC2\x80\xDF\xBF", U"\u0080\u07FF", 4 },
+        { "\xE0\xA0\x80\xEF\xBF\xBF", U"\u0800\uFFFF", 6 },
+        { "\xF0\x90\x80\x80\xF4\x8F\xBF\xBF", U"\U00010000\U0010FFFF", 8 },
+        // around the surrogates
+        { "\xED\x9F\xBF\xEE\x80\x80", U"\uD7FF\uE000", 6 },
+        // overlong forms
+        { "\xE0\x80\x80", { k_rep, k_rep, k_rep }, 0 },
+        { "a\xE0\x9F\xBF", { U'a', k_rep, k_rep, k_rep }, 1 },
+        { "\xF0\x80\x80\x80", { k_rep, k_rep, k_rep, k_rep }, 0 },
+        { "\xF0\x8F\xBF\xBF", { k_rep, k_rep, k_rep, k_rep }, 0 },
+        { "\xC0\xAF\xC1\xBF", { k_rep, k_rep, k_rep, k_rep }, 0 },
+        // surrogates
+        { "ab\xED\xA0\x80", { U'a', U'b', k_rep, k_rep, k_rep }, 2 },
+        { "\xED\xBF\xBF", { k_rep, k_rep, k_rep }, 0 },
+        // past U+10FFFF
+        { "\xF4\x90\x80\x80", { k_rep, k_rep, k_rep, k_rep }, 0 },
+        { "\xF4\xBF\xBF\xBF", { k_rep, k_rep, k_rep, k_rep }, 0 },
+        { "\xF5\x80\x80\x80", { k_rep, k_rep, k_rep, k_rep }, 0 },
+        { "\xFE\xFF", { k_rep, k_rep }, 0 },
+        // truncated at the end of input, and by another character
+        { "\xC3", { k_rep }, 0 },
+        { "a\xE2\x82", { U'a', k_rep }, 1 },
+        { "abc\xF0\x9F\x98", { U'a', U'b', U'c', k_rep }, 3 },
+        { "\xE2\x82" "a", { k_rep, U'a' }, 0 },
+        { "\xF0\x9F\x98\xE2\x82\xAC", { k_rep, U'\u20AC' }, 0 },
+        // stray continuation bytes
+        { "\x80", { k_rep }, 0 },
+        { "a\xBF" "b", { U'a', k_rep, U'b' }, 1 },
+        { "\xC3\xA9\x80\x80", { U'\u00E9', k_rep, k_rep }, 2 },
+        // Unicode's own example of replacing maximal subparts
+        { "a\xF1\x80\x80\xE1\x80\xC2" "b\x80" "c\x80\xBF" "d",
+          { U'a', k_rep, k_rep, k_rep, U'b', k_rep, U'c', k_rep, k_rep, U'd' }, 1 }
+    };
+    // ASCII runs just short of, at, and past the sixteen bytes checked at
+    // once, followed by other sequences
+    std::vector<Case> all_cases(std::begin(cases), std::end(cases));
+    for (std::size_t length : { 15, 16, 17, 31, 32, 33 }) {
+        std::string ascii;
+        UString wide;
+        for (std::size_t i = 0; i != length; ++i) {
+            ascii += char('!' + i % 90);
+            wide  += char32_t('!' + i % 90);
+        }
+        all_cases.push_back(Case { ascii + "\xC3\xA9" + ascii, wide + U"\u00E9" + wide,
+                                   2*length + 2 });
+        all_cases.push_back(Case { ascii + "\xF0\x9F\x98\x80", wide + U"\U0001F600",
+                                   length + 4 });
+        all_cases.push_back(Case { ascii + "\xE0\x80" + ascii, wide + k_rep + k_rep + wide,
+                                   length });
+        all_cases.push_back(Case { ascii + "\xE2\x82", wide + k_rep, length });
+    }
+
+    UString reused;
+    for (const auto & case_ : all_cases) {
+        MACRO_CHECK(decode_utf8(case_.utf8, Utf8Errors::k_replace) == case_.replaced);
+        decode_utf8(case_.utf8, reused, Utf8Errors::k_replace);
+        MACRO_CHECK(reused == case_.replaced);
+        MACRO_CHECK(find_invalid_utf8(case_.utf8) == case_.invalid_at);
+
+        std::string error;
+        try {
+            reused = decode_utf8(case_.utf8);
+        } catch (std::invalid_argument & exp) {
+            error = exp.what();
+        }
+        if (case_.invalid_at == case_.utf8.size()) {
+            MACRO_CHECK(error.empty() && reused == case_.replaced);
+        } else {
+            MACRO_CHECK(error == "decode_utf8: malformed UTF-8 at byte " +
+                                 std::to_string(case_.invalid_at) + ".");
+        }
+    }
+}
+
+void test_frame_render_cache(const sf::Font & font) {
+    auto styles = ksg::styles::construct_system_styles();
+    styles[ksg::styles::k_global_font] = ksg::StylesField(&font);
+    ksg::SimpleFrame frame;
+    ksg::TextButton first, second;
+    first .set_string(U"First" );
+    second.set_string(U"Second");
+    frame.begin_adding_widgets(styles).add(first).add(second);
+    frame.set_render_caching(true);
+
+    sf::RenderTexture target;
+    if (!target.create(640, 480)) {
+        std::cout << "Cannot create a render texture, the frame render cache "
+                     "test was skipped." << std::endl;
+        return;
+    }
+    const auto & counters = frame.render_cache_counters();
+    auto draw_and_count_misses = [&target, &frame, &counters]() {
+        const auto misses = counters.miss_count;
+        target.draw(frame);
+        return counters.miss_count - misses;
+    };
+    auto move_mouse_to = [&frame](const ksg::Widget & widget) {
+        sf::Event event;
+        event.type = sf::Event::MouseMoved;
+        event.mouseMove.x = int(widget.location().x + widget.width () / 2.f);
+        event.mouseMove.y = int(widget.location().y + widget.height() / 2.f);
+        frame.process_event(event);
+    };
+
+    MACRO_CHECK(draw_and_count_misses() == 1);
+    if (counters.byte_count == 0) {
+        std::cout << "The frame could not be render cached, the frame render "
+                     "cache test was skipped." << std::endl;
+        return;
+    }
+    MACRO_CHECK(draw_and_count_misses() == 0);
+    MACRO_CHECK(draw_and_count_misses() == 0);
+
+    first.set_string(U"Changed");
+    MACRO_CHECK(draw_and_count_misses() == 1);
+    MACRO_CHECK(draw_and_count_misses() == 0);
+
+    move_mouse_to(second);
+    MACRO_CHECK(draw_and_count_misses() == 1);
+    // still over the same widget
+    move_mouse_to(second);
+    MACRO_CHECK(draw_and_count_misses() == 0);
+    move_mouse_to(first);
+    MACRO_CHECK(draw_and_count_misses() == 1);
+
+    // the texture sits on whole pixels, and covers every pixel the frame
+    // touches
+    frame.set_location(10.5f, 20.25f);
+    MACRO_CHECK(draw_and_count_misses() == 1);
+    const auto texture_width  = std::ceil(10.5f  + frame.width ()) - 10.f;
+    const auto texture_height = std::ceil(20.25f + frame.height()) - 20.f;
+    MACRO_CHECK(counters.byte_count
+                == std::size_t(texture_width)*std::size_t(texture_height)*4);
+    MACRO_CHECK(draw_and_count_misses() == 0);
+}
+
+void test_glyph_prewarmer(const sf::Font & font) {
+    static constexpr const int k_first_size  = 19;
+    static constexpr const int k_second_size = 27;
+    // nothing is laid out at this size
+    static constexpr const int k_digit_size  = 37;
+
+    auto styles = ksg::styles::construct_system_styles();
+    styles[ksg::styles::k_global_font] = ksg::StylesField(&font);
+    ksg::SimpleFrame frame;
+    ksg::TextArea first, second;
+    first .set_character_size(k_first_size );
+    second.set_character_size(k_second_size);
+    first .set_string(U"Prewarmed glyphs");
+    second.set_string(U"at another size!");
+    frame.begin_adding_widgets(styles).add(first).add(second);
+
+    ksg::GlyphPrewarmer prewarmer;
+    prewarmer.add(frame);
+    prewarmer.add(font, k_digit_size, ksg::glyph_sets::k_digits);
+    MACRO_CHECK(prewarmer.run() > 0);
+
+    auto page_pixels = [&font](int size) {
+        const auto image = font.getTexture(unsigned(size)).copyToImage();
+        const auto * pixels = image.getPixelsPtr();
+        return std::vector<sf::Uint8>
+            (pixels, pixels + std::size_t(image.getSize().x)*image.getSize().y*4);
+    };
+    // a glyph already in the cache is not rasterized again, and so leaves
+    // its page as it was
+    auto check_cached = [&font, &page_pixels](const UString & string, int size) {
+        const auto before = page_pixels(size);
+        for (auto c : string) (void)font.getGlyph(c, unsigned(size), false);
+        MACRO_CHECK(page_pixels(size) == before);
+    };
+    check_cached(first .string(), k_first_size );
+    check_cached(second.string(), k_second_size);
+    check_cached(ksg::glyph_sets::k_digits, k_digit_size);
+
+    const auto pages = prewarmer.report_pages();
+    MACRO_CHECK(pages.size() == 3);
+    for (int size : { k_first_size, k_second_size, k_digit_size }) {
+        auto itr = std::find_if(pages.begin(), pages.end(),
+            [size](const ksg::GlyphPrewarmer::PageReport & report)
+            { return report.character_size == size; });
+        MACRO_CHECK(itr != pages.end());
+        MACRO_CHECK(itr->font == &font);
+        const auto page_size = font.getTexture(unsigned(size)).getSize();
+        MACRO_CHECK(itr->width == page_size.x && itr->height == page_size.y);
+    }
+
+    // and one which is not prewarmed does change its page
+    const auto before = page_pixels(k_digit_size);
+    (void)font.getGlyph(U'Q', unsigned(k_digit_size), false);
+    MACRO_CHECK(page_pixels(k_digit_size) != before);
+}
+
+void test_character_queries(const sf::Font & font) {
+    ksg::Text text;
+    text.assign_font(&font);
+    text.set_character_size(14);
+    text.set_limiting_width(140.f);
+    text.set_location(13.f, 7.f);
+    text.set_string(U"Sphinx of black quartz, judge my vow.\n"
+                    U"Pack my box with five dozen liquor jugs.\n"
+                    U"How vexingly quick daft zebras jump!");
+    const int length = int(text.string().size());
+    MACRO_CHECK(text.line_count() > 4);
+
+    const auto top         = text.location().y;
+    const auto left        = text.location().x;
+    const auto line_height = text.line_height();
+    // each line's first and last cursor positions, offsets restart at each
+    // line
+    std::vector<int> firsts, lasts;
+    for (int i = 0; i != length; ++i) {
+        if (i != 0 && text.character_offset(i) != 0.f) continue;
+        if (i != 0) lasts.push_back(i - 1);
+        firsts.push_back(i);
+    }
+    lasts.push_back(length);
+    MACRO_CHECK(int(firsts.size()) == text.line_count());
+    auto line_middle = [top, line_height](std::size_t line)
+        { return top + (float(line) + 0.5f)*line_height; };
+
+    // index to point to index
+    for (std::size_t line = 0; line != firsts.size(); ++line) {
+        for (int i = firsts[line]; i <= lasts[line]; ++i) {
+            const float x = left + text.character_offset(i);
+            MACRO_CHECK(text.character_index_at(VectorF(x, line_middle(line))) == i);
+            if (i == lasts[line]) continue;
+            // nearer this boundary, and nearer the next
+            const float advance = text.character_offset(i + 1) - text.character_offset(i);
+            MACRO_CHECK(text.character_index_at(VectorF(x + advance*0.25f, line_middle(line))) == i);
+            MACRO_CHECK(text.character_index_at(VectorF(x + advance*0.75f, line_middle(line))) == i + 1);
+        }
+    }
+    // point to index to offset: the closest boundary on the point's line
+    for (std::size_t line = 0; line != firsts.size(); ++line) {
+        for (float x = left - 5.f; x < left + text.width() + 5.f; x += 1.7f) {
+            const int index = text.character_index_at(VectorF(x, line_middle(line)));
+            MACRO_CHECK(index >= firsts[line] && index <= lasts[line]);
+            const float distance = std::abs(left + text.character_offset(index) - x);
+            for (int i = firsts[line]; i <= lasts[line]; ++i)
+                MACRO_CHECK(distance <= std::abs(left + text.character_offset(i) - x));
+        }
+    }
+    // above and below the text
+    MACRO_CHECK(text.character_index_at(VectorF(left, top - 50.f)) == 0);
+    MACRO_CHECK(text.character_index_at(VectorF(left + 1000.f, top + 1000.f)) == length);
+
+    ksg::Text line;
+    line.assign_font(&font);
+    line.set_character_size(14);
+    line.set_string(U"Sphinx of black quartz");
+    const int line_length = int(line.string().size());
+    for (int i = 0; i <= line_length; ++i) {
+        // a prefix fits exactly in the width to where its last glyph ends
+        MACRO_CHECK(line.fitting_prefix_length(line.character_offset(i)) == i);
+        if (i != 0)
+            MACRO_CHECK(line.fitting_prefix_length(line.character_offset(i) - 0.01f) == i - 1);
+    }
+    MACRO_CHECK(line.fitting_prefix_length(line.width() + 100.f) == line_length);
+    MACRO_CHECK(line.fitting_prefix_length(-1.f) == 0);
+}
+
+void test_incremental_edits(const sf::Font & font) {
+    auto & cache = ksg::TextLayoutCache::instance();
+    const auto old_limit = cache.byte_limit();
+    cache.set_byte_limit(0);
+
+    auto check_against_fresh = [&font](const ksg::Text & edited, float width) {
+        ksg::Text fresh;
+        fresh.assign_font(&font);
+        fresh.set_character_size(14);
+        fresh.set_limiting_width(width);
+        fresh.set_string(edited.string());
+
+        MACRO_CHECK(edited.line_count() == fresh.line_count());
+        MACRO_CHECK(edited.width () == fresh.width ());
+        MACRO_CHECK(edited.height() == fresh.height());
+        for (int i = 0; i != int(fresh.string().size()) + 1; ++i) {
+            MACRO_CHECK(edited.character_location(i) == fresh.character_location(i));
+            MACRO_CHECK(edited.character_offset  (i) == fresh.character_offset  (i));
+        }
+        for (float y = -5.f; y < fresh.height() + 5.f; y += 7.f) {
+            for (float x = -5.f; x < fresh.width() + 5.f; x += 11.f) {
+                MACRO_CHECK(edited.character_index_at(VectorF(x, y)) ==
+                            fresh .character_index_at(VectorF(x, y)));
+            }
+        }
+        MACRO_CHECK(edited.fitting_prefix_length(fresh.width()*0.5f) ==
+                    fresh .fitting_prefix_length(fresh.width()*0.5f));
+    };
+    auto make_text = [&font](float width, const UString & str) {
+        ksg::Text text;
+        text.assign_font(&font);
+        text.set_character_size(14);
+        text.set_limiting_width(width);
+        text.set_string(str);
+        return text;
+    };
+
+    static const UString k_pieces[] = {
+        U"a", U"W", U" ", U"  ", U"\n", U"quartz", U".", U", ", U"jump!",
+        U"-", U"box\nwith", U"x y"
+    };
+    std::default_random_engine rng { 0x51DE };
+    // unlimited, and wrapped (which lays out the text after an edit anew)
+    for (float width : { std::numeric_limits<float>::infinity(), 160.f }) {
+        // a run of newlines breaks the line once, so edits which join or
+        // split runs move every later line
+        auto runs = make_text(width, U"ab\nx\ncd\nef");
+        runs.erase(3, 1);
+        check_against_fresh(runs, width);
+        runs.insert(3, U"yz");
+        check_against_fresh(runs, width);
+
+        auto edited = make_text(width, U"Sphinx of black quartz, judge my vow.\n"
+                                       U"Pack my box with five dozen liquor jugs.");
+        for (int edit = 0; edit != 400; ++edit) {
+            const int length = int(edited.string().size());
+            // (edits at the start often enough to be sure of them)
+            const int index  = edit % 8 == 0 ? 0 :
+                std::uniform_int_distribution<int>(0, length)(rng);
+            if (length > 0 && rng() % 3 == 0) {
+                edited.erase(index, std::uniform_int_distribution<int>(1, 4)(rng));
+            } else {
+                const auto & piece = k_pieces[rng() % (sizeof(k_pieces)/sizeof(k_pieces[0]))];
+                edited.insert(index, piece);
+            }
+            check_against_fresh(edited, width);
+        }
+    }
+    cache.set_byte_limit(old_limit);
+}
+
+void test_held_text_events(const sf::Font & font) {
+    auto styles = ksg::styles::construct_system_styles();
+    styles[ksg::styles::k_global_font] = ksg::StylesField(&font);
+    ksg::SimpleFrame frame;
+    ksg::EditableText editable;
+    editable.set_width(200.f);
+    editable.set_string(U"abc");
+    frame.begin_adding_widgets(styles).add(editable);
+
+    std::vector<UString> edits;
+    editable.set_edit_event([&edits](const ksg::EditableText::TextEdit & edit)
+        { edits.push_back(edit.inserted); });
+
+    std::vector<sf::Event> events;
+    auto click = [&events, &editable](float x) {
+        sf::Event event;
+        event.type = sf::Event::MouseButtonPressed;
+        event.mouseButton.button = sf::Mouse::Left;
+        event.mouseButton.x = int(x);
+        event.mouseButton.y = int(editable.location().y + editable.height() / 2.f);
+        events.push_back(event);
+        event.type = sf::Event::MouseButtonReleased;
+        events.push_back(event);
+    };
+    // as SFML sends them
+    auto type = [&events](char c) {
+        sf::Event key;
+        key.type = sf::Event::KeyPressed;
+        key.key.code    = sf::Keyboard::Key(sf::Keyboard::A + (c - 'a'));
+        key.key.alt     = key.key.control = key.key.shift = key.key.system = false;
+        events.push_back(key);
+        sf::Event text;
+        text.type = sf::Event::TextEntered;
+        text.text.unicode = sf::Uint32(c);
+        events.push_back(text);
+        sf::Event moved;
+        moved.type = sf::Event::MouseMoved;
+        moved.mouseMove.x = moved.mouseMove.y = 0;
+        events.push_back(moved);
+        key.type = sf::Event::KeyReleased;
+        events.push_back(key);
+    };
+    const float left  = editable.location().x + 1.f;
+    const float right = editable.location().x + editable.width() - 2.f;
+
+    click(right);
+    type('x');
+    type('y');
+    type('z');
+    frame.process_events(events);
+    MACRO_CHECK(editable.string() == U"abcxyz");
+    MACRO_CHECK(edits.size() == 1 && edits.front() == U"xyz");
+
+    // typed, then clicked away, all polled together
+    events.clear();
+    edits.clear();
+    type('d');
+    click(left);
+    type('e');
+    frame.process_events(events);
+    MACRO_CHECK(editable.string() == U"eabcxyzd");
+    MACRO_CHECK(edits.size() == 2);
+}
+
+void test_edit_filters(const sf::Font & font) {
+    using TextEdit = ksg::EditableText::TextEdit;
+    auto styles = ksg::styles::construct_system_styles();
+    styles[ksg::styles::k_global_font] = ksg::StylesField(&font);
+    ksg::SimpleFrame frame;
+    ksg::EditableText editable;
+    editable.set_width(200.f);
+    editable.set_string(U"hello");
+    frame.begin_adding_widgets(styles).add(editable);
+
+    struct Edit {
+        int position, removed_length;
+        UString inserted;
+        bool operator == (const Edit & rhs) const {
+            return position == rhs.position && removed_length == rhs.removed_length
+                && inserted == rhs.inserted;
+        }
+    };
+    std::vector<Edit> edits;
+    editable.set_edit_event([&edits](const TextEdit & edit)
+        { edits.push_back(Edit { edit.position, edit.removed_length, edit.inserted }); });
+    // checks that exactly the given edit was made
+    auto last_edit_is = [&edits](Edit edit) {
+        const bool rv = edits.size() == 1 && edits.front() == edit;
+        edits.clear();
+        return rv;
+    };
+
+    auto press = [&frame](sf::Keyboard::Key code) {
+        sf::Event event;
+        event.type = sf::Event::KeyPressed;
+        event.key.code = code;
+        event.key.alt = event.key.control = event.key.shift = event.key.system = false;
+        frame.process_event(event);
+    };
+    // polled together, and so given as one burst
+    auto type = [&frame](const UString & characters) {
+        std::vector<sf::Event> events;
+        for (auto c : characters) {
+            sf::Event event;
+            event.type = sf::Event::TextEntered;
+            event.text.unicode = sf::Uint32(c);
+            events.push_back(event);
+        }
+        frame.process_events(events);
+    };
+    // focused by clicking past the text's end
+    sf::Event click;
+    click.type = sf::Event::MouseButtonPressed;
+    click.mouseButton.button = sf::Mouse::Left;
+    click.mouseButton.x = int(editable.location().x + editable.width() - 2.f);
+    click.mouseButton.y = int(editable.location().y + editable.height() / 2.f);
+    frame.process_event(click);
+    MACRO_CHECK(editable.cursor_position() == 5);
+
+    type(U"a");
+    MACRO_CHECK(last_edit_is(Edit { 5, 0, U"a" }));
+    press(sf::Keyboard::BackSpace);
+    MACRO_CHECK(last_edit_is(Edit { 5, 1, U"" }));
+    press(sf::Keyboard::Home);
+    press(sf::Keyboard::Delete);
+    MACRO_CHECK(last_edit_is(Edit { 0, 1, U"" }));
+    type(U"xyz");
+    MACRO_CHECK(last_edit_is(Edit { 0, 0, U"xyz" }));
+    MACRO_CHECK(editable.string() == U"xyzello" && editable.cursor_position() == 3);
+
+    // deletions rejected
+    editable.set_edit_filter([](const TextEdit & edit) { return edit.removed_length == 0; });
+    press(sf::Keyboard::BackSpace);
+    press(sf::Keyboard::Delete);
+    MACRO_CHECK(edits.empty());
+    MACRO_CHECK(editable.string() == U"xyzello" && editable.cursor_position() == 3);
+
+    // the character filter judges whole strings, after the edit filter
+    std::vector<UString> judged;
+    editable.set_character_filter([&judged](const UString & str) {
+        judged.push_back(str);
+        return str.size() <= 9;
+    });
+    type(U"ab");
+    MACRO_CHECK(judged.size() == 1 && judged.back() == U"xyzabello");
+    MACRO_CHECK(last_edit_is(Edit { 3, 0, U"ab" }));
+    MACRO_CHECK(editable.cursor_position() == 5);
+    type(U"cd");
+    MACRO_CHECK(judged.size() == 2 && judged.back() == U"xyzabcdello");
+    MACRO_CHECK(edits.empty());
+    MACRO_CHECK(editable.string() == U"xyzabello" && editable.cursor_position() == 5);
+
+    editable.set_edit_filter([](const TextEdit & edit) { return edit.inserted != U"q"; });
+    type(U"q");
+    MACRO_CHECK(judged.size() == 2 && edits.empty());
+    MACRO_CHECK(editable.string() == U"xyzabello" && editable.cursor_position() == 5);
+}
+
+void test_virtual_lines(const sf::Font & font) {
+    static constexpr const int k_line_count = 1000;
+    static constexpr const int k_margin     = ksg::TextArea::k_virtual_line_margin;
+    auto & cache = ksg::TextLayoutCache::instance();
+    const auto old_limit = cache.byte_limit();
+    // each line laid out looks its (unique) string up once
+    cache.set_byte_limit(std::size_t(1) << 20);
+    auto lines_laid_out = [&cache]() {
+        const auto counters = cache.counters();
+        cache.reset_event_counters();
+        return int(counters.hit_count + counters.miss_count);
+    };
+
+    UString content;
+    for (int i = 0; i != k_line_count; ++i) {
+        if (i != 0) content += U"\n";
+        for (char c : "line " + std::to_string(i)) content += UString::value_type(c);
+    }
+    ksg::TextArea area;
+    area.assign_font(font);
+    area.set_character_size(14);
+    area.set_size(300.f, 200.f);
+    area.enable_virtual_lines();
+    area.set_string(content);
+    MACRO_CHECK(area.line_count() == k_line_count);
+
+    const float line_height = [&font]() {
+        ksg::Text text;
+        text.assign_font(&font);
+        text.set_character_size(14);
+        return text.line_height();
+    } ();
+    // (as update_virtual_window) the window only moves once the view leaves
+    // it
+    auto window_of = [line_height](std::pair<int, int> old_window, float offset) {
+        const int first = int(std::floor(offset / line_height));
+        const int last  = std::min(k_line_count,
+            int(std::ceil((offset + 200.f) / line_height)));
+        if (first >= old_window.first && last <= old_window.second) return old_window;
+        return std::make_pair(std::max(0, first - k_margin),
+                              std::min(k_line_count, last + k_margin));
+    };
+    auto new_lines = [](std::pair<int, int> old_window, std::pair<int, int> window) {
+        const int kept = std::max(0, std::min(old_window.second, window.second)
+                                   - std::max(old_window.first, window.first));
+        return (window.second - window.first) - kept;
+    };
+
+    lines_laid_out();
+    auto window = window_of(std::make_pair(0, 0), 0.f);
+    // within the margin
+    area.set_scroll_offset(line_height*float(k_margin - 1));
+    MACRO_CHECK(lines_laid_out() == 0);
+    area.set_scroll_offset(0.f);
+    MACRO_CHECK(lines_laid_out() == 0);
+    // past it, by a little and by a lot
+    for (float offset : { line_height*float(k_margin + 3), line_height*float(k_margin*2 + 20),
+                          line_height*500.5f, line_height*490.f, line_height*470.f })
+    {
+        area.set_scroll_offset(offset);
+        const auto next = window_of(window, offset);
+        MACRO_CHECK(lines_laid_out() == new_lines(window, next));
+        window = next;
+    }
+
+    // clamped to the content
+    const float max_offset = float(k_line_count)*line_height - 200.f;
+    area.set_scroll_offset(-50.f);
+    MACRO_CHECK(area.scroll_offset() == 0.f);
+    area.set_scroll_offset(max_offset*2.f);
+    MACRO_CHECK(area.scroll_offset() == max_offset);
+    area.set_scroll_offset(max_offset - 1.f);
+    MACRO_CHECK(area.scroll_offset() == max_offset - 1.f);
+    // fewer lines than fit have nothing to scroll
+    area.set_string(U"one\ntwo");
+    MACRO_CHECK(area.scroll_offset() == 0.f);
+    area.set_scroll_offset(10.f);
+    MACRO_CHECK(area.scroll_offset() == 0.f);
+    cache.set_byte_limit(old_limit);
+}
+
+void test_clip_view_vertically() {
+    using ksg::detail::clip_view_vertically;
+    auto near = [](float a, float b) { return std::abs(a - b) < 1e-5f; };
+    auto check_clip = [&near](const sf::View & view, float top, float bottom,
+                              sf::FloatRect area, sf::FloatRect viewport)
+    {
+        const auto clipped = clip_view_vertically(view, top, bottom);
+        const auto & center = clipped.getCenter();
+        const auto & size   = clipped.getSize();
+        MACRO_CHECK(near(center.x - size.x / 2.f, area.left ));
+        MACRO_CHECK(near(center.y - size.y / 2.f, area.top  ));
+        MACRO_CHECK(near(size.x, area.width ));
+        MACRO_CHECK(near(size.y, area.height));
+        const auto & rv = clipped.getViewport();
+        MACRO_CHECK(near(rv.left , viewport.left ));
+        MACRO_CHECK(near(rv.top  , viewport.top  ));
+        MACRO_CHECK(near(rv.width, viewport.width));
+        MACRO_CHECK(near(rv.height, viewport.height));
+    };
+    const sf::View whole(sf::FloatRect(0.f, 0.f, 800.f, 600.f));
+    check_clip(whole, 150.f, 300.f, sf::FloatRect(0.f, 150.f, 800.f, 150.f),
+               sf::FloatRect(0.f, 0.25f, 1.f, 0.25f));
+    // clamped to the view, and never inverted
+    check_clip(whole, -50.f, 900.f, sf::FloatRect(0.f, 0.f, 800.f, 600.f),
+               sf::FloatRect(0.f, 0.f, 1.f, 1.f));
+    check_clip(whole, 400.f, 100.f, sf::FloatRect(0.f, 400.f, 800.f, 0.f),
+               sf::FloatRect(0.f, 400.f/600.f, 1.f, 0.f));
+
+    // scrolled, and in the target's lower right quarter
+    sf::View quarter(sf::FloatRect(100.f, 1000.f, 400.f, 200.f));
+    quarter.setViewport(sf::FloatRect(0.5f, 0.5f, 0.5f, 0.5f));
+    check_clip(quarter, 1050.f, 1150.f, sf::FloatRect(100.f, 1050.f, 400.f, 100.f),
+               sf::FloatRect(0.5f, 0.625f, 0.5f, 0.25f));
+}
+
+void test_log_area(const sf::Font & font) {
+    auto numbered = [](const char * prefix, int i) {
+        UString rv;
+        for (char c : prefix + std::to_string(i)) rv += UString::value_type(c);
+        return rv;
+    };
+    ksg::LogArea log;
+    log.assign_font(font);
+    log.set_character_size(14);
+    const float line_height = [&font]() {
+        ksg::Text text;
+        text.assign_font(&font);
+        text.set_character_size(14);
+        return text.line_height();
+    } ();
+    // five lines in view
+    log.set_size(300.f, line_height*5.5f);
+
+    // evicts the oldest, once full, indices still start at the oldest after
+    // the ring wraps (twice)
+    log.set_capacity(8);
+    for (int i = 0; i != 20; ++i) log.append_line(numbered("line ", i));
+    MACRO_CHECK(log.line_count() == 8);
+    for (int i = 0; i != 8; ++i) MACRO_CHECK(log.line(std::size_t(i)) == numbered("line ", 12 + i));
+    bool threw = false;
+    try { (void)log.line(8); } catch (std::out_of_range &) { threw = true; }
+    MACRO_CHECK(threw);
+    log.append_line(U"first\nsecond");
+    MACRO_CHECK(log.line_count() == 8);
+    MACRO_CHECK(log.line(0) == numbered("line ", 14));
+    MACRO_CHECK(log.line(6) == U"first" && log.line(7) == U"second");
+
+    // shrinking and growing keep the newest
+    log.set_capacity(3);
+    MACRO_CHECK(log.capacity() == 3 && log.line_count() == 3);
+    MACRO_CHECK(log.line(0) == numbered("line ", 19));
+    MACRO_CHECK(log.line(1) == U"first" && log.line(2) == U"second");
+    log.set_capacity(5);
+    MACRO_CHECK(log.line_count() == 3 && log.line(0) == numbered("line ", 19));
+    for (int i = 0; i != 4; ++i) log.append_line(numbered("more ", i));
+    MACRO_CHECK(log.line_count() == 5);
+    MACRO_CHECK(log.line(0) == U"second" && log.line(4) == numbered("more ", 3));
+    threw = false;
+    try { log.set_capacity(0); } catch (std::invalid_argument &) { threw = true; }
+    MACRO_CHECK(threw && log.capacity() == 5);
+
+    // a view scrolled back stays on the same lines, until they are evicted
+    log.clear();
+    log.set_capacity(20);
+    for (int i = 0; i != 10; ++i) log.append_line(numbered("line ", i));
+    MACRO_CHECK(log.is_pinned_to_tail());
+    log.set_lines_scrolled_back(2);
+    auto newest_in_view = [&log]()
+        { return log.line(log.line_count() - 1 - std::size_t(log.lines_scrolled_back())); };
+    MACRO_CHECK(newest_in_view() == numbered("line ", 7));
+    for (int i = 10; i != 20; ++i) {
+        log.append_line(numbered("line ", i));
+        MACRO_CHECK(newest_in_view() == numbered("line ", 7));
+    }
+    MACRO_CHECK(log.lines_scrolled_back() == 12);
+    // the oldest lines in view are evicted, the view stays on the oldest
+    // five kept
+    for (int i = 20; i != 25; ++i) log.append_line(numbered("line ", i));
+    MACRO_CHECK(log.lines_scrolled_back() == 15);
+    MACRO_CHECK(newest_in_view() == numbered("line ", 9));
+    // too far back is clamped, and back to the tail is pinned again
+    log.set_lines_scrolled_back(100);
+    MACRO_CHECK(log.lines_scrolled_back() == 15);
+    log.set_lines_scrolled_back(0);
+    log.append_line(U"newest");
+    MACRO_CHECK(log.is_pinned_to_tail() && newest_in_view() == U"newest");
+}
+
+void test_layout_cache(const sf::Font & font) {
+    auto & cache = ksg::TextLayoutCache::instance();
+    const auto old_limit = cache.byte_limit();
+    cache.clear();
+    cache.set_byte_limit(ksg::TextLayoutCache::k_suggested_byte_limit);
+    cache.reset_event_counters();
+    // a new text's layout looks its string up exactly once, this returns
+    // the events it counted
+    auto lay_out = [&cache, &font](const UString & str) {
+        cache.reset_event_counters();
+        ksg::Text text;
+        text.assign_font(&font);
+        text.set_character_size(14);
+        text.set_string(str);
+        return cache.counters();
+    };
+    auto is_hit = [](const ksg::TextLayoutCache::Counters & counters)
+        { return counters.hit_count == 1 && counters.miss_count == 0; };
+    auto is_miss = [](const ksg::TextLayoutCache::Counters & counters)
+        { return counters.hit_count == 0 && counters.miss_count == 1; };
+
+    // inserted on the second miss only, then hit
+    auto events = lay_out(U"alpha");
+    MACRO_CHECK(is_miss(events) && events.insert_count == 0 && events.entry_count == 0);
+    events = lay_out(U"alpha");
+    MACRO_CHECK(is_miss(events) && events.insert_count == 1 && events.entry_count == 1);
+    MACRO_CHECK(events.byte_count > 0);
+    MACRO_CHECK(is_hit(lay_out(U"alpha")));
+    // strings seen once are never inserted
+    for (int i = 0; i != 10; ++i) {
+        events = lay_out(U"once " + UString(std::size_t(i + 1), U'x'));
+        MACRO_CHECK(is_miss(events) && events.insert_count == 0);
+    }
+    MACRO_CHECK(cache.counters().entry_count == 1);
+
+    lay_out(U"bravo");
+    lay_out(U"bravo");
+    lay_out(U"charlie");
+    MACRO_CHECK(lay_out(U"charlie").entry_count == 3);
+    // most recently used first: alpha, charlie, bravo
+    MACRO_CHECK(is_hit(lay_out(U"alpha")));
+
+    // over the limit, the least recently used is evicted, and only it
+    cache.set_byte_limit(cache.counters().byte_count - 1);
+    events = cache.counters();
+    MACRO_CHECK(events.eviction_count == 1 && events.entry_count == 2);
+    MACRO_CHECK(is_hit(lay_out(U"alpha"  )));
+    MACRO_CHECK(is_hit(lay_out(U"charlie")));
+    // bravo is inserted again (having missed before), ahead of charlie, and
+    // alpha is now the least recently used
+    events = lay_out(U"bravo");
+    MACRO_CHECK(is_miss(events) && events.insert_count == 1 && events.eviction_count == 1);
+    MACRO_CHECK(is_hit(lay_out(U"charlie")));
+    MACRO_CHECK(is_hit(lay_out(U"bravo"  )));
+    MACRO_CHECK(is_miss(lay_out(U"alpha")));
+
+    cache.clear();
+    MACRO_CHECK(cache.counters().entry_count == 0 && cache.counters().byte_count == 0);
+    cache.set_byte_limit(old_limit);
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,118 @@
+#include <ksg/Text.hpp>
+#include <ksg/Utf8.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace ksg;
+
+namespace {
+
+using UString = Text::UString;
+using Clock   = std::chrono::steady_clock;
+
+constexpr const int k_update_count = 2000;
+
+// every allocation made by the program passes through the replacements below
+std::size_t s_allocation_count = 0;
+std::size_t s_allocated_bytes  = 0;
+
+// a log line's worth of text, mostly ASCII with some accents and CJK
+std::string make_utf8_string();
+
+// how a program would have done it before, byte by byte into a temporary
+UString naive_decode(const std::string &);
+
+double milliseconds_since(Clock::time_point);
+
+template <typename Func>
+void report(const char * what, std::size_t string_size, Func && f);
+
+} // end of <anonymous> namespace
+
+void * operator new(std::size_t size) {
+    ++s_allocation_count;
+    s_allocated_bytes += size;
+    if (void * ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void * ptr) noexcept { std::free(ptr); }
+
+void operator delete(void * ptr, std::size_t) noexcept { std::free(ptr); }
+
+int main() {
+    // (no font is assigned, so that only the string's handling is measured)
+    const std::string utf8 = make_utf8_string();
+    Text text;
+
+    report("decode to a temporary, then set_string", utf8.size(), [&] {
+        text.set_string(naive_decode(utf8));
+    });
+    report("decode to a temporary, then set_string (const &)", utf8.size(), [&] {
+        const UString decoded = naive_decode(utf8);
+        text.set_string(decoded);
+    });
+    report("set_string (UTF-8 view)", utf8.size(), [&] {
+        text.set_string(std::string_view(utf8));
+    });
+    if (text.string() != naive_decode(utf8)) {
+        std::cout << "decoded strings differ!" << std::endl;
+        return 1;
+    }
+}
+
+namespace {
+
+std::string make_utf8_string() {
+    static const char * const k_pieces[] = {
+        "Loaded level ", "caf\xc3\xa9", " in 12ms, ", "\xe4\xb8\xad\xe6\x96\x87",
+        " players connected; ", "na\xc3\xafve ", "checksum ok. "
+    };
+    std::string rv;
+    for (int i = 0; rv.size() < 4096; ++i)
+        rv += k_pieces[i % (sizeof(k_pieces) / sizeof(k_pieces[0]))];
+    return rv;
+}
+
+UString naive_decode(const std::string & utf8) {
+    // (no validation, as such code usually goes)
+    UString rv;
+    for (std::size_t i = 0; i < utf8.size(); ) {
+        auto lead = static_cast<unsigned char>(utf8[i]);
+        int length = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+        char32_t c = length == 1 ? lead : (lead & (0xFF >> (length + 1)));
+        for (int j = 1; j < length && i + std::size_t(j) < utf8.size(); ++j)
+            c = (c << 6) | (static_cast<unsigned char>(utf8[i + std::size_t(j)]) & 0x3F);
+        rv += c;
+        i += std::size_t(length);
+    }
+    return rv;
+}
+
+double milliseconds_since(Clock::time_point start) {
+    using namespace std::chrono;
+    return duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename Func>
+void report(const char * what, std::size_t string_size, Func && f) {
+    f(); // warm up, the text's string grows to size once
+    auto allocations_before = s_allocation_count;
+    auto bytes_before       = s_allocated_bytes;
+    auto start = Clock::now();
+    for (int i = 0; i != k_update_count; ++i) f();
+    double ms = milliseconds_since(start);
+    auto allocations = s_allocation_count - allocations_before;
+    auto bytes       = s_allocated_bytes  - bytes_before;
+    std::cout << what << ": " << (ms*1000. / k_update_count) << "us per update ("
+              << string_size << " bytes), "
+              << (double(allocations) / k_update_count) << " allocations and "
+              << (double(bytes) / k_update_count) << " bytes allocated per update"
+              << std::endl;
+}
+
+} // end of <anonymous> namespace
@@ -40,8 +40,10 @@ public:
 
     void set_direction(Direction dir_);
 
-    void set_arrow_color(sf::Color color_)
-        { m_draw_tri.set_color(color_); }
+    void set_arrow_color(sf::Color color_) {
+        flag_visual_change();
+        m_draw_tri.set_color(color_);
+    }
 
     Direction direction() const { return m_dir; }
 
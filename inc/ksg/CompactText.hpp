@@ -0,0 +1,193 @@
+/****************************************************************************
+
+    File: CompactText.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <ksg/FontRegistry.hpp>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Font.hpp>
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <limits>
+
+#include <cstdint>
+
+namespace ksg {
+
+/** @brief A small text for short labels, where many are shown at once.
+ *
+ *  Text keeps its string, layout tables and font each in their own heap
+ *  memory, which adds up for a screen of thousands of labels. A compact
+ *  text stores strings of up to k_inline_length characters, and each
+ *  character's placed glyph, within the object itself; longer strings take
+ *  a single heap block. Its font is a handle into the FontRegistry, where
+ *  glyph quads are shared by all compact texts of that font and size.
+ *  @n
+ *  Only what a label needs is offered: no limiting dimensions (and so no
+ *  wrapping), color spans, markup or glyph atlases. Newlines do start new
+ *  lines. Glyphs are placed and drawn exactly as a Text (without limits or
+ *  a monospace hint) would.
+ */
+class CompactText final : public sf::Drawable {
+public:
+    using UChar      = char32_t;
+    using UString    = std::u32string;
+    using FontHandle = FontRegistry::Handle;
+    using VectorF    = sf::Vector2f;
+
+    static constexpr const std::size_t k_inline_length = 12;
+    static constexpr const std::size_t k_max_length =
+        std::numeric_limits<std::uint16_t>::max();
+
+    CompactText() {}
+
+    CompactText(const CompactText &);
+
+    CompactText(CompactText &&) noexcept;
+
+    ~CompactText() override;
+
+    CompactText & operator = (const CompactText &);
+
+    CompactText & operator = (CompactText &&) noexcept;
+
+    /** @throws std::length_error if the string is longer than k_max_length
+     *          (the text is then unchanged)
+     */
+    void set_string(std::u32string_view);
+
+    // (spares string literals an ambiguous conversion)
+    void set_string(const UChar *);
+
+    /** Decodes UTF-8, malformed sequences show as the replacement character
+     *  (see decode_utf8).
+     */
+    void set_string(std::string_view utf8);
+
+    void set_character_size(int);
+
+    void set_color(sf::Color);
+
+    void set_location(float x, float y);
+
+    void set_location(VectorF r);
+
+    /** @throws std::out_of_range if the handle was never given out by the
+     *          registry
+     */
+    void assign_font(FontHandle);
+
+    // registers the font
+    void assign_font(const sf::Font *);
+
+    void assign_font(const std::shared_ptr<const sf::Font> &);
+
+    std::u32string_view string() const noexcept;
+
+    FontHandle font_handle() const noexcept { return m_font; }
+
+    bool has_font_assigned() const noexcept { return m_font != FontRegistry::k_no_font; }
+
+    // @returns zero if no size is set
+    int character_size() const noexcept { return m_char_size; }
+
+    sf::Color color() const noexcept { return m_color; }
+
+    VectorF location() const noexcept { return m_location; }
+
+    // extents of visible glyphs, as Text's
+    float width() const noexcept { return m_size.x; }
+
+    float height() const noexcept { return m_size.y; }
+
+    bool is_visible() const noexcept;
+
+    /** @returns heap memory held by this text (zero for inline strings) */
+    std::size_t heap_byte_size() const noexcept;
+
+private:
+    using GlyphId = FontRegistry::GlyphId;
+    using TableId = FontRegistry::TableId;
+
+    static constexpr const TableId k_no_table = std::numeric_limits<TableId>::max();
+
+    // origin of the glyph's quad on its line, and its id in the glyph table
+    struct PlacedGlyph {
+        float x;
+        GlyphId glyph_id;
+        std::uint16_t line;
+    };
+
+    struct InlineStorage {
+        UChar chars[k_inline_length];
+        PlacedGlyph glyphs[k_inline_length];
+    };
+
+    // one block, glyphs then characters
+    struct HeapStorage {
+        PlacedGlyph * glyphs;
+        UChar * chars;
+    };
+
+    void draw(sf::RenderTarget &, sf::RenderStates) const override;
+
+    // places glyphs, or leaves no layout without a font or size
+    void update_geometry();
+
+    bool has_layout() const noexcept { return m_glyph_table != k_no_table; }
+
+    UChar * chars() noexcept;
+
+    const UChar * chars() const noexcept;
+
+    PlacedGlyph * glyphs() noexcept;
+
+    const PlacedGlyph * glyphs() const noexcept;
+
+    bool is_inline() const noexcept { return m_capacity == 0; }
+
+    // makes room for the length, old contents are not kept
+    void reserve(std::size_t length);
+
+    void free_heap_storage() noexcept;
+
+    VectorF m_location;
+    VectorF m_size;
+    sf::Color m_color;
+    int m_char_size = 0;
+    FontHandle m_font = FontRegistry::k_no_font;
+    // glyphs are laid out from this table, k_no_table if there's no layout
+    TableId m_glyph_table = k_no_table;
+    std::uint16_t m_length = 0;
+    // zero while the string is inline
+    std::uint16_t m_capacity = 0;
+    union {
+        InlineStorage m_inline;
+        HeapStorage m_heap;
+    };
+};
+
+} // end of ksg namespace
@@ -21,7 +21,6 @@
 
 #pragma once
 
-#include <SFML/Graphics/Drawable.hpp>
 #include <SFML/Graphics/Glyph.hpp>
 #include <SFML/Graphics/Color.hpp>
 #include <SFML/Graphics/Vertex.hpp>
@@ -29,10 +28,29 @@
 
 #include <common/FixedLengthArray.hpp>
 
+#include <vector>
+
 namespace ksg {
 
 namespace detail {
 
+/** What a glyph's quad is made from, relative to the pen position. Text
+ *  keeps one of these per distinct glyph, and only refers to them for each
+ *  character.
+ */
+struct GlyphQuad {
+    GlyphQuad() {}
+
+    GlyphQuad(const sf::Glyph & glyph, int page_);
+
+    sf::FloatRect bounds;
+    sf::FloatRect texture_rect;
+    float advance = 0.f;
+    // page of the glyph atlas, or without one, the text style whose font
+    // texture holds the glyph
+    int page = 0;
+};
+
 /** @brief Contains common features to both draw character and the version
  *         without advance (positional stepping) information.
  *  This class represents a single drawable character and can be treated
@@ -40,10 +58,12 @@ namespace detail {
  *  partially truncate the character by "cutting" it. Methods that accomplish
  *  this are "cut_on_right" and "cut_on_bottom". Further cutting methods maybe
  *  added in the future.
+ *  Text does not store these, characters are expanded into them only to be
+ *  drawn.
  *  @warning Once a character has been cut it cannot be restored short of
  *           re-initializing the character from its original glyph.
  */
-class DrawableCharacter : public sf::Drawable {
+class DrawableCharacter final {
 public:
     using VectorF = sf::Vector2f;
 
@@ -53,6 +73,8 @@ public:
 
     DrawableCharacter(const sf::Glyph & glyph, sf::Color clr);
 
+    DrawableCharacter(VectorF loc, const GlyphQuad & quad, sf::Color clr);
+
     void set_color(sf::Color clr);
 
     sf::Color color() const;
@@ -69,6 +91,12 @@ public:
      */
     void cut_on_right(float cut_line);
 
+    /** Cuts off part of a quad by changing its left verticies, this is the
+     *  mirror of cut_on_right.
+     *  @param cut_line X-coordinate where the cut is made.
+     */
+    void cut_on_left(float cut_line);
+
     /** Cuts off part of a quad by changing its bottom verticies. A cut is made
      *  by changing positions and the texture rectangle's coordinates to give a
      *  "cut-off" effect. This will cause the bottom of the character to be
@@ -85,9 +113,16 @@ public:
 
     bool whiped_out() const;
 
-private:
-    void draw(sf::RenderTarget & target, sf::RenderStates states) const final;
+    /** Appends this character's quad (four verticies) to the given
+     *  container, moved by the given offset. This allows many characters to
+     *  be drawn in a single call.
+     */
+    void append_verticies_to(std::vector<sf::Vertex> &, VectorF offset) const;
+
+    /** Writes this character's four verticies, moved by the given offset. */
+    void write_verticies(sf::Vertex * out, VectorF offset) const;
 
+private:
     void check_invarients() const;
 
     FixedLengthArray<sf::Vertex, 4> m_verticies;
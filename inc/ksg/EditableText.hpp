@@ -24,62 +24,44 @@
 #include <ksg/Widget.hpp>
 #include <ksg/Text.hpp>
 #include <ksg/FocusWidget.hpp>
-#include <ksg/DrawTriangle.hpp>
 
 #include <common/DrawRectangle.hpp>
 
 namespace ksg {
 
-namespace detail {
-
-class Ellipsis final : public sf::Drawable {
-public:
-    using VectorF = sf::Vector2f;
-    void set_size(float w, float h);
-    void set_location(float x, float y);
-    float width() const { return m_back.width(); }
-private:
-
-    static constexpr const int   k_dot_shape_count = 6;
-    static constexpr const float k_inner_hsize = 3.f / 4.f;
-    static constexpr const float k_inner_step = (1.f / 8.f)*k_inner_hsize;
-    static constexpr const float k_top_line = 1.f / 3.f;
-    static constexpr const float k_bottom_line = 2.f / 3.f;
-    static constexpr const float k_hmargin = (1.f - k_inner_hsize) / 2.f;
-
-    static VectorF point_a_for(int);
-    static VectorF point_b_for(int);
-    static VectorF point_c_for(int);
-
-    void update_dots();
-
-    void draw(sf::RenderTarget & target, sf::RenderStates states) const override;
-
-    DrawRectangle m_back;
-    FixedLengthArray<DrawTriangle, k_dot_shape_count> m_dots;
-};
-
-} // end of detail namespace
-
 /** @brief The EditableText Widget allows a user to enter their own text.
  *
  *  It is encouraged that the client programmer constrain the dimensions of
  *  this widget, though it is not strictly required. \n
- *  If text overflows and ellipsis is rendered at the end without consideration
- *  for width/height constraints (an extreme case). \n
+ *  Text which overflows the widget is scrolled horizontally, so that the
+ *  cursor is always visible. Only the characters in view are drawn. \n
  *  For styles: for any style not set for constants defined by this class will
  *              fall back to those defined in the Frame class.
  */
 class EditableText final : public FocusWidget {
 public:
-    using Ellipsis       = detail::Ellipsis;
     using UString        = Text::UString;
     using CharFilterFunc = std::function<bool(const UString &)>;
     using BlankFunc      = std::function<void()>;
 
+    /** Describes one edit: removed_length characters starting at position
+     *  are replaced by the inserted string. An insertion removes nothing, a
+     *  deletion inserts nothing.
+     */
+    struct TextEdit {
+        int position;
+        int removed_length;
+        const UString & inserted;
+    };
+
+    using EditFilterFunc = std::function<bool(const TextEdit &)>;
+    using EditFunc       = std::function<void(const TextEdit &)>;
+
     // always uses frame's border color, text font, padding
     static constexpr const char * const k_background_color    = "editable-text-background";
-    static constexpr const char * const k_ellipsis_back_color = "editable-text-ellipsis-background";
+    // text which overflows is scrolled, there is no ellipsis, this style is
+    // ignored
+    [[deprecated]] static constexpr const char * const k_ellipsis_back_color = "editable-text-ellipsis-background";
 
     EditableText();
 
@@ -88,10 +70,15 @@ public:
      *  the text in response to an event.
      *  When the widget has focus: \n
      *  It will move the cursor in manner of accordance with any editable text
-     *  box in response to the arrow keys.
+     *  box in response to the arrow keys, home and end. Text is inserted, and
+     *  deleted (backspace/delete) at the cursor. Control+V pastes at the
+     *  cursor.
      */
     void process_event(const sf::Event &) override;
 
+    /** Inserts a burst of typed characters as one edit. */
+    void process_text_burst(const UString &) override;
+
     void set_location(float x, float y) override;
 
     VectorF location() const override;
@@ -102,14 +89,29 @@ public:
 
     void set_style(const StyleMap &) override;
 
+    /** Adds the current string only, characters the user may type are not
+     *  known in advance.
+     */
+    void add_glyphs_to(GlyphPrewarmer &) const override;
+
     void set_width(float);
 
     [[deprecated]] void set_text(const UString &);
 
     void set_string(const UString &);
 
+    /** Places the cursor before the character at the given index.
+     *  @throws if index is not in [0 character_count()]
+     */
     void set_cursor_position(int);
 
+    int cursor_position() const noexcept { return m_cursor_index; }
+
+    /** Inserts the string at the cursor, as if typed (or pasted). The whole
+     *  string is filtered, laid out, and notified of as one edit.
+     */
+    void insert_at_cursor(const UString &);
+
     int character_count() const;
 
     [[deprecated]] const UString & text() const;
@@ -118,10 +120,27 @@ public:
 
     void set_character_size(int);
 
+    /** The filter is given the string an insertion would produce, and
+     *  rejects the insertion by returning false. Deletions are not filtered.
+     *  @note building that string costs O(n) for every edit, an edit filter
+     *        only needs to look at the edit itself
+     */
     void set_character_filter(CharFilterFunc &&);
 
+    /** The filter is given each edit (insertions and deletions) before it
+     *  is made, and rejects it by returning false. It applies before any
+     *  character filter.
+     */
+    void set_edit_filter(EditFilterFunc &&);
+
+    /** Called after each edit, with no description of it. */
     void set_text_change_event(BlankFunc &&);
 
+    /** Called after each edit with its description, before any text change
+     *  event.
+     */
+    void set_edit_event(EditFunc &&);
+
 private:
     float max_text_width() const;
 
@@ -133,13 +152,25 @@ private:
 
     void draw(sf::RenderTarget & target, sf::RenderStates states) const override;
 
-    bool need_ellipsis() const noexcept {
-        if (!m_text.has_font_assigned()) return false;
-        return m_text.measure_text(m_text.string()).width > max_text_width();
-    }
-
     void update_geometry();
 
+    // updates whether the text (and cursor) overflows the widget
+    void update_overflow();
+
+    float cursor_width() const;
+
+    void erase_characters(int index, int count);
+
+    // typed characters are inserted, control characters are not
+    void insert_typed(UString);
+
+    bool passes_filters(const TextEdit &) const;
+
+    void on_text_edited(const TextEdit &);
+
+    // clamps the index to the string
+    void move_cursor(int index);
+
     void update_cursor();
 
     float padding() const noexcept;
@@ -157,10 +188,16 @@ private:
     float m_padding       = styles::get_unset_value<float>();
     float m_inner_padding = styles::get_unset_value<float>();
 
-    Ellipsis m_ellipsis;
+    bool m_overflowing = false;
+    // how far the text is scrolled left
+    float m_scroll = 0.f;
+    int m_cursor_index = 0;
 
-    CharFilterFunc m_filter_func = [](const UString &) { return true; };
+    // no filter accepts everything
+    CharFilterFunc m_filter_func;
+    EditFilterFunc m_edit_filter_func;
     BlankFunc m_change_text_func = [](){};
+    EditFunc m_edit_func;
 };
 
 } // end of ksg namespace
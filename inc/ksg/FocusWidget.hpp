@@ -24,6 +24,7 @@
 #include <ksg/Widget.hpp>
 
 #include <functional>
+#include <string>
 
 namespace sf { class Event; }
 
@@ -56,6 +57,8 @@ class FocusWidgetAtt {
  */
 class FocusWidget : public Widget {
 public:
+    using UString = std::u32string;
+
     friend class detail::FocusWidgetAtt;
     ~FocusWidget() override;
 
@@ -64,6 +67,15 @@ public:
      */
     virtual void process_focus_event(const sf::Event &) = 0;
 
+    /** This function is called with the characters of consecutive text
+     *  entered events, which the frame has held back (see
+     *  Frame::process_events). A widget may handle a burst of typing, or a
+     *  paste, as one edit. \n
+     *  By default, each character is given to process_focus_event as its own
+     *  text entered event.
+     */
+    virtual void process_text_burst(const UString &);
+
     /** Checks if this widget is requesting focus, and then turns the request
      *  off.
      *  @return true if requesting focus, false otherwise
@@ -119,6 +131,27 @@ public:
      */
     void process_event(const sf::Event &);
 
+    /** While held, text entered events are not given to the focus widget
+     *  as they come, but collected; they are given as one burst when an
+     *  event which may act on them arrives (editing and navigation keys,
+     *  shortcuts and mouse buttons), or when text events are released.
+     *  Key releases, mouse moves and presses of other keys, which come
+     *  between typed characters, leave the text held.
+     *  Held text events are not seen by the focus advance/regress functions.
+     */
+    void hold_text_events();
+
+    /** Gives any held text to the focus widget, if the event may act on it
+     *  (see hold_text_events). Frames call this before their widgets see
+     *  the event, so that the text is typed where the cursor was.
+     */
+    void flush_held_text_before(const sf::Event &);
+
+    /** Gives any held text to the focus widget, and stops holding text
+     *  events.
+     */
+    void release_text_events();
+
     /** This function provides a point for Frames to deposit all focus widgets
      *  to.
      */
@@ -142,11 +175,16 @@ public:
     static bool default_focus_regress(const sf::Event &);
 
 private:
+    void flush_held_text();
+
     FocusChangeFunc m_advance_func = default_focus_advance;
     FocusChangeFunc m_regress_func = default_focus_regress;
 
     std::vector<FocusWidget *> m_focus_widgets;
     std::vector<FocusWidget *>::iterator m_current_position;
+
+    bool m_holding_text = false;
+    FocusWidget::UString m_held_text;
 };
 
 } // end of detail namespace
@@ -0,0 +1,179 @@
+/****************************************************************************
+
+    File: FontRegistry.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <ksg/DrawCharacter.hpp>
+
+#include <SFML/Graphics/Font.hpp>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <array>
+#include <unordered_map>
+
+#include <cstdint>
+
+namespace ksg {
+
+class CompactText;
+
+/** @brief Refers to fonts by small handles, and keeps the glyphs which
+ *         compact texts use.
+ *
+ *  A CompactText refers to its font by a 16 bit handle rather than a
+ *  pointer (or shared pointer, which costs an atomic count per copy). The
+ *  registry also holds one table of glyph quads per font and character
+ *  size, which every compact text of that font and size shares, so that
+ *  texts need only store a small id per character.
+ *  @n
+ *  Registering the same font again gives the same handle. Handles are
+ *  never reused, even after a font is forgotten.
+ *  @warning Fonts registered by address must outlive their use, and should
+ *           be forgotten (see forget_font) before they are destroyed.
+ *  @note The registry is guarded by a mutex, so texts maybe laid out and
+ *        drawn on any thread (fonts still must not be shared by threads).
+ */
+class FontRegistry final {
+public:
+    using Handle = std::uint16_t;
+
+    static constexpr const Handle k_no_font = 0;
+    static constexpr const std::size_t k_max_font_count = 0xFFFF;
+
+    FontRegistry(const FontRegistry &) = delete;
+
+    FontRegistry & operator = (const FontRegistry &) = delete;
+
+    static FontRegistry & instance();
+
+    /** @returns the font's handle, the font is registered the first time it
+     *           is seen (k_no_font for null)
+     *  @throws std::length_error if k_max_font_count fonts were registered
+     */
+    Handle register_font(const sf::Font *);
+
+    /** Same as above, the registry keeps the font alive until it is
+     *  forgotten.
+     */
+    Handle register_font(const std::shared_ptr<const sf::Font> &);
+
+    /** @returns the registered font, null for k_no_font or a forgotten font
+     *  @throws std::out_of_range if the handle was never given out
+     */
+    const sf::Font * font(Handle) const;
+
+    /** Drops the font and its glyph tables, texts which still refer to it
+     *  are no longer drawn. Layouts cached with the font (see
+     *  TextLayoutCache) are dropped too. The font maybe registered again
+     *  (under a new handle).
+     */
+    void forget_font(const sf::Font *);
+
+    /** @returns number of fonts registered, forgotten ones included */
+    std::size_t font_count() const;
+
+    /** @returns approximate heap memory used by all glyph tables */
+    std::size_t glyph_table_byte_size() const;
+
+private:
+    friend class ksg::CompactText;
+    using UChar   = char32_t;
+    using TableId = std::uint16_t;
+    using GlyphId = std::uint16_t;
+
+    // (the largest id is left for compact texts without a table)
+    static constexpr const std::size_t k_max_table_count = 0xFFFF;
+
+    struct FontEntry {
+        const sf::Font * font = nullptr;
+        // only for fonts registered by shared pointer
+        std::shared_ptr<const sf::Font> owner;
+    };
+
+    /** Quads of one font and character size, id zero is the empty quad
+     *  (used for newlines).
+     */
+    class GlyphTable {
+    public:
+        GlyphTable(const sf::Font *, int char_size);
+
+        // @returns the character's glyph id, placing its glyph if new
+        // @throws std::length_error if the table has no ids left
+        GlyphId glyph_id(UChar);
+
+        const detail::GlyphQuad & quad(GlyphId id) const
+            { return m_quads[id]; }
+
+        const sf::Font * font() const noexcept { return m_font; }
+
+        int character_size() const noexcept { return m_char_size; }
+
+        float line_spacing() const noexcept { return m_line_spacing; }
+
+        std::size_t byte_size() const noexcept;
+
+        // the font is gone, so are the quads
+        void forget();
+
+    private:
+        static constexpr const UChar k_ascii_first = U' ';
+        static constexpr const UChar k_ascii_last  = U'~';
+
+        const sf::Font * m_font;
+        int m_char_size;
+        float m_line_spacing;
+        std::vector<detail::GlyphQuad> m_quads = std::vector<detail::GlyphQuad>(1);
+        // zero for characters not yet placed
+        std::array<GlyphId, std::size_t(k_ascii_last - k_ascii_first) + 1> m_ascii_ids {};
+        std::unordered_map<UChar, GlyphId> m_other_ids;
+    };
+
+    FontRegistry();
+
+    // tables are only used while holding this
+    std::unique_lock<std::mutex> lock_tables() const
+        { return std::unique_lock<std::mutex>(m_mutex); }
+
+    // (lock must be held)
+    // @returns the table of the font and size, creating it if needed
+    // @throws std::length_error if k_max_table_count tables were created
+    TableId glyph_table(Handle, int char_size);
+
+    // (lock must be held)
+    GlyphTable & table(TableId id) { return *m_tables[id]; }
+
+    const GlyphTable & table(TableId id) const { return *m_tables[id]; }
+
+    Handle add_font(FontEntry &&);
+
+    mutable std::mutex m_mutex;
+    // indexed by handle, the first is k_no_font
+    std::vector<FontEntry> m_fonts;
+    std::unordered_map<const sf::Font *, Handle> m_handles;
+    // tables stay where they are as others are added
+    std::vector<std::unique_ptr<GlyphTable>> m_tables;
+    std::unordered_map<std::uint64_t, TableId> m_table_ids;
+};
+
+} // end of ksg namespace
@@ -28,9 +28,11 @@ namespace ksg {
 class ArrowButton;
 class Frame;
 class ImageWidget;
+class LogArea;
 class OptionsSlider;
 class ProgressBar;
 class TextArea;
 class TextButton;
+class TextEditor;
 
 } // end of ksg namespace
@@ -24,6 +24,9 @@
 #include <ksg/FrameBorder.hpp>
 #include <ksg/FocusWidget.hpp>
 
+#include <SFML/Graphics/RenderTexture.hpp>
+
+#include <memory>
 #include <vector>
 
 namespace ksg {
@@ -166,6 +169,23 @@ public:
 
     static constexpr const float k_default_padding = 5.f;
 
+    /** Counts how a frame's render cache has been used, since caching was
+     *  enabled (or the counters were last reset).
+     */
+    struct RenderCacheCounters {
+        //! draws which only had to draw the cached texture
+        std::size_t hit_count  = 0;
+        //! draws which rendered the frame's contents into the texture
+        std::size_t miss_count = 0;
+        //! video memory taken by the cached texture (four bytes a pixel)
+        std::size_t byte_count = 0;
+
+        double hit_rate() const noexcept {
+            auto draw_count = hit_count + miss_count;
+            return draw_count ? double(hit_count) / double(draw_count) : 0.;
+        }
+    };
+
     Frame & operator = (const Frame &);
     Frame & operator = (Frame &&);
 
@@ -184,6 +204,15 @@ public:
      */
     void process_event(const sf::Event &) override;
 
+    /** Processes each event in order, as process_event does, except that
+     *  text entered events are given to the focus widget as one burst, up
+     *  to the next event which may act on the text (an editing or navigation
+     *  key, or a mouse button). Fast typing or a paste (polled together)
+     *  then costs the focus widget one edit rather than one for each
+     *  character.
+     */
+    void process_events(const std::vector<sf::Event> &);
+
     /** Gets the pixel location of the frame.
      *  @return returns a vector for location in pixels
      */
@@ -202,6 +231,11 @@ public:
      */
     void set_size(float w, float h);
 
+    /** Adds the frame's title, member widgets are added by the prewarmer
+     *  itself.
+     */
+    void add_glyphs_to(GlyphPrewarmer &) const override;
+
     // <------------------ Frame specific functionality ---------------------->
 
     /** @brief Provides an interface where all widgets maybe added. It is
@@ -279,6 +313,35 @@ public:
      */
     bool has_drag_enabled() const;
 
+    // <------------------------- Render caching ---------------------------->
+
+    /** @brief Enables/disables rendering this frame (and all its widgets) to
+     *         an offscreen texture, which is then drawn as one textured quad.
+     *
+     *  The texture is redrawn only when something in the frame may look
+     *  different. That is when: any widget flags a visual change (see
+     *  Widget::flag_visual_change), the frame is moved or resized, the mouse
+     *  hovers onto a different widget, a mouse button is held while the mouse
+     *  moves, focus changes, or any other event reaches the frame. So a
+     *  frame whose contents rarely change (e.g. a menu, or a status panel)
+     *  costs one quad to draw on most frames. Disabled by default.
+     *
+     *  @note Limitations: the cached texture is drawn with the target's view,
+     *        so views which scale or rotate the frame will filter (blur) its
+     *        contents. Translucent backgrounds are blended against a
+     *        transparent texture first, and then against the target, which
+     *        may differ slightly from drawing them directly.
+     */
+    void set_render_caching(bool);
+
+    bool has_render_caching() const noexcept { return m_is_render_cached; }
+
+    const RenderCacheCounters & render_cache_counters() const noexcept
+        { return m_cache_counters; }
+
+    /** Resets hit and miss counts, the byte count stays as the texture's. */
+    void reset_render_cache_counters();
+
     void swap(Frame &);
 
 protected:
@@ -342,6 +405,26 @@ private:
 
     void check_invarients() const;
 
+    /** @returns true if this frame or any widget in it has flagged a visual
+     *           change, or if the frame moved or was resized since it was
+     *           last cached
+     */
+    bool needs_render_cache_update() const;
+
+    /** Draws this frame's contents into the cache texture, (re)creating it
+     *  if necessary.
+     *  @returns false if a texture is not available (the frame is then to be
+     *           drawn directly)
+     */
+    bool update_render_cache() const;
+
+    void draw_contents(sf::RenderTarget &) const;
+
+    /** Flags the frame if the mouse moved onto a different widget, or if
+     *  something maybe dragged.
+     */
+    void check_for_hover_change(const sf::Event &);
+
     std::vector<Widget *> m_widgets;
     float m_padding = styles::get_unset_value<float>();
     // anything related to the frame's border
@@ -353,6 +436,16 @@ private:
     FrameBorder m_border;
 
     detail::FrameFocusHandler m_focus_handler;
+
+    bool m_is_render_cached = false;
+    // the texture is part of how the frame is drawn, not its state
+    mutable std::unique_ptr<sf::RenderTexture> m_cache_texture;
+    mutable VectorF m_cached_location;
+    mutable VectorF m_cached_size;
+    mutable RenderCacheCounters m_cache_counters;
+
+    const Widget * m_hovered_widget = nullptr;
+    bool m_is_mouse_held = false;
 };
 
 /** A Simple Frame allows creation of frames without being inherited. This can
@@ -367,11 +460,15 @@ public:
 
 // ----------------------------------------------------------------------------
 
-inline void Frame::set_title(const UString & title)
-    { m_border.set_title(title); }
+inline void Frame::set_title(const UString & title) {
+    flag_visual_change();
+    m_border.set_title(title);
+}
 
-inline void Frame::set_title_size(int font_size)
-    { m_border.set_title_size(font_size); }
+inline void Frame::set_title_size(int font_size) {
+    flag_visual_change();
+    m_border.set_title_size(font_size);
+}
 
 inline void Frame::set_drag_enabled(bool b) {
     if (b) m_border.watch_for_drag_events();
@@ -170,6 +170,9 @@ public:
 
     void set_border_size(float pixels);
 
+    /** Adds the title to the prewarmer. */
+    void add_glyphs_to(GlyphPrewarmer &) const;
+
 private:
     void update_drag_position(int drect_x, int drect_y) override;
 
@@ -0,0 +1,227 @@
+/****************************************************************************
+
+    File: GlyphAtlas.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Glyph.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/Shader.hpp>
+
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+namespace ksg {
+
+class Text;
+
+namespace detail {
+
+/** Converts a glyph's coverage (alpha of RGBA pixels) into a distance field.
+ *  @param pixels RGBA pixels of the glyph, width by height
+ *  @param out    RGBA pixels of the distance field, which are larger than the
+ *                glyph by spread on every side, alpha of 0.5 is the glyph's
+ *                edge
+ */
+void make_distance_field(const std::vector<sf::Uint8> & pixels,
+                         int width, int height, int spread,
+                         std::vector<sf::Uint8> & out);
+
+} // end of detail namespace
+
+/** @brief A glyph texture owned by ksg, where glyphs of every font and
+ *         character size share the same pages.
+ *
+ *  SFML keeps a separate glyph texture per character size, so text of
+ *  different sizes (or fonts) can never be drawn together. Text objects
+ *  assigned to the same atlas can be drawn in a single call using a
+ *  TextBatch.
+ *  @n
+ *  Page growth: each page is k_page_width pixels wide, it starts
+ *  k_initial_page_height pixels tall and doubles its height as needed up to
+ *  k_max_page_height. Once a page is at its maximum height and full, a new
+ *  page is started.
+ *  @n
+ *  Glyphs are copied from the font's own textures, pixels are uploaded to the
+ *  atlas on flush, which is called before drawing.
+ *  @n
+ *  Signed distance field mode: each glyph is rasterized once at
+ *  k_distance_field_reference_size, and converted (on the CPU) into a
+ *  distance field. Text of any size is then drawn from that single field
+ *  through a small shader (GLSL 1.10, which software GL implementations
+ *  support). Glyph metrics (advances and bounds) are scaled from the
+ *  reference size too, as SFML offers no way to query them without
+ *  rasterizing. So the font never rasterizes other sizes.
+ *  @warning Distance field mode changes layout metrics: advances and bounds
+ *           are scaled rather than hinted for each size, so text assigned
+ *           to a distance field atlas is measured, wrapped and placed
+ *           differently than the same text in bitmap mode (or without an
+ *           atlas).
+ *  @note fonts must outlive the atlas, glyphs are keyed by font address
+ */
+class GlyphAtlas final {
+public:
+    using UChar = char32_t;
+
+    enum class Mode {
+        k_bitmap,
+        k_distance_field
+    };
+
+    static constexpr const unsigned k_page_width          = 1024;
+    static constexpr const unsigned k_initial_page_height =  128;
+    static constexpr const unsigned k_max_page_height     = 1024;
+
+    static constexpr const unsigned k_distance_field_reference_size = 48;
+    //! pixels (at reference size) the distance field extends past a glyph
+    static constexpr const unsigned k_distance_field_spread = 6;
+
+    struct Entry {
+        //! metrics from the font, the texture rectangle refers to the page
+        sf::Glyph glyph;
+        int page = 0;
+    };
+
+    GlyphAtlas() {}
+
+    explicit GlyphAtlas(Mode);
+
+    GlyphAtlas(const GlyphAtlas &) = delete;
+
+    GlyphAtlas & operator = (const GlyphAtlas &) = delete;
+
+    ~GlyphAtlas();
+
+    /** @returns the atlas entry for the given glyph, placing it if it is not
+     *           already present (its pixels will be uploaded on the next
+     *           flush)
+     */
+    const Entry & glyph(const sf::Font &, unsigned character_size, UChar);
+
+    /** Uploads pixels of all glyphs placed since the last flush. */
+    void flush();
+
+    int page_count() const noexcept { return int(m_pages.size()); }
+
+    const sf::Texture & page_texture(int page) const;
+
+    std::size_t glyph_count() const noexcept { return m_entries.size(); }
+
+    /** @returns bytes of video memory used by all pages */
+    std::size_t byte_size() const noexcept;
+
+    Mode mode() const noexcept { return m_mode; }
+
+    /** @returns the shader needed to draw glyphs from this atlas, null for
+     *           bitmap atlases, and also null if shaders are unavailable (in
+     *           which case distance fields are drawn as is, blurred)
+     */
+    const sf::Shader * shader() const;
+
+private:
+    struct Key {
+        const sf::Font * font;
+        unsigned character_size;
+        UChar character;
+        bool operator == (const Key & rhs) const noexcept {
+            return font == rhs.font && character_size == rhs.character_size
+                && character == rhs.character;
+        }
+    };
+
+    struct KeyHasher {
+        std::size_t operator () (const Key &) const noexcept;
+    };
+
+    struct Shelf {
+        unsigned top = 0, height = 0, next_left = 0;
+    };
+
+    struct Page {
+        sf::Texture texture;
+        std::vector<Shelf> shelves;
+        unsigned next_shelf_top = 0;
+    };
+
+    struct PendingCopy {
+        Key key;
+        // location of the glyph in the font's texture
+        sf::IntRect source;
+        // location in the atlas page
+        sf::IntRect destination;
+        int page = 0;
+        // non-zero for distance fields, destination includes the spread
+        unsigned spread = 0;
+    };
+
+    const Entry & distance_field(const sf::Font &, UChar);
+
+    /** @returns page index and rectangle for a new glyph of the given size */
+    std::pair<int, sf::IntRect> allocate(unsigned width, unsigned height);
+
+    bool allocate_on(Page &, unsigned width, unsigned height, sf::IntRect & out);
+
+    void grow(Page &);
+
+    Page & add_page();
+
+    Mode m_mode = Mode::k_bitmap;
+    std::unordered_map<Key, Entry, KeyHasher> m_entries;
+    // distance field mode only, keyed at the reference size
+    std::unordered_map<Key, Entry, KeyHasher> m_distance_fields;
+    mutable std::unique_ptr<sf::Shader> m_shader;
+    mutable bool m_shader_loaded = false;
+    // pages are referred to by their textures' addresses while drawing
+    std::vector<std::unique_ptr<Page>> m_pages;
+    std::vector<PendingCopy> m_pending;
+};
+
+/** @brief Draws many Text objects, which share a glyph atlas, with as few
+ *         draw calls as possible (one per atlas page).
+ *
+ *  The batch is a snapshot, it should be cleared and refilled if any of the
+ *  added texts change.
+ */
+class TextBatch final : public sf::Drawable {
+public:
+    explicit TextBatch(GlyphAtlas &);
+
+    void clear();
+
+    /** Adds a text's glyphs to the batch.
+     *  @throws std::invalid_argument if the text is not assigned to this
+     *          batch's atlas
+     */
+    void add(const Text &);
+
+    std::size_t quad_count() const noexcept;
+
+private:
+    void draw(sf::RenderTarget &, sf::RenderStates) const override;
+
+    GlyphAtlas * m_atlas;
+    std::vector<std::vector<sf::Vertex>> m_page_vertices;
+};
+
+} // end of ksg namespace
@@ -0,0 +1,111 @@
+/****************************************************************************
+
+    File: GlyphPrewarmer.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <ksg/Text.hpp>
+
+#include <map>
+#include <vector>
+
+namespace ksg {
+
+class Widget;
+
+namespace glyph_sets {
+
+constexpr const char32_t * const k_digits = U"0123456789";
+
+//! all printable ASCII characters, including the space
+constexpr const char32_t * const k_ascii =
+    U" !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`"
+    U"abcdefghijklmnopqrstuvwxyz{|}~";
+
+} // end of glyph_sets namespace
+
+/** @brief Rasterizes glyphs ahead of time, so that they are not rasterized
+ *         the first time they are drawn.
+ *
+ *  SFML rasterizes glyphs lazily, the first frame to show a new character or
+ *  size will stall on the rasterization, and possibly on growing and
+ *  re-uploading the font's glyph texture for that size. This class gathers
+ *  characters per font and size, then rasterizes them all with run.
+ *
+ *  Example, prewarming a frame and a score popup:
+ *  @code
+ksg::GlyphPrewarmer prewarmer;
+prewarmer.add(my_frame); // after the frame's styles are set
+prewarmer.add(font, 48, ksg::glyph_sets::k_digits);
+prewarmer.run();
+    @endcode
+ *  @note fonts must outlive this object, and run must be called from the
+ *        thread which uses the fonts
+ */
+class GlyphPrewarmer final {
+public:
+    using UString = Text::UString;
+
+    struct PageReport {
+        const sf::Font * font = nullptr;
+        int character_size = 0;
+        unsigned width  = 0;
+        unsigned height = 0;
+    };
+
+    /** Adds characters to be rasterized for the given font and size.
+     *  @param character_size sizes less than one are ignored
+     */
+    void add(const sf::Font &, int character_size, const UString & characters);
+
+    void add(const sf::Font &, int character_size, const char32_t * characters);
+
+    void add(const sf::Font &, const std::vector<int> & character_sizes,
+             const UString & characters);
+
+    /** Adds the text's string, with its font and size. Text without an
+     *  assigned font or character size is ignored.
+     */
+    void add(const Text &);
+
+    /** Adds every string of the given widget, and all of its children.
+     *  @note For frames, this should be called after styles have been set,
+     *        as fonts and sizes are unknown before then.
+     */
+    void add(const Widget &);
+
+    /** Rasterizes all characters added since the last call.
+     *  @returns number of glyphs requested from fonts
+     */
+    std::size_t run();
+
+    /** @returns a report of the glyph texture sizes for every font and
+     *           character size this object has ever run against
+     */
+    std::vector<PageReport> report_pages() const;
+
+private:
+    using FontSizePair = std::pair<const sf::Font *, int>;
+
+    std::map<FontSizePair, UString> m_pending;
+    std::vector<FontSizePair> m_warmed;
+};
+
+} // end of ksg namespace
@@ -30,6 +30,7 @@
 #include <common/MultiType.hpp>
 
 #include <ksg/Widget.hpp>
+#include <ksg/TextureBudget.hpp>
 
 namespace ksg {
 
@@ -38,8 +39,24 @@ public:
     using TextureMultiType =
         MultiType<const sf::Texture *, std::shared_ptr<const sf::Texture>, sf::Texture>;
 
+    /** Loads the image from a file, the texture is budgeted.
+     *  @see TextureBudget
+     */
     bool load_from_file(const char * filename) noexcept;
 
+    /** Loads part of an image atlas from a file, the texture is budgeted.
+     *  @param area sub rectangle of the image to load
+     *  @see TextureBudget
+     */
+    bool load_from_file(const char * filename, const sf::IntRect & area) noexcept;
+
+    /** Uploads part of an image atlas, which is kept in main memory, the
+     *  texture is budgeted (the atlas itself is not).
+     *  @see TextureBudget
+     */
+    bool load_from_atlas(std::shared_ptr<const sf::Image> atlas,
+                         const sf::IntRect & area);
+
     void load_from_image(const sf::Image & image);
 
     void set_texture(const sf::Texture & texture_,
@@ -77,7 +94,11 @@ private:
 
     void update_size_post_load();
 
+    bool load_budgeted(detail::BudgetedTexture &&);
+
     TextureMultiType m_texture_storage;
+    // alternative storage for textures that maybe evicted and reloaded
+    detail::BudgetedTexture m_budgeted_texture;
     sf::Sprite   m_spt;
     sf::Vector2f m_size;
 };
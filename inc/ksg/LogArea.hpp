@@ -0,0 +1,145 @@
+/****************************************************************************
+
+    File: LogArea.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <ksg/Text.hpp>
+#include <ksg/Widget.hpp>
+
+#include <deque>
+
+namespace ksg {
+
+/** @brief A LogArea shows the tail of a stream of lines, as a debug console
+ *         would.
+ *
+ *  Lines are kept in a ring buffer of bounded capacity, once full, appending
+ *  a line evicts the oldest. Appending costs time in proportion to the
+ *  appended line only: the new line is laid out on its own, and lines
+ *  already laid out are never laid out again as they scroll (each line is
+ *  simply drawn one row higher). \n
+ *  The view stays pinned to the newest line, unless scrolled back with the
+ *  mouse wheel. Lines are not wrapped, what does not fit the widget's width
+ *  is cut off. \n
+ *  For styles: uses the TextArea's text size and color.
+ */
+class LogArea final : public Widget {
+public:
+    using UString = Text::UString;
+
+    static constexpr const std::size_t k_default_capacity = 1000;
+    static constexpr const int k_lines_per_wheel_step = 3;
+
+    LogArea();
+
+    /** Scrolls with the mouse wheel, scrolling back to the newest line pins
+     *  the view to the tail again.
+     */
+    void process_event(const sf::Event &) override;
+
+    void set_location(float x, float y) override;
+
+    VectorF location() const override { return m_location; }
+
+    float width() const override { return m_size.x; }
+
+    float height() const override { return m_size.y; }
+
+    void set_style(const StyleMap &) override;
+
+    /** Adds the lines in view only. */
+    void add_glyphs_to(GlyphPrewarmer &) const override;
+
+    void set_size(float w, float h);
+
+    /** Appends a line, newlines within it end lines of their own. */
+    void append_line(const UString &);
+
+    /** Sets the number of lines kept, keeping the newest.
+     *  @throws if capacity is zero
+     */
+    void set_capacity(std::size_t);
+
+    std::size_t capacity() const noexcept { return m_ring.size(); }
+
+    /** @returns the number of lines kept */
+    std::size_t line_count() const noexcept
+        { return std::size_t(m_end_sequence - m_begin_sequence); }
+
+    /** @returns a kept line, where line zero is the oldest
+     *  @throws if index is not in [0 line_count())
+     */
+    const UString & line(std::size_t index) const;
+
+    void clear();
+
+    /** Scrolls back the given number of lines from the newest, zero pins
+     *  the view to the tail. It is clamped to the lines kept.
+     */
+    void set_lines_scrolled_back(int);
+
+    int lines_scrolled_back() const noexcept { return m_scrolled_back; }
+
+    bool is_pinned_to_tail() const noexcept { return m_scrolled_back == 0; }
+
+    void set_character_size(int);
+
+    void set_color(sf::Color);
+
+    void assign_font(const sf::Font &);
+
+private:
+    using Sequence = unsigned long long;
+
+    void draw(sf::RenderTarget &, sf::RenderStates) const override;
+
+    void push_line(UString::const_iterator beg, UString::const_iterator end);
+
+    const UString & line_at(Sequence) const;
+
+    int visible_line_count() const;
+
+    // brings laid out lines in line with the view
+    void update_view();
+
+    // lays out every line in view anew (for a style or size change)
+    void refresh_view();
+
+    Text make_line_text(Sequence) const;
+
+    VectorF m_location;
+    VectorF m_size;
+
+    // line with sequence number "s" lives at m_ring[s % capacity()]
+    std::vector<UString> m_ring;
+    Sequence m_begin_sequence = 0;
+    Sequence m_end_sequence   = 0;
+    int m_scrolled_back = 0;
+
+    // styled, but empty, text each line in view is copied from
+    Text m_line_template;
+    // laid out lines in view, front is m_view_begin
+    std::deque<Text> m_view;
+    Sequence m_view_begin = 0;
+};
+
+} // end of ksg namespace
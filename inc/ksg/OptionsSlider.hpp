@@ -51,6 +51,9 @@ public:
 
     void set_style(const StyleMap &) override;
 
+    /** Adds every option, not just the selected one. */
+    void add_glyphs_to(GlyphPrewarmer &) const override;
+
     /** @brief Sets the size of the widget by setting the size of it's interior.
      *
      *  @note The size of the arrows is determined by the height. They are made
@@ -0,0 +1,86 @@
+/****************************************************************************
+
+    File: ParallelTextLayout.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+
+namespace ksg {
+
+class Text;
+
+/** @brief Lays out many texts at once, on several threads.
+ *
+ *  Building a large frame (a list of thousands of file names, say) lays out
+ *  each text as its font, size and string are set. Fonts are not thread
+ *  safe, so instead texts may defer their layouts to this object. Running
+ *  it first gathers every glyph metric the texts need into snapshots,
+ *  rasterizing any missing glyphs, on the calling thread. Texts are then
+ *  laid out by a pool of worker threads which only read the snapshots.
+ *  Layouts are identical to laying out each text one after another.
+ *
+ *  Example:
+ *  @code
+ksg::ParallelTextLayout layouts;
+for (auto & label : labels) layouts.defer(label);
+for (auto & label : labels) {
+    label.assign_font(&font);
+    label.set_character_size(14);
+}
+layouts.run();
+    @endcode
+ *  @note Deferred texts must not be moved or destroyed before they are run,
+ *        and they have no layout (and so zero sizes) until then. run must be
+ *        called from the thread which uses the texts' fonts.
+ */
+class ParallelTextLayout final {
+public:
+    ParallelTextLayout() {}
+
+    /** @param thread_count number of threads to lay out on (including the
+     *         calling thread), zero for as many as the hardware runs
+     */
+    explicit ParallelTextLayout(unsigned thread_count);
+
+    ParallelTextLayout(const ParallelTextLayout &) = delete;
+
+    ParallelTextLayout & operator = (const ParallelTextLayout &) = delete;
+
+    //! runs any texts still deferred
+    ~ParallelTextLayout();
+
+    /** Defers all layouts of the text until run. Texts already deferred (by
+     *  this or any other object) are left as they are.
+     */
+    void defer(Text &);
+
+    /** Lays out every deferred text which changed since it was deferred,
+     *  after which texts lay themselves out as usual again.
+     */
+    void run();
+
+private:
+    std::vector<Text *> m_texts;
+    unsigned m_thread_count = 0;
+};
+
+} // end of ksg namespace
@@ -0,0 +1,202 @@
+/****************************************************************************
+
+    File: PieceTable.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+namespace ksg {
+
+/** A piece table holds a document as a sequence of pieces of two buffers:
+ *  the original (read only) text, and an append only buffer of everything
+ *  inserted since. Edits only ever add or split pieces, so inserting into
+ *  the middle of a large document does not move the document's text.
+ *
+ *  Pieces are kept in a randomized balanced tree (a treap), each node
+ *  holding the length and newline count of its subtree. Positions of
+ *  newlines in both buffers are indexed too. So an edit, finding where a
+ *  line starts, or which line a position is on are each O(log n) (expected)
+ *  in the number of pieces.
+ *
+ *  Every edit is recorded for undo/redo. Consecutive insertions (as from
+ *  typing) are merged into one record, until a newline is typed.
+ */
+class PieceTable final {
+public:
+    using UString = std::u32string;
+    using UChar   = UString::value_type;
+
+    PieceTable() {}
+
+    explicit PieceTable(UString original);
+
+    /** @throws if position is past the end of the document */
+    void insert(std::size_t position, const UString &);
+
+    /** Erases count characters, count is clamped to the end of the document.
+     *  @throws if position is past the end of the document
+     */
+    void erase(std::size_t position, std::size_t count);
+
+    /** @returns false if there is nothing to undo */
+    bool undo();
+
+    /** @returns false if there is nothing to redo */
+    bool redo();
+
+    bool can_undo() const noexcept { return !m_undo_log.empty(); }
+
+    bool can_redo() const noexcept { return !m_redo_log.empty(); }
+
+    void clear_history();
+
+    std::size_t size() const noexcept;
+
+    bool empty() const noexcept { return size() == 0; }
+
+    // one more than the number of newlines
+    int line_count() const noexcept;
+
+    /** @returns position of the line's first character
+     *  @throws if line is not in [0 line_count())
+     */
+    std::size_t line_start(int line) const;
+
+    /** @returns position of the line's end (its newline, or the document's
+     *           end for the last line)
+     */
+    std::size_t line_end(int line) const;
+
+    /** @returns line the given position is on, the document's end is on the
+     *           last line
+     */
+    int line_of(std::size_t position) const;
+
+    /** @returns the line's text, without its newline */
+    UString line(int line) const;
+
+    /** @returns text starting at position, count is clamped to the end of the
+     *           document
+     */
+    UString substring(std::size_t position, std::size_t count) const;
+
+    UString to_string() const;
+
+    std::size_t piece_count() const noexcept
+        { return m_nodes.size() - m_free_nodes.size(); }
+
+private:
+    enum class Source : unsigned char { k_original, k_added };
+
+    struct Piece {
+        Source source;
+        std::size_t start;
+        std::size_t length;
+    };
+
+    struct Buffer {
+        UString text;
+        // positions of each newline in text
+        std::vector<std::size_t> newlines;
+        void append(const UString &);
+    };
+
+    struct EditRecord {
+        bool is_insertion;
+        std::size_t position;
+        UString text;
+    };
+
+    // a node of the piece tree, children are indices into m_nodes
+    struct Node {
+        Piece piece;
+        // newlines in the piece
+        std::size_t newlines;
+        // totals of the subtree, this node and all its descendants
+        std::size_t subtree_length;
+        std::size_t subtree_newlines;
+        std::uint32_t priority;
+        std::size_t left;
+        std::size_t right;
+    };
+
+    struct Split {
+        std::size_t left;
+        std::size_t right;
+    };
+
+    static constexpr const std::size_t k_no_node = std::size_t(-1);
+
+    void insert_without_record(std::size_t position, const UString &);
+
+    void erase_without_record(std::size_t position, std::size_t count);
+
+    std::size_t make_node(const Piece &);
+
+    // frees the node and all its descendants
+    void free_nodes(std::size_t node);
+
+    // splits the tree so that the left part holds the first "position"
+    // characters, a piece spanning the position is cut in two
+    Split split(std::size_t node, std::size_t position);
+
+    // all of left's pieces come before right's
+    std::size_t merge(std::size_t left, std::size_t right);
+
+    // recomputes the node's totals from its children
+    void update_totals(std::size_t node);
+
+    // lengthens the tree's last piece, if it ends where the added buffer
+    // did before the insertion at added_start
+    // @returns true if the piece was lengthened
+    bool extend_last_piece(std::size_t node, std::size_t added_start,
+                           std::size_t length, std::size_t newlines);
+
+    // appends to rv the tree's text in [position position + count)
+    void append_text(std::size_t node, std::size_t position,
+                     std::size_t count, UString & rv) const;
+
+    std::size_t subtree_length(std::size_t node) const noexcept;
+
+    std::size_t subtree_newlines(std::size_t node) const noexcept;
+
+    std::size_t count_newlines(const Piece &, std::size_t length) const;
+
+    const Buffer & buffer_of(const Piece & piece) const;
+
+    Buffer m_original;
+    Buffer m_added;
+    std::vector<Node> m_nodes;
+    // indices of nodes in m_nodes which are no longer in the tree
+    std::vector<std::size_t> m_free_nodes;
+    std::size_t m_root = k_no_node;
+    // state of the xorshift generator, for node priorities
+    std::uint32_t m_priority_state = 2463534242u;
+
+    std::vector<EditRecord> m_undo_log;
+    std::vector<EditRecord> m_redo_log;
+};
+
+} // end of ksg namespace
@@ -0,0 +1,118 @@
+/****************************************************************************
+
+    File: QuadKernels.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <limits>
+
+#include <cstddef>
+
+namespace ksg {
+
+namespace detail {
+
+/** A run of glyph metrics, in structure of arrays form, from which quads are
+ *  made. Each glyph's quad has its top left at (x, y) and the given size,
+ *  and likewise for its texture rectangle.
+ */
+struct GlyphRun {
+    static constexpr const std::size_t k_capacity = 64;
+
+    bool is_full() const noexcept { return size == k_capacity; }
+
+    /** Appends a glyph's metrics.
+     *  @note the run must not be full
+     */
+    void push(float x_, float y_, float width_, float height_,
+              float tex_left_, float tex_top_, float tex_width_,
+              float tex_height_, sf::Color color)
+    {
+        x         [size] = x_;
+        y         [size] = y_;
+        width     [size] = width_;
+        height    [size] = height_;
+        tex_left  [size] = tex_left_;
+        tex_top   [size] = tex_top_;
+        tex_width [size] = tex_width_;
+        tex_height[size] = tex_height_;
+        colors    [size] = color;
+        ++size;
+    }
+
+    std::size_t size = 0;
+    alignas(32) float x         [k_capacity];
+    alignas(32) float y         [k_capacity];
+    alignas(32) float width     [k_capacity];
+    alignas(32) float height    [k_capacity];
+    alignas(32) float tex_left  [k_capacity];
+    alignas(32) float tex_top   [k_capacity];
+    alignas(32) float tex_width [k_capacity];
+    alignas(32) float tex_height[k_capacity];
+    sf::Color colors[k_capacity];
+};
+
+/** Where quads are clipped, this mirrors how Text cuts its characters.
+ *  Quads are cut on the bottom and right first (the limiting dimensions),
+ *  and then on the left and right by the viewport, unless they lie wholly
+ *  in it. Infinite values leave quads uncut.
+ */
+struct QuadClip {
+    float bottom     = std::numeric_limits<float>::infinity();
+    float right      = std::numeric_limits<float>::infinity();
+    float view_left  = -std::numeric_limits<float>::infinity();
+    float view_right = std::numeric_limits<float>::infinity();
+    //! added to positions of quads that are kept
+    sf::Vector2f offset;
+};
+
+enum class QuadKernel {
+    k_scalar,
+    k_sse2,
+    k_avx2
+};
+
+/** @returns the fastest kernel this processor supports, found once */
+QuadKernel best_quad_kernel();
+
+/** @returns true if the kernel maybe used on this processor */
+bool is_quad_kernel_supported(QuadKernel);
+
+/** Turns a run of glyph metrics into quads, clips them, and writes those
+ *  which are not wholly clipped away (as DrawableCharacter::whiped_out) in
+ *  order, four verticies per quad (in DrawableCharacter's order).
+ *  All kernels give results identical to the bit, the scalar kernel (which
+ *  uses DrawableCharacter) is the reference.
+ *  @param out must have room for four verticies per glyph in the run
+ *  @returns number of quads written
+ */
+std::size_t make_clipped_quads
+    (QuadKernel, const GlyphRun &, const QuadClip &, sf::Vertex * out);
+
+/** Same as above, using the best kernel. */
+std::size_t make_clipped_quads
+    (const GlyphRun &, const QuadClip &, sf::Vertex * out);
+
+} // end of detail namespace
+
+} // end of ksg namespace
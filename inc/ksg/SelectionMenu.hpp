@@ -23,6 +23,7 @@
 
 #include <ksg/FocusWidget.hpp>
 #include <ksg/Text.hpp>
+#include <ksg/ParallelTextLayout.hpp>
 
 #include <common/DrawRectangle.hpp>
 
@@ -47,6 +48,9 @@ public:
 
     void set_string(UString &&);
 
+    //! malformed sequences show as the replacement character
+    void set_string(std::string_view utf8);
+
     void process_event(const sf::Event &) override;
 
     void set_location(float x, float y) override;
@@ -63,11 +67,21 @@ public:
 
     void set_style(const StyleMap &) override;
 
+    void add_glyphs_to(GlyphPrewarmer &) const override;
+
     // based on content, not the wrapping
     float content_width() const;
 
+    // as content_width, for a width measured apart from the entry's text
+    float content_width(float text_width) const;
+
     // based on content, not the wrapping
     float content_height() const;
+
+    const Text & display_text() const { return m_display_text; }
+
+    void defer_layout_to(ParallelTextLayout & layouts)
+        { layouts.defer(m_display_text); }
 private:
     void draw(sf::RenderTarget &, sf::RenderStates) const override;
 
@@ -110,6 +124,9 @@ public:
 
     void add_options(std::vector<UString> &&);
 
+    //! malformed sequences show as the replacement character
+    void add_options(const std::vector<std::string> & utf8_options);
+
     EntryIterator begin() { return m_entries.begin(); }
 
     EntryIterator end() { return m_entries.end(); }
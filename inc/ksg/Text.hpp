@@ -53,19 +53,48 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <limits>
+#include <algorithm>
+#include <utility>
+#include <unordered_map>
+
+#include <cstdint>
 
 #include <common/DrawRectangle.hpp>
 #include <common/MultiType.hpp>
 
 #include <ksg/StyleMap.hpp>
 #include <ksg/DrawCharacter.hpp>
+#include <ksg/TextMarkup.hpp>
+#include <ksg/TextLayoutCache.hpp>
+#include <ksg/Utf8.hpp>
 
 namespace ksg {
 
+class GlyphAtlas;
+class TextBatch;
+class ParallelTextLayout;
+
 namespace detail {
 
+class GlyphMetricsSnapshot;
+
+/** Whether a font lays out as monospaced at a size, and its advance. */
+struct MonospaceMetrics {
+    float advance = 0.f;
+    bool is_monospace = false;
+};
+
+/** A text's monospace metrics for its font and size, looked up on first use
+ *  (with and without the monospace hint), and forgotten with its glyphs.
+ */
+struct MonospaceMetricsCache {
+    MonospaceMetrics metrics[2];
+    bool is_known[2] = { false, false };
+};
+
 using FontMtPtr = MultiType<const sf::Font *, std::shared_ptr<const sf::Font>>;
 
 } // end of detail namespace
@@ -81,9 +110,21 @@ using FontMtPtr = MultiType<const sf::Font *, std::shared_ptr<const sf::Font>>;
  *  - can restrict it's text rendering to a rectangle.
  *  - handles multi line text restricted by width.
  *  - automatic word wrapping (greedy) based on restricted width
+ *  - faster layout for monospaced fonts
+ *  - optionally sharing a glyph atlas with other text, so that text of
+ *    different sizes and fonts maybe drawn together (see TextBatch)
+ *  - colors, sizes and fonts for parts of the text, which maybe set with a
+ *    small markup (see set_markup)
+ *  - texts showing the same short strings may share their layouts (see
+ *    TextLayoutCache)
+ *  - many texts maybe laid out at once, on several threads (see
+ *    ParallelTextLayout)
  */
 class Text final : public sf::Drawable {
 public:
+    friend class TextBatch;
+    friend class ParallelTextLayout;
+
     using UString = std::u32string;
     using UChar = UString::value_type;
     using UStringConstIter = UString::const_iterator;
@@ -100,6 +141,39 @@ public:
 
     void set_string(UString && str);
 
+    // the view is copied straight into the text's string, reusing its memory
+    void set_string(std::u32string_view);
+
+    // (spares string literals an ambiguous conversion)
+    void set_string(const UChar *);
+
+    /** Decodes UTF-8 straight into the text's string, reusing its memory.
+     *  Malformed sequences show as the replacement character (see
+     *  decode_utf8).
+     */
+    void set_string(std::string_view utf8);
+
+    /** Inserts a string before the character at the given index. Only text
+     *  after the edit (and the line before it, when wrapping) is laid out
+     *  again.
+     *  @note Without width or height limits, an edit without newlines only
+     *        places the chunks it touches, the rest of its line is moved
+     *        along (no glyphs are looked up), and later lines are left in
+     *        place; though every later character's record is still moved
+     *        in memory, and its extent taken again. Otherwise all text
+     *        after the edit is laid out again (see TextEditor, which lays
+     *        out only the lines in view).
+     *  @throws if index is not in [0 len]
+     */
+    void insert(int index, const UString &);
+
+    /** Erases count characters starting at index, count is clamped to the
+     *  end of the string. Only text after the edit is laid out again.
+     *  @note Costs as insert does.
+     *  @throws if index is not in [0 len], or count is negative
+     */
+    void erase(int index, int count);
+
     void set_limiting_width(float w);
 
     void set_limiting_height(float h);
@@ -116,6 +190,17 @@ public:
 
     void relieve_size_limit();
 
+    /** Draws only a horizontal window of the text, scrolled by the given
+     *  offset, glyphs outside of it are not drawn and those on its edges are
+     *  cut. Scrolling does not cause any relayout, and the text's
+     *  dimensions are not affected.
+     *  @param offset how far the text is scrolled to the left
+     *  @param width  of the window, starting at the text's location
+     */
+    void set_viewport(float offset, float width);
+
+    void relieve_viewport();
+
     void set_character_size(int);
 
     void set_color(sf::Color);
@@ -132,16 +217,96 @@ public:
     template <typename KeyType>
     bool assign_font(const StyleMap &, const KeyType &);
 
+    /** Sets where glyph textures are taken from.
+     *  @param atlas a glyph atlas, which must outlive this object, or null to
+     *         use the font's own textures (the default)
+     */
+    void assign_glyph_atlas(GlyphAtlas * atlas);
+
+    GlyphAtlas * glyph_atlas() const noexcept { return m_glyph_atlas; }
+
+    /** Monospaced fonts are detected automatically, and laid out without
+     *  per character glyph and kerning lookups. Hinting that the font is
+     *  monospaced skips checking its kerning table (the advances are still
+     *  checked).
+     */
+    void set_monospace_hint(bool);
+
+    bool has_monospace_hint() const noexcept { return m_monospace_hint; }
+
+    /** Colors a single character, as a span of one.
+     *  @throws if index is not in [0 len)
+     */
     void set_color_for_character(int index, sf::Color clr);
 
+    /** Colors characters in [begin end), overriding any span there.
+     *  Spans belong to the string rather than its layout: they are moved
+     *  by insert/erase, kept when the string is set (those past its end
+     *  are dropped), and left untouched by any relayout. Characters
+     *  outside of all spans take the color set by set_color.
+     *  @throws if not 0 <= begin <= end <= len
+     */
+    void set_color_span(int begin, int end, sf::Color clr);
+
+    void clear_color_spans();
+
+    /** Sets the string from markup, which is compiled into the plain string,
+     *  color spans and runs of other fonts and sizes. Tags nest, and maybe
+     *  left open:
+     *  - [color=#rrggbb], [color=#rrggbbaa] or [color=name] ... [/color]
+     *  - [size=n] ... [/size]
+     *  - [font=name] ... [/font]
+     *  and "[[" is a literal '['. Names are looked up in the given styles.
+     *
+     *  The text is laid out again only if the compiled string, spans or
+     *  runs differ from what it shows (so named styles changed since are
+     *  picked up), and all styles are laid out together. Every line is as
+     *  tall as the largest style's line spacing.
+     *  Like color spans, runs of other fonts and sizes belong to the string,
+     *  markup without any tags clears them.
+     *  @throws std::invalid_argument if the markup is malformed, or names a
+     *          color or font not in the styles (the text is then unchanged)
+     */
+    void set_markup(const UString & markup);
+
+    void set_markup(const UString & markup, const StyleMap & named_styles);
+
+    /** @returns the string, escaped so that set_markup shows it as is */
+    static UString escape_markup(const UString &);
+
     VectorF character_location(int index) const;
 
+    // Queries on the laid out text, these use a table of each character's
+    // offset from the start of its line, which is built with the layout.
+
+    /** @returns number of laid out lines (wrapped lines included) */
+    int line_count() const noexcept;
+
+    /** Finds the character boundary closest to a point, in O(log n).
+     *  @param point in the same space as location(), as drawn (that is
+     *         with the viewport's scroll)
+     *  @returns an index in [0 len], suitable for placing a cursor
+     */
+    int character_index_at(VectorF point) const;
+
+    /** @returns the number of characters, from the start of the first line,
+     *           which fit in the given width
+     */
+    int fitting_prefix_length(float width) const;
+
+    /** @param index in [0 len]
+     *  @returns horizontal offset from the start of the character's line to
+     *           the character (pen position, and not the glyph's bounds)
+     */
+    float character_offset(int index) const;
+
     VectorF location() const;
 
     float width() const;
 
     float height() const;
 
+    // the largest line spacing among the text's styles
     float line_height() const;
 
     const UString & string() const;
@@ -177,10 +342,29 @@ public:
     static float measure_width
         (const sf::Font &, int character_size, UStringConstIter beg, UStringConstIter end);
 
+    /** Measures the single line widths of many strings at once, each
+     *  exactly as measure_width would. Advances and kerning are looked up
+     *  once per distinct character (and pair) for the whole batch.
+     *  @param in_parallel allows summing widths on several threads, which
+     *         only pays off for very large batches (smaller ones are
+     *         measured on the calling thread regardless)
+     *  @returns each string's width, in order
+     */
+    static std::vector<float> measure_widths
+        (const sf::Font &, int character_size, const std::vector<UString> &,
+         bool in_parallel = false);
+
+    static std::vector<float> measure_widths
+        (const sf::Font &, int character_size,
+         const std::vector<const UString *> &, bool in_parallel = false);
+
     static float maximum_height
         (const sf::Font &, int character_size, UStringConstIter beg, UStringConstIter end);
 
     static void run_tests();
+
+    /** Runs tests which lay out text, and so need a font. */
+    static void run_tests(const sf::Font &);
 private:
     /** SFML draw, draws all verticies of the text.
      *  @param target Target of all draws.
@@ -190,26 +374,134 @@ private:
 
     const sf::Font * font_ptr() const noexcept;
 
-    void place_renderables(std::vector<detail::DrawableCharacter> &) const;
+    // @param metrics if not null, read instead of the font (whole, unstyled
+    //        layouts only)
+    // @returns index of the first character placed
+    std::size_t place_renderables
+        (int edit_index, const detail::GlyphMetricsSnapshot * metrics = nullptr);
+
+    // Lays out an edit to text without constraints, which neither adds nor
+    // removes newlines, by placing only the chunks the edit touches and
+    // moving the rest of their line. Per character arrays must already be
+    // spliced for the edit, line and chunk tables are still the old
+    // string's.
+    // @returns false if the text must be laid out after the edit instead
+    bool place_edit_within_line(int index, int removed, int inserted);
 
-    // cuts/removes renderables that fall outside of width/height constraints
-    void cut_renderables(std::vector<detail::DrawableCharacter> &) const;
+    // cuts renderables that fall outside of width/height constraints
+    void cut_renderables(std::size_t start);
+
+    // re-breaks lines over cached chunk widths and moves renderables to
+    // their new lines, without any glyph lookups
+    // @returns false if the layout must be placed anew instead
+    bool rewrap_renderables();
 
     void update_geometry();
 
+    // spans past the string's end are dropped, and it's laid out anew
+    void update_after_new_string();
+
+    void update_bounds();
+
+    // expands visible characters into quads, as cut by the width and
+    // height constraints and the viewport, and appends them
+    // @param page if not negative, only characters on this atlas page
+    void append_verticies
+        (std::vector<sf::Vertex> &, VectorF offset, int page) const;
+
+    // glyph quads belong to a font, size and atlas, changing any of them
+    // leaves no layout
+    void reset_glyph_quads();
+
+    // copies the layout if it's shared, so that it maybe changed
+    void unshare_layout();
+
+    // @returns true if the layout maybe looked up in, or offered to, the
+    //          layout cache
+    bool is_layout_cacheable() const noexcept;
+
+    detail::TextLayoutKey layout_cache_key() const;
+
+    // the largest char size among the text's styles, glyphs are placed on a
+    // baseline this far below their line's top
+    int baseline_offset() const;
+
+    // text before the edit is laid out as it was
+    void update_geometry_after(int edit_index);
+
+    // drops the layout, which is redone when the deferring
+    // ParallelTextLayout runs
+    void defer_layout();
+
+    // lays out every given text with a pending layout, and stops deferring
+    static void lay_out_deferred(const std::vector<Text *> &, unsigned thread_count);
+
+    // true if renderables and tables all correspond to the string
+    bool has_layout() const noexcept;
+
+    int line_of(int index) const noexcept;
+
+    // @returns a line, at or before the given line, where layout may resume
+    //          and whether that line's first chunk was wrapped
+    std::pair<int, bool> find_resumable_line
+        (int line, int last_unchanged) const noexcept;
+
+    bool has_line_table() const noexcept;
+
+    bool has_chunk_table() const noexcept;
+
+    // @returns start of the chunk which holds the given index
+    std::size_t chunk_begin_of(std::size_t index) const noexcept;
+
+    // the end of the line is the start of the next one
+    int line_end(int line) const noexcept;
+
     using FontMtPtr = detail::FontMtPtr;
     FontMtPtr m_font_ptr;
     UString m_string;
 
-    std::vector<detail::DrawableCharacter> m_renderables;
-    // next iterator to the next chunk of text alternating between
-    // breakable and unbreakable
-    std::vector<UString::const_iterator> m_next_chunk;
+    // Characters, lines and chunks as laid out. Characters are stored as
+    // records, in a structure of arrays, with one element per character:
+    // - glyph_origins: origin of the character's quad
+    // - glyph_ids: index into glyph_quads (the distinct glyphs used by this
+    //   text, for its styles and atlas), characters without a quad (e.g.
+    //   newlines) refer to the first quad, which is empty
+    // - extents: running maximum of visible characters' right/bottom edges
+    // - character_offsets: pen position of each character (and the end)
+    //   from the start of its line, a wrapped line's first character is
+    //   therefore zero
+    // Lines are tables of where each begins in the string, and the pen
+    // position at its end. Chunks are tables of where each ends in the
+    // string, its measured width (as checked against the width constraint)
+    // and how far it moves the pen.
+    // The layout maybe shared with other texts (see TextLayoutCache), and
+    // must be unshared before it's changed.
+    std::shared_ptr<detail::TextLayout> m_layout = std::make_shared<detail::TextLayout>();
+    // sorted, non overlapping and non empty ranges of the string and their
+    // colors
+    using ColorSpan = detail::ColorSpan;
+    std::vector<ColorSpan> m_color_spans;
+    // fonts and sizes other than the text's own, and where they are used
+    // (likewise sorted, non overlapping and non empty)
+    std::vector<detail::TextStyle> m_styles;
+    std::vector<detail::StyleRun> m_style_runs;
+    GlyphAtlas * m_glyph_atlas = nullptr;
+    // found for the font and size, so that measuring needs no shared lookup
+    detail::MonospaceMetricsCache m_monospace_metrics;
+    // line tables from before the last rewrap, kept for their memory
+    std::vector<int> m_spare_line_starts;
+    std::vector<float> m_spare_line_widths;
     int m_char_size = styles::get_unset_value<int>();
     sf::FloatRect m_bounds;
+    float m_viewport_offset = 0.f;
+    float m_viewport_width = k_inf;
     float m_width_constraint = k_inf;
     float m_height_constraint = k_inf;
     bool m_allow_bottom_cuts = false;
+    bool m_monospace_hint = false;
+    // see ParallelTextLayout
+    bool m_is_layout_deferred = false;
+    bool m_has_pending_layout = false;
     sf::Color m_color;
 };
 
@@ -225,6 +517,7 @@ bool Text::assign_font(const StyleMap & map, const KeyType & key_type) {
     } else {
         return false;
     }
+    reset_glyph_quads();
     update_geometry();
     return true;
 }
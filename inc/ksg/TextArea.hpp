@@ -24,13 +24,28 @@
 #include <ksg/Text.hpp>
 #include <ksg/Frame.hpp>
 
+namespace sf { class View; }
+
 namespace ksg {
 
+namespace detail {
+
+/** @returns a copy of the (unrotated) view, which shows only what lies
+ *           between top and bottom (clamped to the view), as a scissor would
+ */
+sf::View clip_view_vertically(const sf::View &, float top, float bottom);
+
+} // end of detail namespace
+
 void set_if_present(Text &, const StyleMap &, const char * font_field,
                     const char * char_size_field, const char * text_color);
 
 /** @brief A TextArea is an invisible rectangle wrapped around some blob of
  *         text.
+ *
+ *  For long content (log dumps, help pages...) virtual lines may be enabled.
+ *  Then only an index of where each line starts is kept for the whole
+ *  string, and only lines in view (plus a small margin) are laid out.
  */
 class TextArea final : public Widget {
 public:
@@ -39,6 +54,8 @@ public:
     static constexpr const char * const k_text_color = "text-area-text-color";
     static constexpr const char * const k_text_size  = "text-area-text-size" ;
     static constexpr const float k_unassigned_size = -1.f;
+    // lines laid out beyond either edge of the view, with virtual lines
+    static constexpr const int k_virtual_line_margin = 16;
 
     TextArea();
 
@@ -56,6 +73,8 @@ public:
 
     void set_style(const StyleMap &) override;
 
+    void add_glyphs_to(GlyphPrewarmer &) const override;
+
     // <----------------------------- TextWidget ----------------------------->
 
     [[deprecated]] void set_text(const UString & str);
@@ -64,13 +83,26 @@ public:
 
     void set_string(const UString & str);
 
-    const UString & string() const { return m_draw_text.string(); }
+    void set_string(std::u32string_view);
+
+    void set_string(const Text::UChar *);
 
-    void set_color_for_index(int index, sf::Color c)
-        { m_draw_text.set_color_for_character(index, c); }
+    //! malformed sequences show as the replacement character
+    void set_string(std::string_view utf8);
 
-    void set_color(sf::Color c)
-        { m_draw_text.set_color(c); }
+    const UString & string() const;
+
+    /** @throws if virtual lines are enabled */
+    void set_color_for_index(int index, sf::Color c);
+
+    /** Colors characters in [begin end), see Text::set_color_span.
+     *  @throws if virtual lines are enabled
+     */
+    void set_color_span(int begin, int end, sf::Color c);
+
+    void clear_color_spans();
+
+    void set_color(sf::Color c);
 
     void set_character_size(int size_);
 
@@ -99,6 +131,34 @@ public:
     int character_size() const
         { return m_draw_text.character_size(); }
 
+    // <---------------------------- Virtual Lines ---------------------------->
+
+    /** With virtual lines, the string is not laid out as a whole. Lines are
+     *  not wrapped, what does not fit the maximum width is cut off. The text
+     *  is not centered, but placed at the area's top left, and scrolls
+     *  within the area's height (or maximum height). Lines partly scrolled
+     *  out of the area are cut at its edges.
+     */
+    void enable_virtual_lines();
+
+    void disable_virtual_lines();
+
+    bool has_virtual_lines() const noexcept { return m_virtual_lines; }
+
+    /** Scrolls the content up by the given number of pixels, clamped so
+     *  that the view is not scrolled past the last line. Only lines newly
+     *  scrolled past the laid out margin are laid out.
+     *  @note only has an effect with virtual lines
+     */
+    void set_scroll_offset(float);
+
+    float scroll_offset() const noexcept { return m_scroll_offset; }
+
+    /** @returns the number of lines with virtual lines, otherwise the
+     *           number of lines the text is laid out on
+     */
+    int line_count() const;
+
 protected:
     void draw(sf::RenderTarget & target, sf::RenderStates) const override;
 
@@ -107,12 +167,43 @@ protected:
 private:
     void recompute_geometry();
 
+    // follows any change of the string (virtual or not)
+    void update_after_new_string();
+
     void set_max_width_no_update(float w);
 
     void set_max_height_no_update(float h);
 
+    void index_virtual_lines();
+
+    float view_height() const;
+
+    float max_scroll_offset() const;
+
+    // lays out lines which have come into view (plus margin), with force,
+    // every line in view is laid out anew
+    void update_virtual_window(bool force);
+
+    Text make_line_text(int line) const;
+
     sf::FloatRect m_bounds = sf::FloatRect(0.f, 0.f, k_unassigned_size, k_unassigned_size);
+    // with virtual lines, this holds no string and is the template each
+    // line's text is copied from
     Text m_draw_text;
+
+    float m_max_width  = k_unassigned_size;
+    float m_max_height = k_unassigned_size;
+
+    bool m_virtual_lines = false;
+    float m_scroll_offset = 0.f;
+    UString m_virtual_string;
+    // where each line starts in the virtual string
+    std::vector<std::size_t> m_line_starts;
+    // laid out lines, m_window[0] is line m_window_begin, each is laid out
+    // at the area's top left and only moved to its line as it's drawn (so
+    // that positions stay small, however far down the lines are)
+    std::vector<Text> m_window;
+    int m_window_begin = 0;
 };
 
 } // end of ksg namespace
@@ -39,12 +39,21 @@ public:
 
     void set_string(const UString & str);
 
+    void set_string(std::u32string_view);
+
+    void set_string(const Text::UChar *);
+
+    //! malformed sequences show as the replacement character
+    void set_string(std::string_view utf8);
+
     void set_style(const StyleMap &) override;
 
     void set_location(float x, float y) override;
 
     void issue_auto_resize() override;
 
+    void add_glyphs_to(GlyphPrewarmer &) const override;
+
 private:
     /** Sets the maximum size of the text button.
      *  @param w width in pixels
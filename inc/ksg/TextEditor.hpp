@@ -0,0 +1,174 @@
+/****************************************************************************
+
+    File: TextEditor.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <ksg/Text.hpp>
+#include <ksg/FocusWidget.hpp>
+#include <ksg/PieceTable.hpp>
+
+#include <common/DrawRectangle.hpp>
+
+namespace ksg {
+
+/** @brief The TextEditor Widget allows a user to edit multiple lines of text.
+ *
+ *  The document is held in a piece table, so edits anywhere in a large
+ *  document are cheap, and may be undone/redone. Only the lines in view are
+ *  laid out and drawn (each as its own Text), so the cost of drawing does
+ *  not grow with the document's length. \n
+ *  The editor scrolls vertically to keep the cursor in view, and may also be
+ *  scrolled by the mouse wheel. Lines are not wrapped, what does not fit
+ *  the widget's width is cut off. \n
+ *  For styles: uses the same styles as the EditableText widget.
+ */
+class TextEditor final : public FocusWidget {
+public:
+    using UString   = PieceTable::UString;
+    using BlankFunc = std::function<void()>;
+
+    TextEditor();
+
+    /** When not in focus: clicking inside the editor requests focus and
+     *  places the cursor, and the mouse wheel scrolls.
+     */
+    void process_event(const sf::Event &) override;
+
+    /** Inserts a burst of typed characters as one edit. */
+    void process_text_burst(const UString &) override;
+
+    void set_location(float x, float y) override;
+
+    VectorF location() const override;
+
+    float width() const override;
+
+    float height() const override;
+
+    void set_style(const StyleMap &) override;
+
+    /** Adds the lines in view only. */
+    void add_glyphs_to(GlyphPrewarmer &) const override;
+
+    void set_size(float w, float h);
+
+    /** Replaces the whole document, and clears undo history. */
+    void set_string(UString);
+
+    UString string() const { return m_document.to_string(); }
+
+    const PieceTable & document() const noexcept { return m_document; }
+
+    int line_count() const noexcept { return m_document.line_count(); }
+
+    /** Inserts the string at the cursor, as one edit. */
+    void insert_at_cursor(const UString &);
+
+    /** @throws if position is not in [0 document().size()] */
+    void set_cursor_position(std::size_t);
+
+    std::size_t cursor_position() const noexcept { return m_cursor; }
+
+    /** @returns false if there was nothing to undo */
+    bool undo();
+
+    /** @returns false if there was nothing to redo */
+    bool redo();
+
+    /** Scrolls so that the given line is the first in view, the line is
+     *  clamped to the document.
+     */
+    void set_top_line(int);
+
+    int top_line() const noexcept { return m_top_line; }
+
+    void set_character_size(int);
+
+    void set_text_change_event(BlankFunc &&);
+
+private:
+    void process_focus_event(const sf::Event &) override;
+
+    void notify_focus_gained() override;
+
+    void notify_focus_lost() override;
+
+    void draw(sf::RenderTarget & target, sf::RenderStates states) const override;
+
+    static constexpr const int k_lines_per_wheel_step = 3;
+
+    void update_geometry();
+
+    // typed characters are inserted, control characters are not
+    void insert_typed(UString);
+
+    void erase_characters(std::size_t position, std::size_t count);
+
+    void on_text_edited();
+
+    // clamps the position to the document
+    void move_cursor(std::size_t position);
+
+    // moves the cursor to the same column of another line
+    void move_cursor_by_lines(int line_delta);
+
+    // scrolls (if needed) so that the cursor's line is in view
+    void scroll_to_cursor();
+
+    void update_cursor();
+
+    // re-lays out the lines in view starting from document line "first"
+    void refresh_lines(int first);
+
+    int visible_line_count() const;
+
+    int cursor_line() const { return m_document.line_of(m_cursor); }
+
+    float line_height() const;
+
+    float padding() const noexcept;
+
+    float inner_padding() const noexcept;
+
+    PieceTable m_document;
+    std::size_t m_cursor = 0;
+    int m_top_line = 0;
+
+    // styled, but empty, text each line in view is copied from
+    Text m_line_template;
+    // one for each line in view, m_lines[0] is document line m_top_line
+    std::vector<Text> m_lines;
+
+    DrawRectangle m_outer = styles::make_rect_with_unset_color();
+    DrawRectangle m_inner = styles::make_rect_with_unset_color();
+    DrawRectangle m_cursor_rect;
+
+    sf::Color m_focus_color = styles::get_unset_value<sf::Color>();
+    sf::Color m_reg_color   = styles::get_unset_value<sf::Color>();
+
+    float m_padding       = styles::get_unset_value<float>();
+    float m_inner_padding = styles::get_unset_value<float>();
+
+    BlankFunc m_change_text_func = [](){};
+};
+
+} // end of ksg namespace
@@ -0,0 +1,201 @@
+/****************************************************************************
+
+    File: TextLayoutCache.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <ksg/DrawCharacter.hpp>
+
+#include <SFML/Graphics/Font.hpp>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <list>
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
+#include <cstdint>
+
+namespace ksg {
+
+class GlyphAtlas;
+class Text;
+class TextLayoutCache;
+
+namespace detail {
+
+/** A text's laid out characters, lines and chunks (see Text for what each
+ *  table holds). Positions are relative to the text's location, so one
+ *  layout serves any number of texts wherever they are placed.
+ */
+struct TextLayout {
+    using VectorF = sf::Vector2f;
+
+    // @returns approximate heap memory used by the tables
+    std::size_t byte_size() const noexcept;
+
+    std::vector<VectorF> glyph_origins;
+    std::vector<std::uint32_t> glyph_ids;
+    std::vector<VectorF> extents;
+    std::vector<GlyphQuad> glyph_quads = std::vector<GlyphQuad>(1);
+    std::unordered_map<std::uint64_t, std::uint32_t> glyph_ids_by_char;
+    std::vector<float> character_offsets;
+    std::vector<int> line_starts;
+    std::vector<float> line_widths;
+    std::vector<int> chunk_ends;
+    std::vector<float> chunk_widths;
+    std::vector<float> chunk_advances;
+    // true if any character may have been cut
+    bool has_cuts = false;
+};
+
+/** Everything besides the string that a layout depends on. */
+struct TextLayoutKey {
+    const sf::Font * font = nullptr;
+    // guards against a new font reusing an old font's address
+    std::string font_family;
+    const GlyphAtlas * atlas = nullptr;
+    int char_size = 0;
+    float width_constraint = 0.f;
+    float height_constraint = 0.f;
+    bool monospace_hint = false;
+    std::size_t string_hash = 0;
+
+    bool operator == (const TextLayoutKey &) const noexcept;
+
+    std::size_t hash() const noexcept;
+};
+
+} // end of detail namespace
+
+/** @brief Shares layouts between texts showing the same string with the
+ *         same font, size and limits.
+ *
+ *  Texts look up the cache whenever they are laid out from scratch. A hit
+ *  shares the cached layout, which is copied only once the text is changed
+ *  (copy on write). A string is cached the second time it is laid out, so
+ *  strings which are only ever seen once (counters, clocks and the like)
+ *  pass through without evicting anything. Only non empty strings of up to
+ *  k_max_string_length characters without markup styles are cached.
+ *  @n
+ *  Entries over the byte limit are evicted, least recently used first.
+ *  Evicted layouts stay alive for as long as texts share them. The cache
+ *  is off until a byte limit is set (k_suggested_byte_limit suits most
+ *  interfaces).
+ *  @warning Layouts refer to fonts and atlases by address. Atlases forget
+ *           their entries as they are destroyed, and so does
+ *           FontRegistry::forget_font. Entries are also keyed by the font's
+ *           family, so a font of another family at the same address misses.
+ *           Otherwise forget_font must be called before the font is
+ *           destroyed (if any text using it was laid out).
+ *  @note Lookups are guarded by a mutex, so texts may be laid out on any
+ *        thread.
+ */
+class TextLayoutCache final {
+public:
+    static constexpr const std::size_t k_suggested_byte_limit = std::size_t(4) << 20;
+    static constexpr const std::size_t k_max_string_length  = 256;
+
+    struct Counters {
+        std::size_t entry_count    = 0;
+        std::size_t byte_count     = 0;
+        std::size_t hit_count      = 0;
+        std::size_t miss_count     = 0;
+        std::size_t insert_count   = 0;
+        std::size_t eviction_count = 0;
+    };
+
+    TextLayoutCache(const TextLayoutCache &) = delete;
+
+    TextLayoutCache & operator = (const TextLayoutCache &) = delete;
+
+    static TextLayoutCache & instance();
+
+    /** Sets the maximum number of bytes cached layouts may occupy, evicting
+     *  entries immediately if needed. A limit of zero disables the cache.
+     */
+    void set_byte_limit(std::size_t);
+
+    std::size_t byte_limit() const;
+
+    Counters counters() const;
+
+    /** Resets the hit, miss, insert and eviction counters. */
+    void reset_event_counters();
+
+    /** Drops every entry (texts keep the layouts they share). */
+    void clear();
+
+    /** Drops entries laid out with the given font. */
+    void forget_font(const sf::Font *);
+
+    /** Drops entries laid out with the given atlas. */
+    void forget_atlas(const GlyphAtlas *);
+
+private:
+    friend class ksg::Text;
+    using LayoutPtr = std::shared_ptr<detail::TextLayout>;
+    using Key       = detail::TextLayoutKey;
+
+    struct Entry {
+        Key key;
+        std::u32string string;
+        LayoutPtr layout;
+        std::size_t byte_size = 0;
+    };
+    using EntryList = std::list<Entry>;
+
+    struct KeyHasher {
+        std::size_t operator () (const Key & key) const noexcept
+            { return key.hash(); }
+    };
+
+    // recent strings which missed, a string is inserted on its second miss
+    static constexpr const std::size_t k_recent_miss_count = 256;
+
+    TextLayoutCache() {}
+
+    // @returns a cached layout, or null
+    LayoutPtr find(const Key &, const std::u32string &);
+
+    // offers a fresh layout, following a miss
+    void offer(const Key &, const std::u32string &, const LayoutPtr &);
+
+    void evict_over_limit();
+
+    template <typename Func>
+    void erase_if(Func && f);
+
+    void erase(EntryList::iterator);
+
+    mutable std::mutex m_mutex;
+    // front is the most recently used
+    EntryList m_lru;
+    std::unordered_multimap<Key, EntryList::iterator, KeyHasher> m_entries;
+    std::array<std::size_t, k_recent_miss_count> m_recent_misses {};
+    std::size_t m_next_recent_miss = 0;
+    std::size_t m_byte_limit = 0;
+    Counters m_counters;
+};
+
+} // end of ksg namespace
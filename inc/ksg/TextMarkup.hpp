@@ -0,0 +1,91 @@
+/****************************************************************************
+
+    File: TextMarkup.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <ksg/StyleMap.hpp>
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Font.hpp>
+
+#include <vector>
+#include <string>
+#include <memory>
+
+namespace ksg {
+
+namespace detail {
+
+/** A range of a text's string and the color its characters are drawn in. */
+struct ColorSpan {
+    int begin, end;
+    sf::Color color;
+};
+
+/** A font and size which parts of a text are set in, in place of the text's
+ *  own.
+ */
+struct TextStyle {
+    // null for the text's own font
+    const sf::Font * font = nullptr;
+    // keeps a font from the style map alive (may be null)
+    std::shared_ptr<const sf::Font> font_owner;
+    // less than 1 for the text's own size
+    int char_size = 0;
+};
+
+/** A range of a text's string set in a style.
+ *  style indexes the text's styles from one, zero being its own font and
+ *  size (which no run refers to).
+ */
+struct StyleRun {
+    int begin, end;
+    int style;
+};
+
+/** The result of compiling markup. Spans and runs are sorted, non
+ *  overlapping and non empty, and styles are distinct.
+ */
+struct CompiledMarkup {
+    std::u32string string;
+    std::vector<ColorSpan> color_spans;
+    std::vector<TextStyle> styles;
+    std::vector<StyleRun> style_runs;
+};
+
+/** Compiles markup into a plain string, with its color spans and style
+ *  runs (see Text::set_markup for the syntax).
+ *  @param named_styles colors and fonts that tags may refer to by name
+ *  @throws std::invalid_argument if the markup is malformed, or refers to a
+ *          name which is not in named_styles
+ */
+CompiledMarkup compile_markup
+    (const std::u32string & markup, const StyleMap & named_styles);
+
+/** @returns the string, with each '[' doubled so that it is not read as
+ *           the start of a tag
+ */
+std::u32string escape_markup(const std::u32string &);
+
+} // end of detail namespace
+
+} // end of ksg namespace
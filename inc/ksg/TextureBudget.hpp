@@ -0,0 +1,178 @@
+/****************************************************************************
+
+    File: TextureBudget.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#pragma once
+
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Image.hpp>
+
+#include <list>
+#include <string>
+#include <memory>
+#include <limits>
+
+namespace ksg {
+
+class TextureBudget;
+
+namespace detail {
+
+/** @brief A texture which is owned by the process wide TextureBudget, and
+ *         which may be evicted from video memory and later reloaded from its
+ *         source.
+ *
+ *  The source is either a file (optionally a sub rectangle of it, for image
+ *  atlases stored on disk) or a shared image atlas kept in main memory.
+ *  Eviction and reloading are caching concerns, and so they are permitted
+ *  on constant instances.
+ *  @note Copies share the source, but not the texture. A copy is not
+ *        resident until it is first acquired.
+ */
+class BudgetedTexture {
+public:
+    using ImagePtr = std::shared_ptr<const sf::Image>;
+
+    BudgetedTexture() {}
+
+    BudgetedTexture(const std::string & filename, const sf::IntRect & area);
+
+    BudgetedTexture(ImagePtr atlas, const sf::IntRect & area);
+
+    BudgetedTexture(const BudgetedTexture &);
+
+    ~BudgetedTexture();
+
+    BudgetedTexture & operator = (const BudgetedTexture &);
+
+    /** @returns true if there is a source to (re)load the texture from */
+    bool has_source() const noexcept;
+
+    /** Makes the texture resident (reloading it if evicted), and marks it as
+     *  the most recently used texture.
+     *  @returns true if the texture is resident following this call
+     */
+    bool acquire() const;
+
+    bool is_resident() const noexcept { return m_resident; }
+
+    /** @returns the texture, which is empty if it is not resident */
+    const sf::Texture & texture() const noexcept { return m_texture; }
+
+    std::size_t byte_size() const noexcept;
+
+    void swap(BudgetedTexture &);
+
+private:
+    friend class ksg::TextureBudget;
+    using LruPosition = std::list<const BudgetedTexture *>::iterator;
+
+    bool load_from_source() const;
+
+    void evict() const;
+
+    std::string m_filename;
+    ImagePtr m_atlas;
+    sf::IntRect m_area;
+
+    mutable sf::Texture m_texture;
+    mutable bool m_resident = false;
+    mutable bool m_loaded_before = false;
+    // only meaningful while resident
+    mutable LruPosition m_lru_position;
+};
+
+} // end of detail namespace
+
+/** @brief Keeps the video memory used by budgeted textures under a limit,
+ *         evicting the least recently drawn textures first.
+ *
+ *  Textures loaded by ImageWidget::load_from_file and
+ *  ImageWidget::load_from_atlas are budgeted. A texture counts as used when
+ *  its widget is drawn, so images belonging to hidden frames naturally age
+ *  out. Evicted textures are reloaded from their source on their next draw.
+ *  @n
+ *  By default there is no limit, and so nothing is ever evicted.
+ *  @warning Like the rest of this library, this is not thread safe. All
+ *           budgeted textures should be loaded and drawn from one thread.
+ *  @note If the textures drawn in a single frame exceed the limit, they will
+ *        be reloaded every frame, the limit should be chosen with the largest
+ *        visible set of images in mind.
+ */
+class TextureBudget final {
+public:
+    static constexpr const std::size_t k_no_limit =
+        std::numeric_limits<std::size_t>::max();
+
+    struct Counters {
+        std::size_t resident_count  = 0;
+        std::size_t resident_bytes  = 0;
+        std::size_t reload_count    = 0;
+        std::size_t eviction_count  = 0;
+        std::size_t failed_loads    = 0;
+    };
+
+    TextureBudget(const TextureBudget &) = delete;
+
+    TextureBudget & operator = (const TextureBudget &) = delete;
+
+    static TextureBudget & instance();
+
+    /** Sets the maximum number of bytes that resident budgeted textures may
+     *  occupy, evicting textures immediately if needed.
+     */
+    void set_byte_limit(std::size_t);
+
+    std::size_t byte_limit() const noexcept { return m_byte_limit; }
+
+    const Counters & counters() const noexcept { return m_counters; }
+
+    /** Resets the reload, eviction and failed load counters. Residency
+     *  counters are unaffected.
+     */
+    void reset_event_counters();
+
+private:
+    friend class detail::BudgetedTexture;
+    using BudgetedTexture = detail::BudgetedTexture;
+
+    TextureBudget() {}
+
+    void on_loaded(const BudgetedTexture &, bool is_reload);
+
+    void on_used(const BudgetedTexture &);
+
+    void on_released(const BudgetedTexture &);
+
+    void on_failed_load() { ++m_counters.failed_loads; }
+
+    /** Evicts least recently used textures, until the limit is satisfied.
+     *  @param keep a texture which must not be evicted (the one that was just
+     *         made resident), may be null
+     */
+    void evict_over_limit(const BudgetedTexture * keep);
+
+    // front is the most recently used
+    std::list<const BudgetedTexture *> m_lru;
+    std::size_t m_byte_limit = k_no_limit;
+    Counters m_counters;
+};
+
+} // end of ksg namespace
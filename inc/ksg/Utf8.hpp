@@ -0,0 +1,63 @@
+/****************************************************************************
+
+    File: Utf8.hpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include <cstddef>
+
+namespace ksg {
+
+//! what decoding does with malformed UTF-8
+enum class Utf8Errors {
+    //! throws std::invalid_argument at the first malformed sequence
+    k_throw,
+    //! each malformed sequence (its longest valid looking prefix, or a
+    //! single byte) is decoded as U+FFFD, the replacement character
+    k_replace
+};
+
+constexpr const char32_t k_replacement_character = U'\uFFFD';
+
+/** Decodes UTF-8 into UTF-32, validating it as it goes. Overlong forms,
+ *  surrogates, code points past U+10FFFF, and truncated or stray sequences
+ *  are all malformed.
+ *
+ *  Runs of ASCII (the common case for UI strings) are checked and widened
+ *  sixteen bytes at a time with SSE2, where it's available.
+ *  @param out replaced by the decoded string, its memory is reused
+ *  @throws std::invalid_argument for malformed UTF-8, if errors are to be
+ *          thrown (out is then left unspecified)
+ */
+void decode_utf8(std::string_view, std::u32string & out,
+                 Utf8Errors = Utf8Errors::k_throw);
+
+std::u32string decode_utf8(std::string_view, Utf8Errors = Utf8Errors::k_throw);
+
+/** @returns the byte index of the first malformed sequence, or the view's
+ *           size if it's all valid UTF-8
+ */
+std::size_t find_invalid_utf8(std::string_view) noexcept;
+
+} // end of ksg namespace
@@ -36,6 +36,7 @@ namespace ksg {
 
 class FocusWidget;
 class Widget;
+class GlyphPrewarmer;
 
 /** @brief Child widget iterator enables a way to iterate all the child widgets
  *         for some given parent widget.
@@ -92,6 +93,13 @@ public:
      */
     virtual void issue_auto_resize();
 
+    /** @brief Adds the strings this widget renders (but not those of its
+     *         children) to the given prewarmer.
+     *  @note The default behavior is to add nothing.
+     *  @see GlyphPrewarmer
+     */
+    virtual void add_glyphs_to(GlyphPrewarmer &) const;
+
     template <typename Func>
     void iterate_children_f(Func &&);
 
@@ -103,14 +111,34 @@ public:
 
     void iterate_children(ChildWidgetIterator &);
     void iterate_children(ChildWidgetIterator &) const;
-    void set_visible(bool v) { m_visible = v; }
+    void set_visible(bool v) {
+        m_visible = v;
+        flag_visual_change();
+    }
 
     bool is_visible() const { return m_visible; }
+
+    /** Tells any frame caching its drawing (see Frame::set_render_caching)
+     *  that this widget may look different from when it was last drawn.
+     *  Widgets flag their own changes, and frames flag those made by events,
+     *  this is for changes made some other way (e.g. by a derived widget).
+     */
+    void flag_visual_change() noexcept { m_has_visual_change = true; }
+
+    bool has_visual_change() const noexcept { return m_has_visual_change; }
+
 protected:
     virtual void iterate_children_(ChildWidgetIterator &);
     virtual void iterate_const_children_(ChildWidgetIterator &) const;
 private:
+    friend class Frame;
+
+    // (cleared by the frame caching this widget's drawing, as it's drawn)
+    void clear_visual_change() const noexcept { m_has_visual_change = false; }
+
     bool m_visible;
+    // new widgets are yet to be drawn
+    mutable bool m_has_visual_change = true;
 };
 
 template <typename Func>
@@ -5,7 +5,7 @@ CONFIG  -= c++11
 
 QMAKE_CXXFLAGS += -std=c++17
 QMAKE_LFLAGS   += -std=c++17
-LIBS           += -ltinyxml2 -lsfml-graphics -lsfml-window -lsfml-system -lz \
+LIBS           += -ltinyxml2 -lsfml-graphics -lsfml-window -lsfml-system -lz -lpthread \
                   -L/usr/lib/x86_64-linux-gnu
 
 linux {
@@ -43,6 +43,19 @@ SOURCES += \
     ../src/TextButton.cpp    \
     ../src/Frame.cpp         \
     ../src/SelectionMenu.cpp \
+    ../src/TextureBudget.cpp \
+    ../src/GlyphPrewarmer.cpp \
+    ../src/GlyphAtlas.cpp    \
+    ../src/PieceTable.cpp    \
+    ../src/TextEditor.cpp    \
+    ../src/LogArea.cpp       \
+    ../src/QuadKernels.cpp   \
+    ../src/TextMarkup.cpp    \
+    ../src/TextLayoutCache.cpp \
+    ../src/ParallelTextLayout.cpp \
+    ../src/Utf8.cpp \
+    ../src/FontRegistry.cpp \
+    ../src/CompactText.cpp \
     ../demos/textarea-tests.cpp
 
 HEADERS += \
@@ -68,7 +81,20 @@ HEADERS += \
     ../inc/ksg/FrameBorder.hpp    \
     ../inc/ksg/EditableText.hpp   \
     ../inc/ksg/TextArea.hpp       \
-    ../inc/ksg/SelectionMenu.hpp
+    ../inc/ksg/SelectionMenu.hpp  \
+    ../inc/ksg/TextureBudget.hpp  \
+    ../inc/ksg/GlyphPrewarmer.hpp \
+    ../inc/ksg/GlyphAtlas.hpp     \
+    ../inc/ksg/PieceTable.hpp     \
+    ../inc/ksg/TextEditor.hpp     \
+    ../inc/ksg/LogArea.hpp        \
+    ../inc/ksg/QuadKernels.hpp    \
+    ../inc/ksg/TextMarkup.hpp     \
+    ../inc/ksg/TextLayoutCache.hpp \
+    ../inc/ksg/ParallelTextLayout.hpp \
+    ../inc/ksg/Utf8.hpp \
+    ../inc/ksg/FontRegistry.hpp \
+    ../inc/ksg/CompactText.hpp
 
 INCLUDEPATH += \
     ../inc           \
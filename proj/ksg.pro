@@ -3,8 +3,8 @@ TEMPLATE = lib
 CONFIG  += staticlib
 CONFIG  -= c++11
 
-QMAKE_CXXFLAGS += -std=c++14
-QMAKE_LFLAGS   += -std=c++14
+QMAKE_CXXFLAGS += -std=c++17
+QMAKE_LFLAGS   += -std=c++17
 LIBS           += -ltinyxml2 -lsfml-graphics -lsfml-window -lsfml-system -lz \
                   -L/usr/lib/x86_64-linux-gnu
 
@@ -43,7 +43,20 @@ SOURCES += \
     ../src/Text.cpp          \
     ../src/Widget.cpp        \
     ../src/EditableText.cpp  \
-    ../src/FocusWidget.cpp
+    ../src/FocusWidget.cpp   \
+    ../src/TextureBudget.cpp \
+    ../src/GlyphPrewarmer.cpp \
+    ../src/GlyphAtlas.cpp    \
+    ../src/PieceTable.cpp    \
+    ../src/TextEditor.cpp    \
+    ../src/LogArea.cpp       \
+    ../src/QuadKernels.cpp   \
+    ../src/TextMarkup.cpp    \
+    ../src/TextLayoutCache.cpp \
+    ../src/ParallelTextLayout.cpp \
+    ../src/Utf8.cpp \
+    ../src/FontRegistry.cpp \
+    ../src/CompactText.cpp
 
 HEADERS += \
     \ # private headers
@@ -67,7 +80,20 @@ HEADERS += \
     ../inc/ksg/Visitor.hpp        \
     ../inc/ksg/ForwardWidgets.hpp \
     ../inc/ksg/EditableText.hpp   \
-    ../inc/ksg/FocusWidget.hpp
+    ../inc/ksg/FocusWidget.hpp    \
+    ../inc/ksg/TextureBudget.hpp  \
+    ../inc/ksg/GlyphPrewarmer.hpp \
+    ../inc/ksg/GlyphAtlas.hpp     \
+    ../inc/ksg/PieceTable.hpp     \
+    ../inc/ksg/TextEditor.hpp     \
+    ../inc/ksg/LogArea.hpp        \
+    ../inc/ksg/QuadKernels.hpp    \
+    ../inc/ksg/TextMarkup.hpp     \
+    ../inc/ksg/TextLayoutCache.hpp \
+    ../inc/ksg/ParallelTextLayout.hpp \
+    ../inc/ksg/Utf8.hpp \
+    ../inc/ksg/FontRegistry.hpp \
+    ../inc/ksg/CompactText.hpp
 
 INCLUDEPATH += \
     ../inc           \
@@ -30,6 +30,7 @@ namespace ksg {
 ArrowButton::ArrowButton(): m_dir(Direction::k_none) {}
 
 void ArrowButton::set_direction(Direction dir_) {
+    flag_visual_change();
     if (m_dir == dir_) return;
     m_dir = dir_;
     update_points();
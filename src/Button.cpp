@@ -76,6 +76,7 @@ void Button::process_event(const sf::Event & evnt) {
 }
 
 void Button::set_location(float x, float y) {
+    flag_visual_change();
     float old_x = location().x, old_y = location().y;
     m_outer.set_position(x, y);
     m_inner.set_position(x + std::max(m_padding, 0.f), y + std::max(m_padding, 0.f));
@@ -85,6 +86,7 @@ void Button::set_location(float x, float y) {
 }
 
 void Button::set_style(const StyleMap & smap) {
+    flag_visual_change();
     using namespace styles;
 
     set_if_found(smap, k_hover_back_color     , m_hover.back );
@@ -107,6 +109,7 @@ void Button::press() {
 }
 
 void Button::set_size(float width_, float height_) {
+    flag_visual_change();
     if (width_ <= 0.f || height_ <= 0.f) {
         throw InvalidArg("ksg::Button::set_size: width and height must be "
                          "positive real numbers (which excludes zero)."    );
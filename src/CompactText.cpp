@@ -0,0 +1,302 @@
+/****************************************************************************
+
+    File: CompactText.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include <ksg/CompactText.hpp>
+#include <ksg/QuadKernels.hpp>
+#include <ksg/Utf8.hpp>
+
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using UChar      = ksg::CompactText::UChar;
+using UString    = ksg::CompactText::UString;
+using VectorF    = ksg::CompactText::VectorF;
+using FontHandle = ksg::CompactText::FontHandle;
+
+constexpr const float k_inf = std::numeric_limits<float>::infinity();
+
+// shared by all compact texts, so that quads are expanded into the same
+// memory each draw
+std::vector<sf::Vertex> & draw_buffer();
+
+} // end of <anonymous> namespace
+
+namespace ksg {
+
+/* static */ constexpr const std::size_t CompactText::k_inline_length;
+/* static */ constexpr const std::size_t CompactText::k_max_length;
+/* static */ constexpr const CompactText::TableId CompactText::k_no_table;
+
+CompactText::CompactText(const CompactText & rhs):
+    m_location   (rhs.m_location   ),
+    m_size       (rhs.m_size       ),
+    m_color      (rhs.m_color      ),
+    m_char_size  (rhs.m_char_size  ),
+    m_font       (rhs.m_font       ),
+    m_glyph_table(rhs.m_glyph_table)
+{
+    reserve(rhs.m_length);
+    m_length = rhs.m_length;
+    std::copy(rhs.chars (), rhs.chars () + m_length, chars ());
+    std::copy(rhs.glyphs(), rhs.glyphs() + m_length, glyphs());
+}
+
+CompactText::CompactText(CompactText && rhs) noexcept:
+    CompactText()
+{ *this = std::move(rhs); }
+
+CompactText::~CompactText() { free_heap_storage(); }
+
+CompactText & CompactText::operator = (const CompactText & rhs) {
+    if (this != &rhs) {
+        CompactText temp(rhs);
+        *this = std::move(temp);
+    }
+    return *this;
+}
+
+CompactText & CompactText::operator = (CompactText && rhs) noexcept {
+    if (this == &rhs) return *this;
+    free_heap_storage();
+    m_location    = rhs.m_location;
+    m_size        = rhs.m_size;
+    m_color       = rhs.m_color;
+    m_char_size   = rhs.m_char_size;
+    m_font        = rhs.m_font;
+    m_glyph_table = rhs.m_glyph_table;
+    m_length      = rhs.m_length;
+    m_capacity    = rhs.m_capacity;
+    if (rhs.is_inline()) {
+        std::copy(rhs.m_inline.chars , rhs.m_inline.chars  + m_length, m_inline.chars );
+        std::copy(rhs.m_inline.glyphs, rhs.m_inline.glyphs + m_length, m_inline.glyphs);
+    } else {
+        m_heap = rhs.m_heap;
+        rhs.m_capacity = 0;
+    }
+    rhs.m_length = 0;
+    rhs.m_size   = VectorF();
+    return *this;
+}
+
+void CompactText::set_string(std::u32string_view str) {
+    if (str.size() > k_max_length) {
+        throw std::length_error("CompactText::set_string: string may not be "
+                                "longer than k_max_length.");
+    }
+    // (the view maybe of this text's own string, which reserve may free)
+    std::less<const UChar *> less;
+    if (!str.empty() && !less(str.data(), chars()) &&
+        less(str.data(), chars() + m_length))
+    { return set_string(UString(str)); }
+
+    reserve(str.size());
+    std::copy(str.begin(), str.end(), chars());
+    m_length = std::uint16_t(str.size());
+    update_geometry();
+}
+
+void CompactText::set_string(const UChar * str)
+    { set_string(std::u32string_view(str)); }
+
+void CompactText::set_string(std::string_view utf8) {
+    // decoded strings are short lived, so one buffer serves every text
+    static thread_local UString decoded;
+    decode_utf8(utf8, decoded, Utf8Errors::k_replace);
+    set_string(std::u32string_view(decoded));
+}
+
+void CompactText::set_character_size(int char_size) {
+    m_char_size = char_size;
+    update_geometry();
+}
+
+void CompactText::set_color(sf::Color color) { m_color = color; }
+
+void CompactText::set_location(float x, float y) {
+    m_location.x = x;
+    m_location.y = y;
+}
+
+void CompactText::set_location(VectorF r) { set_location(r.x, r.y); }
+
+void CompactText::assign_font(FontHandle handle) {
+    // (throws for handles never given out)
+    FontRegistry::instance().font(handle);
+    m_font = handle;
+    update_geometry();
+}
+
+void CompactText::assign_font(const sf::Font * font)
+    { assign_font(FontRegistry::instance().register_font(font)); }
+
+void CompactText::assign_font(const std::shared_ptr<const sf::Font> & font)
+    { assign_font(FontRegistry::instance().register_font(font)); }
+
+std::u32string_view CompactText::string() const noexcept
+    { return std::u32string_view(chars(), m_length); }
+
+bool CompactText::is_visible() const noexcept
+    { return m_length != 0 && has_font_assigned(); }
+
+std::size_t CompactText::heap_byte_size() const noexcept
+    { return std::size_t(m_capacity)*(sizeof(PlacedGlyph) + sizeof(UChar)); }
+
+/* private */ void CompactText::draw
+    (sf::RenderTarget & target, sf::RenderStates states) const
+{
+    if (!has_layout() || m_length == 0) return;
+    auto & registry = FontRegistry::instance();
+    auto & verticies = draw_buffer();
+    verticies.clear();
+    {
+    auto lock = registry.lock_tables();
+    const auto & table = registry.table(m_glyph_table);
+    // (the font was forgotten)
+    if (!table.font()) return;
+    states.texture = &table.font()->getTexture(unsigned(m_char_size));
+
+    // (the same quads as Text makes without limits)
+    detail::GlyphRun run;
+    detail::QuadClip clip;
+    auto flush_run = [&verticies, &clip, &run]() {
+        const auto old_size = verticies.size();
+        verticies.resize(old_size + run.size*4);
+        auto count = detail::make_clipped_quads(run, clip, verticies.data() + old_size);
+        verticies.resize(old_size + count*4);
+        run.size = 0;
+    };
+    const float baseline = float(m_char_size);
+    for (const auto * glyph = glyphs(); glyph != glyphs() + m_length; ++glyph) {
+        if (glyph->glyph_id == 0) continue;
+        const auto & quad = table.quad(glyph->glyph_id);
+        const auto & texture_rect = quad.texture_rect;
+        run.push(glyph->x,
+                 float(glyph->line)*table.line_spacing() + quad.bounds.top + baseline,
+                 quad.bounds.width, quad.bounds.height, texture_rect.left,
+                 texture_rect.top, texture_rect.width, texture_rect.height,
+                 m_color);
+        if (run.is_full()) flush_run();
+    }
+    flush_run();
+    }
+    if (verticies.empty()) return;
+    states.transform.translate(m_location);
+    target.draw(verticies.data(), verticies.size(), sf::Quads, states);
+}
+
+/* private */ void CompactText::update_geometry() {
+    m_size = VectorF();
+    m_glyph_table = k_no_table;
+    if (!has_font_assigned() || m_char_size < 1) return;
+
+    auto & registry = FontRegistry::instance();
+    auto lock = registry.lock_tables();
+    const auto * font = registry.m_fonts[m_font].font;
+    // (the font was forgotten)
+    if (!font) return;
+    const auto table_id = registry.glyph_table(m_font, m_char_size);
+    auto & table = registry.table(table_id);
+
+    // (mirrors Text's layout, for a text without limits)
+    const auto * str = chars();
+    auto * out = glyphs();
+    const auto char_size = unsigned(m_char_size);
+    const int baseline = m_char_size;
+    float pen = 0.f;
+    std::uint16_t line = 0;
+    VectorF extent(-k_inf, -k_inf);
+    for (std::size_t i = 0; i != m_length; ++i) {
+        if (str[i] == U'\n') {
+            // a run of newlines breaks the line once
+            if (i == 0 || str[i - 1] != U'\n') {
+                ++line;
+                pen = 0.f;
+            }
+            out[i] = PlacedGlyph { 0.f, 0, line };
+            continue;
+        }
+        const auto id = table.glyph_id(str[i]);
+        const auto & quad = table.quad(id);
+        out[i] = PlacedGlyph { pen + quad.bounds.left, id, line };
+        VectorF origin(out[i].x, float(line)*table.line_spacing() + quad.bounds.top + baseline);
+        detail::DrawableCharacter renderable(origin, quad, m_color);
+        if (!renderable.whiped_out()) {
+            extent.x = std::max(extent.x, renderable.location().x + renderable.width ());
+            extent.y = std::max(extent.y, renderable.location().y + renderable.height());
+        }
+        pen += quad.advance;
+        if (i + 1 != m_length) pen += font->getKerning(str[i], str[i + 1], char_size);
+    }
+    m_glyph_table = table_id;
+    m_size.x = std::max(0.f, extent.x);
+    m_size.y = std::max(0.f, extent.y);
+}
+
+/* private */ CompactText::UChar * CompactText::chars() noexcept
+    { return is_inline() ? m_inline.chars : m_heap.chars; }
+
+/* private */ const CompactText::UChar * CompactText::chars() const noexcept
+    { return is_inline() ? m_inline.chars : m_heap.chars; }
+
+/* private */ CompactText::PlacedGlyph * CompactText::glyphs() noexcept
+    { return is_inline() ? m_inline.glyphs : m_heap.glyphs; }
+
+/* private */ const CompactText::PlacedGlyph * CompactText::glyphs() const noexcept
+    { return is_inline() ? m_inline.glyphs : m_heap.glyphs; }
+
+/* private */ void CompactText::reserve(std::size_t length) {
+    // strings which fit go back inline, freeing any heap memory
+    if (length <= k_inline_length) return free_heap_storage();
+    if (length <= m_capacity) return;
+
+    // both arrays are of four byte aligned types
+    void * block = ::operator new(length*(sizeof(PlacedGlyph) + sizeof(UChar)));
+    free_heap_storage();
+    m_heap.glyphs = static_cast<PlacedGlyph *>(block);
+    m_heap.chars  = reinterpret_cast<UChar *>(m_heap.glyphs + length);
+    m_capacity    = std::uint16_t(length);
+}
+
+/* private */ void CompactText::free_heap_storage() noexcept {
+    if (is_inline()) return;
+    ::operator delete(m_heap.glyphs);
+    // (the string goes with its memory)
+    m_capacity = 0;
+    m_length   = 0;
+}
+
+} // end of ksg namespace
+
+namespace {
+
+std::vector<sf::Vertex> & draw_buffer() {
+    static thread_local std::vector<sf::Vertex> verticies;
+    return verticies;
+}
+
+} // end of <anonymous> namespace
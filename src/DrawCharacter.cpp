@@ -21,8 +21,6 @@
 
 #include <ksg/DrawCharacter.hpp>
 
-#include <SFML/Graphics/RenderTarget.hpp>
-
 #include <common/Util.hpp>
 
 #include <cassert>
@@ -42,25 +40,39 @@ constexpr const int k_bottom_left_index  = 3;
 
 namespace detail {
 
+GlyphQuad::GlyphQuad(const sf::Glyph & glyph, int page_):
+    bounds(glyph.bounds),
+    texture_rect(glyph.textureRect),
+    advance(glyph.advance),
+    page(page_)
+{}
+
 DrawableCharacter::DrawableCharacter(VectorF loc, const sf::Glyph & glyph, sf::Color clr):
     DrawableCharacter(glyph, clr)
 {
     set_location(loc.x, loc.y);
 }
 
-DrawableCharacter::DrawableCharacter(const sf::Glyph & glyph, sf::Color clr) {
+DrawableCharacter::DrawableCharacter(const sf::Glyph & glyph, sf::Color clr):
+    DrawableCharacter(VectorF(glyph.bounds.left, glyph.bounds.top),
+                      GlyphQuad(glyph, 0), clr)
+{}
+
+DrawableCharacter::DrawableCharacter
+    (VectorF loc, const GlyphQuad & quad, sf::Color clr)
+{
     using Vector2f = sf::Vector2f;
 
-    float left   = glyph.bounds.left;
-    float top    = glyph.bounds.top;
-    float right  = glyph.bounds.left + glyph.bounds.width;
-    float bottom = glyph.bounds.top  + glyph.bounds.height;
+    float left   = loc.x;
+    float top    = loc.y;
+    float right  = loc.x + quad.bounds.width;
+    float bottom = loc.y + quad.bounds.height;
 
     // abbr: texture, left/top/right/bottom
-    float trL = float(glyph.textureRect.left);
-    float trT = float(glyph.textureRect.top);
-    float trR = float(glyph.textureRect.left + glyph.textureRect.width);
-    float trB = float(glyph.textureRect.top  + glyph.textureRect.height);
+    float trL = quad.texture_rect.left;
+    float trT = quad.texture_rect.top;
+    float trR = quad.texture_rect.left + quad.texture_rect.width;
+    float trB = quad.texture_rect.top  + quad.texture_rect.height;
 
     // Add a quad for the current character
     m_verticies[k_top_left_index    ] = sf::Vertex(Vector2f(left , top   ), clr, Vector2f(trL, trT));
@@ -114,6 +126,30 @@ void DrawableCharacter::cut_on_right(float cut_line) {
     check_invarients();
 }
 
+void DrawableCharacter::cut_on_left(float cut_line) {
+    sf::Vertex & tl = m_verticies[k_top_left_index];
+    sf::Vertex & bl = m_verticies[k_bottom_left_index];
+    const sf::Vertex & any_right = m_verticies[k_top_right_index];
+
+    // do not do a cut, if the line is far away from the character
+    if (cut_line < tl.position.x) return;
+
+    // if the cut line exceeds the draw character's bounds, reduce its width
+    // to zero
+    if (cut_line > any_right.position.x) {
+        tl.position.x = bl.position.x = any_right.position.x;
+        check_invarients();
+        return;
+    }
+
+    float cut_ratio = (cut_line - tl.position.x)/
+                      (any_right.position.x - tl.position.x);
+    float tx_width = any_right.texCoords.x - tl.texCoords.x;
+    tl.position.x = bl.position.x = cut_line;
+    tl.texCoords.x = bl.texCoords.x = tl.texCoords.x + tx_width*cut_ratio;
+    check_invarients();
+}
+
 void DrawableCharacter::cut_on_bottom(float cut_line) {
     sf::Vertex & bl = m_verticies[k_bottom_left_index];
     sf::Vertex & br = m_verticies[k_bottom_right_index];
@@ -163,15 +199,20 @@ bool DrawableCharacter::whiped_out() const {
     return magnitude(width()) < 1.f || magnitude(height()) < 1.f;
 }
 
-/* private final */ void DrawableCharacter::draw
-    (sf::RenderTarget & target, sf::RenderStates states) const
+void DrawableCharacter::append_verticies_to
+    (std::vector<sf::Vertex> & verticies, VectorF offset) const
 {
-    const sf::Vertex & tl = m_verticies[k_top_left_index];
-    const sf::Vertex & br = m_verticies[k_bottom_right_index];
-    if (   magnitude(tl.position.x - br.position.x) < 0.5f
-        || magnitude(tl.position.y - br.position.y) < 0.5f)
-        return;
-    target.draw(&m_verticies[0], m_verticies.size(), sf::Quads, states);
+    for (sf::Vertex vtx : m_verticies) {
+        vtx.position += offset;
+        verticies.push_back(vtx);
+    }
+}
+
+void DrawableCharacter::write_verticies(sf::Vertex * out, VectorF offset) const {
+    for (sf::Vertex vtx : m_verticies) {
+        vtx.position += offset;
+        *out++ = vtx;
+    }
 }
 
 /* private */ void DrawableCharacter::check_invarients() const {
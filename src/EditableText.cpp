@@ -23,8 +23,10 @@
 #include <ksg/Button.hpp>
 #include <ksg/Frame.hpp>
 #include <ksg/TextArea.hpp>
+#include <ksg/GlyphPrewarmer.hpp>
 
 #include <SFML/Window/Event.hpp>
+#include <SFML/Window/Clipboard.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 
 namespace {
@@ -34,79 +36,13 @@ using UString = ksg::EditableText::UString;
 
 sf::FloatRect to_rect(const DrawRectangle &);
 
+// delete is handled as a key press
+bool is_control_character(UString::value_type);
+
 } // end of <anonymous> namespace
 
 namespace ksg {
 
-namespace detail {
-
-void Ellipsis::set_size(float w, float h) {
-    m_back.set_size(w, h);
-    update_dots();
-}
-
-void Ellipsis::set_location(float x, float y) {
-    m_back.set_position(x, y);
-    update_dots();
-}
-
-/* static */ VectorF Ellipsis::point_a_for(int i) {
-    float y = (i / 3) ? k_bottom_line : k_top_line;
-    switch (i % 3) {
-    case 0: return VectorF(k_hmargin + 1*k_inner_step, y);
-    case 1: return VectorF(k_hmargin + 4*k_inner_step, y);
-    case 2: return VectorF(k_hmargin + 7*k_inner_step, y);
-    }
-    throw; // reaching here is not possible, but the compiler thinks so
-}
-
-/* static */ VectorF Ellipsis::point_b_for(int i) {
-    switch (i % 3) {
-    case 0: return VectorF(k_hmargin + 0*k_inner_step, 0.5f);
-    case 1: return VectorF(k_hmargin + 3*k_inner_step, 0.5f);
-    case 2: return VectorF(k_hmargin + 6*k_inner_step, 0.5f);
-    }
-    throw; // reaching here is not possible, but the compiler thinks so
-}
-
-/* static */ VectorF Ellipsis::point_c_for(int i) {
-    switch (i % 3) {
-    case 0: return VectorF(k_hmargin + 2*k_inner_step, 0.5f);
-    case 1: return VectorF(k_hmargin + 5*k_inner_step, 0.5f);
-    case 2: return VectorF(k_hmargin + 8*k_inner_step, 0.5f);
-    }
-    throw; // reaching here is not possible, but the compiler thinks so
-}
-
-/* private */ void Ellipsis::update_dots() {
-    m_back.set_color(sf::Color(100, 100, 100));
-
-    auto denormalize = [this](VectorF r) {
-        r.x *= m_back.width();
-        r.y *= m_back.height();
-        return r + m_back.position();
-    };
-    for (int i = 0; i != k_dot_shape_count; ++i) {
-        m_dots[i].set_color(sf::Color(30, 40, 10));
-        m_dots[i].set_point_a(denormalize(point_a_for(i)));
-        m_dots[i].set_point_b(denormalize(point_b_for(i)));
-        m_dots[i].set_point_c(denormalize(point_c_for(i)));
-    }
-}
-
-/* private */ void Ellipsis::draw
-    (sf::RenderTarget & target, sf::RenderStates states) const
-{
-    target.draw(m_back, states);
-    for (const auto & tri : m_dots) {
-        target.draw(tri);
-    }
-}
-
-} // end of detail namespace
-
-// ----------------------------------------------------------------------------
-
 /* static */ constexpr const char * const EditableText::k_background_color   ;
 /* static */ constexpr const char * const EditableText::k_ellipsis_back_color;
 
@@ -117,11 +53,17 @@ void EditableText::process_event(const sf::Event & event) {
         VectorF pos(float(event.mouseButton.x), float(event.mouseButton.y));
         if (to_rect(m_outer).contains(pos)) {
             request_focus();
+            m_cursor_index = m_text.character_index_at(pos);
+            update_cursor();
         }
     }
 }
 
+void EditableText::process_text_burst(const UString & characters)
+    { insert_typed(characters); }
+
 void EditableText::set_location(float x, float y) {
+    flag_visual_change();
     m_outer.set_position(x, y);
     update_geometry();
 }
@@ -136,6 +78,7 @@ float EditableText::height() const
     { return m_outer.height(); }
 
 void EditableText::set_style(const StyleMap & map) {
+    flag_visual_change();
     using namespace styles;
     if (!set_if_color_found(map, k_background_color, m_inner)) {
         m_inner.set_color(sf::Color::White);
@@ -179,27 +122,38 @@ void EditableText::set_style(const StyleMap & map) {
     update_geometry();
 }
 
+void EditableText::add_glyphs_to(GlyphPrewarmer & prewarmer) const
+    { prewarmer.add(m_text); }
+
 void EditableText::set_width(float w) {
+    flag_visual_change();
     m_outer.set_width(w);
     update_geometry();
 }
 
-void EditableText::set_text(const UString & str) {
-    m_text.set_string(str);
-    update_geometry();
-}
+void EditableText::set_text(const UString & str)
+    { set_string(str); }
 
 void EditableText::set_string(const UString & ustr) {
+    flag_visual_change();
     m_text.set_string(ustr);
+    m_cursor_index = character_count();
     update_geometry();
 }
 
-void EditableText::set_cursor_position(int) {
-
+void EditableText::set_cursor_position(int index) {
+    flag_visual_change();
+    if (index < 0 || index > character_count()) {
+        throw std::out_of_range(
+            "EditableText::set_cursor_position: index must be [0 "
+            "character_count()].");
+    }
+    m_cursor_index = index;
+    update_cursor();
 }
 
 int EditableText::character_count() const
-    { return m_text.character_size(); }
+    { return int(m_text.string().size()); }
 
 const UString & EditableText::text() const
     { return m_text.string(); }
@@ -207,43 +161,49 @@ const UString & EditableText::text() const
 const UString & EditableText::string() const
     { return m_text.string(); }
 
-void EditableText::set_character_size(int size)
-    { m_text.set_character_size(size); }
+void EditableText::set_character_size(int size) {
+    flag_visual_change();
+    m_text.set_character_size(size);
+}
 
 void EditableText::set_character_filter(CharFilterFunc && f)
     { m_filter_func = std::move(f); }
 
+void EditableText::set_edit_filter(EditFilterFunc && f)
+    { m_edit_filter_func = std::move(f); }
+
 void EditableText::set_text_change_event(BlankFunc && f)
     { m_change_text_func = std::move(f); }
 
+void EditableText::set_edit_event(EditFunc && f)
+    { m_edit_func = std::move(f); }
+
 float EditableText::max_text_width() const
     { return width() - padding()*2.f - inner_padding()*2.f; }
 
 void EditableText::process_focus_event(const sf::Event & event) {
     if (event.type == sf::Event::TextEntered) {
-        if (event.text.unicode < 10) return;
-
-        bool needed_ellipsis = need_ellipsis();
-        UString new_string;
-        new_string.reserve(1 + m_text.string().size());
-        new_string = m_text.string();
-        new_string.push_back(event.text.unicode);
-
-        if (m_filter_func(new_string)) {
-            m_text.set_string(new_string);
-            update_cursor();
-            if (need_ellipsis() != needed_ellipsis) {
-                update_geometry();
-            }
-            m_change_text_func();
-        }
+        insert_typed(UString(1, UString::value_type(event.text.unicode)));
     }
     if (event.type == sf::Event::KeyPressed) {
-        if (event.key.code == sf::Keyboard::BackSpace && !m_text.string().empty()) {
-            auto new_string = m_text.string();
-            new_string.pop_back();
-            m_text.set_string(new_string);
-            update_cursor();
+        switch (event.key.code) {
+        case sf::Keyboard::BackSpace:
+            if (m_cursor_index > 0) erase_characters(m_cursor_index - 1, 1);
+            break;
+        case sf::Keyboard::Delete:
+            erase_characters(m_cursor_index, 1);
+            break;
+        case sf::Keyboard::Left : move_cursor(m_cursor_index - 1); break;
+        case sf::Keyboard::Right: move_cursor(m_cursor_index + 1); break;
+        case sf::Keyboard::Home : move_cursor(0                 ); break;
+        case sf::Keyboard::End  : move_cursor(character_count() ); break;
+        case sf::Keyboard::V:
+            if (event.key.control) {
+                auto pasted = sf::Clipboard::getString().toUtf32();
+                insert_typed(UString(pasted.begin(), pasted.end()));
+            }
+            break;
+        default: break;
         }
     }
 }
@@ -260,8 +220,7 @@ void EditableText::notify_focus_lost()
     target.draw(m_outer, states);
     target.draw(m_inner, states);
     target.draw(m_text , states);
-    if (need_ellipsis()) { target.draw(m_ellipsis, states); }
-    if (has_focus    ()) { target.draw(m_cursor  , states); }
+    if (has_focus()) { target.draw(m_cursor, states); }
 }
 
 /* private */ void EditableText::update_geometry() {
@@ -272,23 +231,96 @@ void EditableText::notify_focus_lost()
     auto total_height = padding()*2.f + inner_padding()*2.f + m_text.line_height();
     m_outer.set_height(total_height);
     m_inner.set_size(width() - padding()*2.f, total_height - padding()*2.f);
-    m_text.set_limiting_height(m_text.line_height());    
-    m_text.set_limiting_width(
-        max_text_width() - (need_ellipsis() ? m_ellipsis.width() : 0.f));
+    // text is scrolled rather than wrapped
+    m_text.set_limiting_dimensions(Text::k_inf, m_text.line_height());
 
     auto inner_loc = location() + padding()*VectorF(1.f, 1.f);
     m_inner.set_position(inner_loc);
     m_text .set_location(inner_loc + inner_padding()*VectorF(1.f, 1.f));
 
-    m_ellipsis.set_location(inner_loc.x, inner_loc.y);
-    m_ellipsis.set_size(m_inner.height() * 1.5f, m_inner.height());
+    update_overflow();
+    update_cursor();
+}
+
+void EditableText::insert_at_cursor(const UString & str) {
+    flag_visual_change();
+    if (str.empty()) return;
+    TextEdit edit { m_cursor_index, 0, str };
+    if (!passes_filters(edit)) return;
+    m_text.insert(m_cursor_index, str);
+    m_cursor_index += int(str.size());
+    on_text_edited(edit);
+}
+
+/* private */ void EditableText::erase_characters(int index, int count) {
+    if (index >= character_count()) return;
+    const UString nothing_inserted;
+    TextEdit edit { index, std::min(count, character_count() - index),
+                    nothing_inserted };
+    if (!passes_filters(edit)) return;
+    m_text.erase(index, edit.removed_length);
+    if (m_cursor_index > index)
+        m_cursor_index = std::max(index, m_cursor_index - edit.removed_length);
+    on_text_edited(edit);
+}
+
+/* private */ void EditableText::insert_typed(UString str) {
+    str.erase(std::remove_if(str.begin(), str.end(), is_control_character),
+              str.end());
+    insert_at_cursor(str);
+}
+
+/* private */ bool EditableText::passes_filters(const TextEdit & edit) const {
+    if (m_edit_filter_func && !m_edit_filter_func(edit)) return false;
+    if (m_filter_func && !edit.inserted.empty()) {
+        // the filter judges the whole string the edit would produce
+        UString new_string = string();
+        new_string.replace(std::size_t(edit.position),
+                           std::size_t(edit.removed_length), edit.inserted);
+        return m_filter_func(new_string);
+    }
+    return true;
+}
+
+/* private */ void EditableText::on_text_edited(const TextEdit & edit) {
+    update_overflow();
+    update_cursor();
+    if (m_edit_func) m_edit_func(edit);
+    m_change_text_func();
+}
 
+/* private */ void EditableText::move_cursor(int index) {
+    m_cursor_index = std::max(0, std::min(index, character_count()));
     update_cursor();
 }
 
+/* private */ void EditableText::update_overflow() {
+    float end_x = m_text.character_offset(character_count());
+    m_overflowing = end_x + cursor_width() > max_text_width();
+}
+
+/* private */ float EditableText::cursor_width() const
+    { return m_text.line_height() / 3.f; }
+
 /* private */ void EditableText::update_cursor() {
-    m_cursor.set_position(m_text.character_location(m_text.string().size()));
-    m_cursor.set_size    (m_text.line_height() / 3.f, m_text.line_height());
+    m_cursor_index = std::min(m_cursor_index, character_count());
+    const float view_width = max_text_width();
+    const float cursor_x   = m_text.character_offset(m_cursor_index);
+    if (m_overflowing) {
+        // no more space past the end of the text than the cursor needs,
+        // but the cursor must always be in view
+        float end_x = m_text.character_offset(character_count());
+        m_scroll = std::min(m_scroll, end_x + cursor_width() - view_width);
+        m_scroll = std::max(m_scroll, cursor_x + cursor_width() - view_width);
+        m_scroll = std::max(0.f, std::min(m_scroll, cursor_x));
+    } else {
+        m_scroll = 0.f;
+    }
+    if (view_width > 0.f) {
+        m_text.set_viewport(m_scroll, view_width);
+    }
+    m_cursor.set_position(m_text.location() + VectorF(cursor_x - m_scroll, 0.f));
+    m_cursor.set_size    (cursor_width(), m_text.line_height());
     m_cursor.set_color   (sf::Color::Black);
 }
 
@@ -311,4 +343,8 @@ sf::FloatRect to_rect(const DrawRectangle & drect) {
     return rv;
 }
 
+bool is_control_character(UString::value_type c) {
+    return (c < U' ' && c != U'\n' && c != U'\r') || c == 127;
+}
+
 } // end of <anonymous> namespace
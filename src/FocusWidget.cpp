@@ -27,6 +27,14 @@
 
 using ksg::detail::FocusWidgetAtt;
 
+namespace {
+
+// key presses which edit, or move the cursor, mouse buttons which may move
+// it (or focus); text typed before them must reach the widget first
+bool acts_on_text(const sf::Event &);
+
+} // end of <anonymous> namespace
+
 namespace ksg {
 
 namespace detail {
@@ -34,11 +42,13 @@ namespace detail {
 /* static */ void FocusWidgetAtt::notify_focus_gained(FocusWidget & fwidget) {
     fwidget.m_has_focus = true;
     fwidget.notify_focus_gained();
+    fwidget.flag_visual_change();
 }
 
 /* static */ void FocusWidgetAtt::notify_focus_lost(FocusWidget & fwidget) {
     fwidget.m_has_focus = false;
     fwidget.notify_focus_lost();
+    fwidget.flag_visual_change();
 }
 
 } // end of detail namespace
@@ -51,6 +61,15 @@ bool FocusWidget::reset_focus_request() {
     return rv;
 }
 
+void FocusWidget::process_text_burst(const UString & characters) {
+    sf::Event event;
+    event.type = sf::Event::TextEntered;
+    for (auto c : characters) {
+        event.text.unicode = sf::Uint32(c);
+        process_focus_event(event);
+    }
+}
+
 namespace detail {
 
 void FrameFocusHandler::set_focus_advance(FocusChangeFunc && func) {
@@ -73,6 +92,12 @@ void FrameFocusHandler::set_focus_regress(const FocusChangeFunc & func) {
 
 void FrameFocusHandler::process_event(const sf::Event & event) {
     if (m_focus_widgets.empty()) return;
+    if (m_holding_text && event.type == sf::Event::TextEntered) {
+        m_held_text += FocusWidget::UString::value_type(event.text.unicode);
+        return;
+    }
+    // (SFML sends a key press before, and a release after, each text event)
+    flush_held_text_before(event);
 
     auto widgets_end = m_focus_widgets.end();
     auto new_focus = widgets_end;
@@ -116,15 +141,36 @@ void FrameFocusHandler::process_event(const sf::Event & event) {
     }
 }
 
+void FrameFocusHandler::hold_text_events()
+    { m_holding_text = true; }
+
+void FrameFocusHandler::release_text_events() {
+    flush_held_text();
+    m_holding_text = false;
+}
+
+void FrameFocusHandler::flush_held_text_before(const sf::Event & event) {
+    if (acts_on_text(event)) flush_held_text();
+}
+
 void FrameFocusHandler::take_widgets_from(std::vector<FocusWidget *> & widgets) {
     m_focus_widgets.clear();
     m_focus_widgets.swap(widgets);
     m_current_position = m_focus_widgets.end();
+    m_held_text.clear();
 }
 
 void FrameFocusHandler::clear_focus_widgets() {
     m_focus_widgets.clear();
     m_current_position = m_focus_widgets.end();
+    m_held_text.clear();
+}
+
+/* private */ void FrameFocusHandler::flush_held_text() {
+    if (m_held_text.empty()) return;
+    if (m_current_position != m_focus_widgets.end())
+        { (**m_current_position).process_text_burst(m_held_text); }
+    m_held_text.clear();
 }
 
 /* static */ bool FrameFocusHandler::default_focus_advance(const sf::Event & event) {
@@ -144,3 +190,27 @@ void FrameFocusHandler::clear_focus_widgets() {
 } // end of detail namespace
 
 } // end of ksg namespace
+
+namespace {
+
+bool acts_on_text(const sf::Event & event) {
+    using Key = sf::Keyboard::Key;
+    switch (event.type) {
+    case sf::Event::MouseButtonPressed: case sf::Event::MouseButtonReleased:
+        return true;
+    case sf::Event::KeyPressed: break;
+    default: return false;
+    }
+    // shortcuts (like paste)
+    if (event.key.control || event.key.alt || event.key.system) return true;
+    switch (event.key.code) {
+    case Key::BackSpace: case Key::Delete: case Key::Return: case Key::Tab:
+    case Key::Left: case Key::Right: case Key::Up: case Key::Down:
+    case Key::Home: case Key::End: case Key::PageUp: case Key::PageDown:
+    case Key::Insert: case Key::Escape:
+        return true;
+    default: return false;
+    }
+}
+
+} // end of <anonymous> namespace
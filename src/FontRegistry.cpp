@@ -0,0 +1,192 @@
+/****************************************************************************
+
+    File: FontRegistry.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include <ksg/FontRegistry.hpp>
+#include <ksg/TextLayoutCache.hpp>
+
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+using FontHandle = ksg::FontRegistry::Handle;
+
+std::uint64_t table_key(FontHandle handle, int char_size)
+    { return (std::uint64_t(handle) << 32) | std::uint64_t(unsigned(char_size)); }
+
+} // end of <anonymous> namespace
+
+namespace ksg {
+
+/* static */ constexpr const FontRegistry::Handle FontRegistry::k_no_font;
+/* static */ constexpr const std::size_t FontRegistry::k_max_font_count;
+/* static */ constexpr const std::size_t FontRegistry::k_max_table_count;
+
+/* static */ FontRegistry & FontRegistry::instance() {
+    // never destroyed, so that texts may still be destroyed at exit
+    static auto * inst = new FontRegistry();
+    return *inst;
+}
+
+FontRegistry::Handle FontRegistry::register_font(const sf::Font * font) {
+    if (!font) return k_no_font;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto itr = m_handles.find(font);
+    if (itr != m_handles.end()) return itr->second;
+    FontEntry entry;
+    entry.font = font;
+    return add_font(std::move(entry));
+}
+
+FontRegistry::Handle FontRegistry::register_font
+    (const std::shared_ptr<const sf::Font> & font)
+{
+    if (!font) return k_no_font;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto itr = m_handles.find(font.get());
+    if (itr != m_handles.end()) {
+        // (the font maybe registered by address first)
+        m_fonts[itr->second].owner = font;
+        return itr->second;
+    }
+    FontEntry entry;
+    entry.font  = font.get();
+    entry.owner = font;
+    return add_font(std::move(entry));
+}
+
+const sf::Font * FontRegistry::font(Handle handle) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (handle >= m_fonts.size()) {
+        throw std::out_of_range("FontRegistry::font: handle was not given out "
+                                "by this registry.");
+    }
+    return m_fonts[handle].font;
+}
+
+void FontRegistry::forget_font(const sf::Font * font) {
+    // (the cache has its own lock, layouts are not looked up in here)
+    TextLayoutCache::instance().forget_font(font);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto itr = m_handles.find(font);
+    if (itr == m_handles.end()) return;
+    const auto handle = itr->second;
+    m_handles.erase(itr);
+    m_fonts[handle] = FontEntry();
+    for (auto & table : m_tables) {
+        if (table->font() == font) table->forget();
+    }
+    for (auto jtr = m_table_ids.begin(); jtr != m_table_ids.end(); ) {
+        if (FontHandle(jtr->first >> 32) == handle) {
+            jtr = m_table_ids.erase(jtr);
+        } else {
+            ++jtr;
+        }
+    }
+}
+
+std::size_t FontRegistry::font_count() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fonts.size() - 1;
+}
+
+std::size_t FontRegistry::glyph_table_byte_size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::size_t rv = 0;
+    for (const auto & table : m_tables) rv += table->byte_size();
+    return rv;
+}
+
+/* private */ FontRegistry::GlyphTable::GlyphTable
+    (const sf::Font * font, int char_size):
+    m_font(font),
+    m_char_size(char_size),
+    m_line_spacing(font->getLineSpacing(unsigned(char_size)))
+{}
+
+/* private */ FontRegistry::GlyphId FontRegistry::GlyphTable::glyph_id(UChar c) {
+    GlyphId temp = 0;
+    auto & id = (c >= k_ascii_first && c <= k_ascii_last) ?
+        m_ascii_ids[std::size_t(c - k_ascii_first)] : temp;
+    if (id != 0) return id;
+    if (&id == &temp) {
+        auto itr = m_other_ids.find(c);
+        if (itr != m_other_ids.end()) return itr->second;
+    }
+    if (m_quads.size() > std::size_t(std::numeric_limits<GlyphId>::max())) {
+        throw std::length_error("FontRegistry::GlyphTable::glyph_id: table has "
+                                "no glyph ids left.");
+    }
+    id = GlyphId(m_quads.size());
+    m_quads.emplace_back(m_font->getGlyph(c, unsigned(m_char_size), false), 0);
+    if (&id == &temp) m_other_ids.emplace(c, id);
+    return id;
+}
+
+/* private */ std::size_t FontRegistry::GlyphTable::byte_size() const noexcept {
+    using MapValue = decltype(m_other_ids)::value_type;
+    return m_quads.capacity()*sizeof(detail::GlyphQuad) +
+           m_other_ids.bucket_count()*sizeof(void *) +
+           m_other_ids.size()*(sizeof(MapValue) + sizeof(void *)) +
+           sizeof(GlyphTable);
+}
+
+/* private */ void FontRegistry::GlyphTable::forget() {
+    m_font = nullptr;
+    m_quads = std::vector<detail::GlyphQuad>(1);
+    m_ascii_ids.fill(0);
+    m_other_ids.clear();
+}
+
+/* private */ FontRegistry::FontRegistry():
+    m_fonts(1)
+{}
+
+/* private */ FontRegistry::TableId FontRegistry::glyph_table
+    (Handle handle, int char_size)
+{
+    const auto key = table_key(handle, char_size);
+    auto itr = m_table_ids.find(key);
+    if (itr != m_table_ids.end()) return itr->second;
+    if (m_tables.size() >= k_max_table_count) {
+        throw std::length_error("FontRegistry::glyph_table: too many fonts and "
+                                "character sizes are in use.");
+    }
+    auto id = TableId(m_tables.size());
+    m_tables.emplace_back(std::make_unique<GlyphTable>(m_fonts[handle].font, char_size));
+    m_table_ids.emplace(key, id);
+    return id;
+}
+
+/* private */ FontRegistry::Handle FontRegistry::add_font(FontEntry && entry) {
+    // (handle zero is k_no_font)
+    if (m_fonts.size() > k_max_font_count) {
+        throw std::length_error("FontRegistry::register_font: no handles are "
+                                "left for more fonts.");
+    }
+    auto handle = Handle(m_fonts.size());
+    m_handles.emplace(entry.font, handle);
+    m_fonts.push_back(std::move(entry));
+    return handle;
+}
+
+} // end of ksg namespace
@@ -26,15 +26,23 @@
 #include <ksg/FocusWidget.hpp>
 
 #include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/View.hpp>
+#include <SFML/Window/Event.hpp>
 
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
+#include <cmath>
 
 namespace {
 
 using VectorF = ksg::Frame::VectorF;
 
+// the cached texture is placed on whole pixels, so that its pixels line up
+// with the target's and are not filtered when drawn
+VectorF round_down_to_pixel(VectorF);
+
 } // end of <anonymous> namespace
 
 namespace ksg {
@@ -147,7 +155,9 @@ void WidgetAdder::swap(WidgetAdder & rhs) {
 
 /* protected */ Frame::Frame(const Frame & lhs):
     m_padding(lhs.m_padding),
-    m_border (lhs.m_border )
+    m_border (lhs.m_border ),
+    // the cached texture is not copied, the copy renders its own
+    m_is_render_cached(lhs.m_is_render_cached)
 {}
 
 /* protected */ Frame::Frame(Frame && lhs) { swap(lhs); }
@@ -171,8 +181,11 @@ void Frame::set_location(float x, float y) {
 }
 
 void Frame::process_event(const sf::Event & event) {
+    if (m_is_render_cached) check_for_hover_change(event);
     auto gv = m_border.process_event(event);
     if (!gv.skip_other_events) {
+        // a click may move the cursor, held text belongs where it was
+        m_focus_handler.flush_held_text_before(event);
         for (Widget * widget_ptr : m_widgets) {
             if (widget_ptr->is_visible())
                 widget_ptr->process_event(event);
@@ -188,7 +201,16 @@ void Frame::process_event(const sf::Event & event) {
     check_invarients();
 }
 
+void Frame::process_events(const std::vector<sf::Event> & events) {
+    m_focus_handler.hold_text_events();
+    for (const auto & event : events) {
+        process_event(event);
+    }
+    m_focus_handler.release_text_events();
+}
+
 void Frame::set_style(const StyleMap & smap) {
+    flag_visual_change();
     m_border.set_style(smap);
     if (!styles::set_if_found(smap, styles::k_global_padding, m_padding)) {
         m_padding = k_default_padding;
@@ -206,10 +228,14 @@ float Frame::width() const { return m_border.width(); }
 float Frame::height() const { return m_border.height(); }
 
 void Frame::set_size(float w, float h) {
+    flag_visual_change();
     m_border.set_size(w, h);
     check_invarients();
 }
 
+void Frame::add_glyphs_to(GlyphPrewarmer & prewarmer) const
+    { m_border.add_glyphs_to(prewarmer); }
+
 WidgetAdder Frame::begin_adding_widgets(const StyleMap & styles) {
     return WidgetAdder(this, &styles, &m_the_line_seperator);
 }
@@ -251,23 +277,43 @@ void Frame::finalize_widgets(std::vector<Widget *> && widgets,
     check_invarients();
 }
 
-void Frame::set_padding(float pixels)
-    { m_padding = pixels; }
+void Frame::set_padding(float pixels) {
+    flag_visual_change();
+    m_padding = pixels;
+}
+
+void Frame::set_frame_border_size(float pixels) {
+    flag_visual_change();
+    m_border.set_border_size(pixels);
+}
+
+void Frame::set_render_caching(bool b) {
+    if (b == m_is_render_cached) return;
+    m_is_render_cached = b;
+    m_cache_texture.reset();
+    m_cache_counters = RenderCacheCounters();
+    flag_visual_change();
+}
 
-void Frame::set_frame_border_size(float pixels)
-    { m_border.set_border_size(pixels); }
+void Frame::reset_render_cache_counters() {
+    m_cache_counters.hit_count  = 0;
+    m_cache_counters.miss_count = 0;
+}
 
 /* protected */ void Frame::draw(sf::RenderTarget & target, sf::RenderStates) const {
     if (!is_visible()) return;
 
-    target.draw(m_border);
-    for (Widget * widget_ptr : m_widgets) {
-        if (widget_ptr->is_visible())
-            target.draw(*widget_ptr);
+    if (!m_is_render_cached || !update_render_cache()) {
+        draw_contents(target);
+        return;
     }
+    sf::Sprite sprite(m_cache_texture->getTexture());
+    sprite.setPosition(round_down_to_pixel(m_cached_location));
+    target.draw(sprite);
 }
 
 /* private */ void Frame::finalize_widgets() {
+    flag_visual_change();
     // auto sizing
     issue_auto_resize();
 
@@ -339,6 +385,15 @@ void Frame::set_frame_border_size(float pixels)
 void Frame::swap(Frame & lhs) {
     std::swap(m_padding, lhs.m_padding);
     std::swap(m_border , lhs.m_border );
+
+    std::swap(m_is_render_cached, lhs.m_is_render_cached);
+    std::swap(m_cache_texture   , lhs.m_cache_texture   );
+    std::swap(m_cached_location , lhs.m_cached_location );
+    std::swap(m_cached_size     , lhs.m_cached_size     );
+    std::swap(m_cache_counters  , lhs.m_cache_counters  );
+    // widgets are not swapped, so neither texture is of what its frame has
+    flag_visual_change();
+    lhs.flag_visual_change();
 }
 
 /* private */ VectorF Frame::compute_size_to_fit() const {
@@ -442,6 +497,99 @@ void Frame::swap(Frame & lhs) {
     return false;
 }
 
+/* private */ bool Frame::needs_render_cache_update() const {
+    if (   !m_cache_texture || has_visual_change()
+        || location() != m_cached_location
+        || VectorF(width(), height()) != m_cached_size)
+    { return true; }
+
+    bool rv = false;
+    iterate_const_children_f([&rv](const Widget & widget) {
+        if (widget.has_visual_change()) rv = true;
+    });
+    return rv;
+}
+
+/* private */ bool Frame::update_render_cache() const {
+    if (!needs_render_cache_update()) {
+        ++m_cache_counters.hit_count;
+        return true;
+    }
+    // the texture covers every pixel the frame touches
+    const auto origin = round_down_to_pixel(location());
+    const auto texture_width  = unsigned(std::ceil(location().x + width ()) - origin.x);
+    const auto texture_height = unsigned(std::ceil(location().y + height()) - origin.y);
+    if (   !m_cache_texture
+        || m_cache_texture->getSize() != sf::Vector2u(texture_width, texture_height))
+    {
+        m_cache_texture.reset();
+        m_cache_counters.byte_count = 0;
+        if (texture_width == 0 || texture_height == 0) return false;
+
+        auto texture = std::make_unique<sf::RenderTexture>();
+        if (!texture->create(texture_width, texture_height)) return false;
+        m_cache_texture = std::move(texture);
+        m_cache_counters.byte_count =
+            std::size_t(texture_width)*std::size_t(texture_height)*4;
+    }
+
+    m_cache_texture->setView(sf::View(sf::FloatRect(
+        origin.x, origin.y, float(texture_width), float(texture_height))));
+    m_cache_texture->clear(sf::Color::Transparent);
+    // cached frames inside this one update (and clear) their own caches here
+    draw_contents(*m_cache_texture);
+    m_cache_texture->display();
+
+    m_cached_location = location();
+    m_cached_size     = VectorF(width(), height());
+    iterate_const_children_f([](const Widget & widget) {
+        widget.clear_visual_change();
+    });
+    clear_visual_change();
+    ++m_cache_counters.miss_count;
+    return true;
+}
+
+/* private */ void Frame::draw_contents(sf::RenderTarget & target) const {
+    target.draw(m_border);
+    for (Widget * widget_ptr : m_widgets) {
+        if (widget_ptr->is_visible())
+            target.draw(*widget_ptr);
+    }
+}
+
+/* private */ void Frame::check_for_hover_change(const sf::Event & event) {
+    if (event.type != sf::Event::MouseMoved) {
+        if (event.type == sf::Event::MouseButtonPressed)
+            { m_is_mouse_held = true; }
+        else if (event.type == sf::Event::MouseButtonReleased)
+            { m_is_mouse_held = false; }
+        // anything else (keys, text, clicks...) may change a widget's looks
+        flag_visual_change();
+        return;
+    }
+    // e.g. a slider or the frame itself being dragged
+    if (m_is_mouse_held) {
+        flag_visual_change();
+        return;
+    }
+
+    const VectorF pos(float(event.mouseMove.x), float(event.mouseMove.y));
+    // children come after their parents, so the last one found is the
+    // innermost
+    const Widget * hovered = nullptr;
+    iterate_const_children_f([&hovered, pos](const Widget & widget) {
+        if (!widget.is_visible()) return;
+        auto loc = widget.location();
+        if (   pos.x >= loc.x && pos.x < loc.x + widget.width ()
+            && pos.y >= loc.y && pos.y < loc.y + widget.height())
+        { hovered = &widget; }
+    });
+    if (hovered == m_hovered_widget) return;
+    m_hovered_widget = hovered;
+    flag_visual_change();
+}
+
 /* private */ void Frame::iterate_children_(ChildWidgetIterator & itr) {
     for (auto * widget : m_widgets) {
         itr.on_child(*widget);
@@ -540,3 +688,10 @@ void Frame::swap(Frame & lhs) {
 SimpleFrame::~SimpleFrame() {}
 
 } // end of ksg namespace
+
+namespace {
+
+VectorF round_down_to_pixel(VectorF r)
+    { return VectorF(std::floor(r.x), std::floor(r.y)); }
+
+} // end of <anonymous> namespace
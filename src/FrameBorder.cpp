@@ -22,6 +22,7 @@
 #include <ksg/FrameBorder.hpp>
 #include <ksg/Frame.hpp>
 #include <ksg/TextArea.hpp>
+#include <ksg/GlyphPrewarmer.hpp>
 
 #include <SFML/Graphics/RenderTarget.hpp>
 
@@ -188,6 +189,11 @@ void FrameBorder::set_border_size(float pixels) {
     m_outer_padding = pixels;
 }
 
+void FrameBorder::add_glyphs_to(GlyphPrewarmer & prewarmer) const {
+    if (!m_title.string().empty())
+        prewarmer.add(m_title);
+}
+
 /* private */ void FrameBorder::update_drag_position
     (int drect_x, int drect_y)
 {
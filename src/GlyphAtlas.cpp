@@ -0,0 +1,440 @@
+/****************************************************************************
+
+    File: GlyphAtlas.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include <ksg/GlyphAtlas.hpp>
+#include <ksg/Text.hpp>
+#include <ksg/TextLayoutCache.hpp>
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+
+#include <cmath>
+
+#include <cassert>
+
+namespace {
+
+using GlyphAtlas = ksg::GlyphAtlas;
+
+// empty space kept around each glyph, so neighbors never bleed into each
+// other
+constexpr const unsigned k_glyph_padding = 1;
+
+// a shelf is reused for glyphs at least this fraction of its height
+constexpr const float k_shelf_fit_ratio = 0.7f;
+
+// GLSL 1.10, fwidth keeps edges about a pixel wide at any scale
+constexpr const char * const k_distance_field_shader =
+    "uniform sampler2D texture;\n"
+    "void main() {\n"
+    "    float dist  = texture2D(texture, gl_TexCoord[0].xy).a;\n"
+    "    float width = fwidth(dist);\n"
+    "    float alpha = smoothstep(0.5 - width, 0.5 + width, dist);\n"
+    "    gl_FragColor = vec4(gl_Color.rgb, gl_Color.a*alpha);\n"
+    "}\n";
+
+bool load_blank(sf::Texture &, unsigned width, unsigned height);
+
+struct FieldOffset {
+    // large enough to mean "nothing found", small enough not to overflow
+    static constexpr const int k_far = 4096;
+    int dx = k_far, dy = k_far;
+    int distance_squared() const { return dx*dx + dy*dy; }
+};
+
+// one pass of "8SSEDT" (eight points signed sequential euclidean distance
+// transform), run once forward and once backward
+void sweep_distances(std::vector<FieldOffset> &, int width, int height);
+
+} // end of <anonymous> namespace
+
+namespace ksg {
+
+/* static */ constexpr const unsigned GlyphAtlas::k_page_width         ;
+/* static */ constexpr const unsigned GlyphAtlas::k_initial_page_height;
+/* static */ constexpr const unsigned GlyphAtlas::k_max_page_height    ;
+/* static */ constexpr const unsigned GlyphAtlas::k_distance_field_reference_size;
+/* static */ constexpr const unsigned GlyphAtlas::k_distance_field_spread;
+
+GlyphAtlas::GlyphAtlas(Mode mode_): m_mode(mode_) {}
+
+GlyphAtlas::~GlyphAtlas() {
+    // cached layouts refer to this atlas' pages
+    TextLayoutCache::instance().forget_atlas(this);
+}
+
+const GlyphAtlas::Entry & GlyphAtlas::glyph
+    (const sf::Font & font, unsigned character_size, UChar c)
+{
+    Key key { &font, character_size, c };
+    auto itr = m_entries.find(key);
+    if (itr != m_entries.end()) return itr->second;
+
+    Entry entry;
+    if (m_mode == Mode::k_distance_field) {
+        // metrics are scaled from the reference size, asking the font for
+        // them at this size would rasterize the glyph at this size too
+        const auto & field = distance_field(font, c);
+        const float scale = float(character_size) / float(k_distance_field_reference_size);
+        const auto & bounds = field.glyph.bounds;
+        entry.glyph             = field.glyph;
+        entry.glyph.advance     = field.glyph.advance*scale;
+        entry.glyph.bounds      = sf::FloatRect(bounds.left*scale, bounds.top*scale,
+                                                bounds.width*scale, bounds.height*scale);
+        entry.page              = field.page;
+        return m_entries.emplace(key, entry).first->second;
+    }
+    entry.glyph = font.getGlyph(c, character_size, false);
+    const sf::IntRect source = entry.glyph.textureRect;
+    entry.glyph.textureRect = sf::IntRect();
+    if (source.width > 0 && source.height > 0) {
+        auto [page, dest] = allocate(unsigned(source.width), unsigned(source.height));
+        entry.page              = page;
+        entry.glyph.textureRect = dest;
+        m_pending.push_back(PendingCopy { key, source, dest, page });
+    }
+    return m_entries.emplace(key, entry).first->second;
+}
+
+void GlyphAtlas::flush() {
+    if (m_pending.empty()) return;
+
+    // one download per font texture
+    std::sort(m_pending.begin(), m_pending.end(),
+        [](const PendingCopy & lhs, const PendingCopy & rhs)
+    {
+        if (lhs.key.font != rhs.key.font) return lhs.key.font < rhs.key.font;
+        return lhs.key.character_size < rhs.key.character_size;
+    });
+
+    std::vector<sf::Uint8> pixels;
+    std::vector<sf::Uint8> field_pixels;
+    auto itr = m_pending.begin();
+    while (itr != m_pending.end()) {
+        const auto * font = itr->key.font;
+        const auto size   = itr->key.character_size;
+        const sf::Image source = font->getTexture(size).copyToImage();
+        const auto source_width = source.getSize().x;
+        for (; itr != m_pending.end() && itr->key.font == font &&
+               itr->key.character_size == size; ++itr)
+        {
+            const auto & src = itr->source;
+            pixels.resize(std::size_t(src.width)*std::size_t(src.height)*4);
+            auto * out = pixels.data();
+            for (int y = src.top; y != src.top + src.height; ++y) {
+                const auto * row = source.getPixelsPtr() +
+                    (std::size_t(y)*source_width + std::size_t(src.left))*4;
+                out = std::copy(row, row + src.width*4, out);
+            }
+            const auto & dest = itr->destination;
+            if (itr->spread) {
+                detail::make_distance_field(pixels, src.width, src.height,
+                                    int(itr->spread), field_pixels);
+                pixels.swap(field_pixels);
+            }
+            m_pages[std::size_t(itr->page)]->texture.update(
+                pixels.data(), unsigned(dest.width), unsigned(dest.height),
+                unsigned(dest.left), unsigned(dest.top));
+        }
+    }
+    m_pending.clear();
+}
+
+const sf::Texture & GlyphAtlas::page_texture(int page) const {
+    if (page < 0 || page >= page_count()) {
+        throw std::out_of_range("GlyphAtlas::page_texture: page index out of range.");
+    }
+    return m_pages[std::size_t(page)]->texture;
+}
+
+std::size_t GlyphAtlas::byte_size() const noexcept {
+    std::size_t sum = 0;
+    for (const auto & page : m_pages) {
+        auto size = page->texture.getSize();
+        sum += std::size_t(size.x)*std::size_t(size.y)*4;
+    }
+    return sum;
+}
+
+const sf::Shader * GlyphAtlas::shader() const {
+    if (m_mode != Mode::k_distance_field) return nullptr;
+    if (!m_shader_loaded) {
+        m_shader_loaded = true;
+        if (sf::Shader::isAvailable()) {
+            auto shader = std::make_unique<sf::Shader>();
+            if (shader->loadFromMemory(k_distance_field_shader, sf::Shader::Fragment)) {
+                shader->setUniform("texture", sf::Shader::CurrentTexture);
+                m_shader = std::move(shader);
+            }
+        }
+    }
+    return m_shader.get();
+}
+
+/* private */ const GlyphAtlas::Entry & GlyphAtlas::distance_field
+    (const sf::Font & font, UChar c)
+{
+    static constexpr const auto k_ref_size = k_distance_field_reference_size;
+    static constexpr const auto k_spread   = k_distance_field_spread;
+    Key key { &font, k_ref_size, c };
+    auto itr = m_distance_fields.find(key);
+    if (itr != m_distance_fields.end()) return itr->second;
+
+    Entry entry;
+    entry.glyph = font.getGlyph(c, k_ref_size, false);
+    const sf::IntRect source = entry.glyph.textureRect;
+    entry.glyph.textureRect = sf::IntRect();
+    if (source.width > 0 && source.height > 0) {
+        auto [page, dest] = allocate(unsigned(source.width ) + k_spread*2,
+                                     unsigned(source.height) + k_spread*2);
+        // texture rectangle excludes the spread, it covers exactly what the
+        // glyph's bounds cover
+        entry.page              = page;
+        entry.glyph.textureRect = sf::IntRect(
+            dest.left + int(k_spread), dest.top + int(k_spread),
+            source.width, source.height);
+        m_pending.push_back(PendingCopy { key, source, dest, page, k_spread });
+    }
+    return m_distance_fields.emplace(key, entry).first->second;
+}
+
+/* private */ std::size_t GlyphAtlas::KeyHasher::operator ()
+    (const Key & key) const noexcept
+{
+    auto h = std::hash<const sf::Font *>()(key.font);
+    h ^= std::hash<unsigned>()(key.character_size) + 0x9E3779B9 + (h << 6) + (h >> 2);
+    h ^= std::hash<UChar>   ()(key.character     ) + 0x9E3779B9 + (h << 6) + (h >> 2);
+    return h;
+}
+
+/* private */ std::pair<int, sf::IntRect> GlyphAtlas::allocate
+    (unsigned width, unsigned height)
+{
+    width  += k_glyph_padding*2;
+    height += k_glyph_padding*2;
+    if (width > k_page_width || height > k_max_page_height) {
+        throw std::runtime_error(
+            "GlyphAtlas::allocate: glyph is too large to fit on a page.");
+    }
+    sf::IntRect rect;
+    // only the last page may have room to grow, all others are full height
+    for (std::size_t i = 0; i != m_pages.size(); ++i) {
+        if (allocate_on(*m_pages[i], width, height, rect)) {
+            return std::make_pair(int(i), rect);
+        }
+    }
+    while (!m_pages.empty() &&
+           m_pages.back()->texture.getSize().y < k_max_page_height)
+    {
+        grow(*m_pages.back());
+        if (allocate_on(*m_pages.back(), width, height, rect))
+            return std::make_pair(int(m_pages.size()) - 1, rect);
+    }
+    // a new page grows to fit any glyph that passes the check at the top of
+    // this function
+    Page & page = add_page();
+    while (!allocate_on(page, width, height, rect))
+        grow(page);
+    return std::make_pair(int(m_pages.size()) - 1, rect);
+}
+
+/* private */ bool GlyphAtlas::allocate_on
+    (Page & page, unsigned width, unsigned height, sf::IntRect & out)
+{
+    Shelf * best = nullptr;
+    for (auto & shelf : page.shelves) {
+        if (shelf.next_left + width > k_page_width) continue;
+        if (shelf.height < height || float(height) < float(shelf.height)*k_shelf_fit_ratio)
+            continue;
+        if (!best || shelf.height < best->height) best = &shelf;
+    }
+    if (!best) {
+        if (page.next_shelf_top + height > page.texture.getSize().y) return false;
+        Shelf shelf;
+        shelf.top    = page.next_shelf_top;
+        shelf.height = height;
+        page.next_shelf_top += height;
+        page.shelves.push_back(shelf);
+        best = &page.shelves.back();
+    }
+    out = sf::IntRect(int(best->next_left + k_glyph_padding),
+                      int(best->top       + k_glyph_padding),
+                      int(width  - k_glyph_padding*2),
+                      int(height - k_glyph_padding*2));
+    best->next_left += width;
+    return true;
+}
+
+/* private */ void GlyphAtlas::grow(Page & page) {
+    const bool smooth = page.texture.isSmooth();
+    auto old_height = page.texture.getSize().y;
+    assert(old_height < k_max_page_height);
+    sf::Texture grown;
+    if (!load_blank(grown, k_page_width, std::min(old_height*2, k_max_page_height))) {
+        throw std::runtime_error("GlyphAtlas::grow: failed to create page texture.");
+    }
+    grown.update(page.texture, 0, 0);
+    grown.setSmooth(smooth);
+    page.texture.swap(grown);
+}
+
+/* private */ GlyphAtlas::Page & GlyphAtlas::add_page() {
+    auto page = std::make_unique<Page>();
+    if (!load_blank(page->texture, k_page_width, k_initial_page_height)) {
+        throw std::runtime_error("GlyphAtlas::add_page: failed to create page texture.");
+    }
+    // distance fields must be sampled between texels
+    page->texture.setSmooth(m_mode == Mode::k_distance_field);
+    m_pages.emplace_back(std::move(page));
+    return *m_pages.back();
+}
+
+// ----------------------------------------------------------------------------
+
+TextBatch::TextBatch(GlyphAtlas & atlas): m_atlas(&atlas) {}
+
+void TextBatch::clear() {
+    // keep capacities, batches are usually refilled with similar content
+    for (auto & verticies : m_page_vertices) verticies.clear();
+}
+
+void TextBatch::add(const Text & text) {
+    if (text.m_glyph_atlas != m_atlas) {
+        throw std::invalid_argument(
+            "TextBatch::add: text must be assigned to this batch's glyph atlas.");
+    }
+    m_page_vertices.resize(std::size_t(m_atlas->page_count()));
+    auto offset = text.location();
+    if (text.m_viewport_width != Text::k_inf) offset.x -= text.m_viewport_offset;
+    for (int page = 0; page != m_atlas->page_count(); ++page) {
+        text.append_verticies(m_page_vertices[std::size_t(page)], offset, page);
+    }
+}
+
+std::size_t TextBatch::quad_count() const noexcept {
+    std::size_t sum = 0;
+    for (const auto & verticies : m_page_vertices) sum += verticies.size() / 4;
+    return sum;
+}
+
+/* private */ void TextBatch::draw
+    (sf::RenderTarget & target, sf::RenderStates states) const
+{
+    m_atlas->flush();
+    states.shader = m_atlas->shader();
+    for (std::size_t i = 0; i != m_page_vertices.size(); ++i) {
+        const auto & verticies = m_page_vertices[i];
+        if (verticies.empty()) continue;
+        states.texture = &m_atlas->page_texture(int(i));
+        target.draw(verticies.data(), verticies.size(), sf::Quads, states);
+    }
+}
+
+namespace detail {
+
+void make_distance_field(const std::vector<sf::Uint8> & pixels,
+                         int width, int height, int spread,
+                         std::vector<sf::Uint8> & out)
+{
+    const int field_width  = width  + spread*2;
+    const int field_height = height + spread*2;
+    const auto cell_count  = std::size_t(field_width*field_height);
+    // distances to the nearest inside, and the nearest outside pixel
+    std::vector<FieldOffset> to_inside (cell_count);
+    std::vector<FieldOffset> to_outside(cell_count);
+    auto is_inside = [&](int x, int y) {
+        x -= spread;
+        y -= spread;
+        if (x < 0 || y < 0 || x >= width || y >= height) return false;
+        return pixels[std::size_t(y*width + x)*4 + 3] >= 128;
+    };
+    for (int y = 0; y != field_height; ++y) {
+        for (int x = 0; x != field_width; ++x) {
+            auto & zeroed = is_inside(x, y) ? to_inside [std::size_t(y*field_width + x)]
+                                            : to_outside[std::size_t(y*field_width + x)];
+            zeroed.dx = zeroed.dy = 0;
+        }
+    }
+    sweep_distances(to_inside , field_width, field_height);
+    sweep_distances(to_outside, field_width, field_height);
+
+    out.resize(cell_count*4);
+    for (std::size_t i = 0; i != cell_count; ++i) {
+        float dist = std::sqrt(float(to_outside[i].distance_squared()))
+                   - std::sqrt(float(to_inside [i].distance_squared()));
+        // positive inside, 0.5 on the edge
+        float normal = std::max(0.f, std::min(1.f, 0.5f + dist / float(spread*2)));
+        out[i*4 + 0] = out[i*4 + 1] = out[i*4 + 2] = 255;
+        out[i*4 + 3] = sf::Uint8(std::round(normal*255.f));
+    }
+}
+
+} // end of detail namespace
+
+} // end of ksg namespace
+
+namespace {
+
+bool load_blank(sf::Texture & texture, unsigned width, unsigned height) {
+    // same as SFML's glyph pages: white and fully transparent
+    sf::Image blank;
+    blank.create(width, height, sf::Color(255, 255, 255, 0));
+    return texture.loadFromImage(blank);
+}
+
+void sweep_distances(std::vector<FieldOffset> & grid, int width, int height) {
+    auto compare = [&grid, width, height](int x, int y, int ox, int oy) {
+        int nx = x + ox, ny = y + oy;
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height) return;
+        FieldOffset other = grid[std::size_t(ny*width + nx)];
+        other.dx += ox;
+        other.dy += oy;
+        auto & current = grid[std::size_t(y*width + x)];
+        if (other.distance_squared() < current.distance_squared())
+            current = other;
+    };
+    for (int y = 0; y != height; ++y) {
+        for (int x = 0; x != width; ++x) {
+            compare(x, y, -1,  0);
+            compare(x, y,  0, -1);
+            compare(x, y, -1, -1);
+            compare(x, y,  1, -1);
+        }
+        for (int x = width - 1; x >= 0; --x)
+            compare(x, y, 1, 0);
+    }
+    for (int y = height - 1; y >= 0; --y) {
+        for (int x = width - 1; x >= 0; --x) {
+            compare(x, y,  1,  0);
+            compare(x, y,  0,  1);
+            compare(x, y, -1,  1);
+            compare(x, y,  1,  1);
+        }
+        for (int x = 0; x != width; ++x)
+            compare(x, y, -1, 0);
+    }
+}
+
+} // end of <anonymous> namespace
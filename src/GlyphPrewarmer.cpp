@@ -0,0 +1,96 @@
+/****************************************************************************
+
+    File: GlyphPrewarmer.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include <ksg/GlyphPrewarmer.hpp>
+#include <ksg/Widget.hpp>
+
+#include <algorithm>
+
+#include <cassert>
+
+namespace ksg {
+
+void GlyphPrewarmer::add
+    (const sf::Font & font, int character_size, const UString & characters)
+{
+    if (character_size < 1 || characters.empty()) return;
+    m_pending[std::make_pair(&font, character_size)] += characters;
+}
+
+void GlyphPrewarmer::add
+    (const sf::Font & font, int character_size, const char32_t * characters)
+{ add(font, character_size, UString(characters)); }
+
+void GlyphPrewarmer::add
+    (const sf::Font & font, const std::vector<int> & character_sizes,
+     const UString & characters)
+{
+    for (int size : character_sizes)
+        add(font, size, characters);
+}
+
+void GlyphPrewarmer::add(const Text & text) {
+    if (!text.has_font_assigned()) return;
+    add(text.assigned_font(), text.character_size(), text.string());
+}
+
+void GlyphPrewarmer::add(const Widget & widget) {
+    widget.add_glyphs_to(*this);
+    widget.iterate_const_children_f([this](const Widget & child) {
+        child.add_glyphs_to(*this);
+    });
+}
+
+std::size_t GlyphPrewarmer::run() {
+    std::size_t count = 0;
+    for (auto & [font_size, chars] : m_pending) {
+        const auto & [font, size] = font_size;
+        assert(font && size > 0);
+        // rasterize each character once only
+        std::sort(chars.begin(), chars.end());
+        chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+        for (auto c : chars) {
+            (void)font->getGlyph(c, unsigned(size), false);
+        }
+        count += chars.size();
+        if (std::find(m_warmed.begin(), m_warmed.end(), font_size) == m_warmed.end())
+            m_warmed.push_back(font_size);
+    }
+    m_pending.clear();
+    return count;
+}
+
+std::vector<GlyphPrewarmer::PageReport> GlyphPrewarmer::report_pages() const {
+    std::vector<PageReport> rv;
+    rv.reserve(m_warmed.size());
+    for (const auto & [font, size] : m_warmed) {
+        PageReport report;
+        auto tsize = font->getTexture(unsigned(size)).getSize();
+        report.font           = font;
+        report.character_size = size;
+        report.width          = tsize.x;
+        report.height         = tsize.y;
+        rv.push_back(report);
+    }
+    return rv;
+}
+
+} // end of ksg namespace
@@ -39,19 +39,26 @@ const char * const CANNOT_UPLOAD_TEXTURE_MSG =
 
 namespace ksg {
 
-bool ImageWidget::load_from_file(const char * filename) noexcept {
-    auto & texture = m_texture_storage.reset<sf::Texture>();
-    if (texture.loadFromFile(filename)) {
-        m_spt.setTexture(texture);
-        update_size_post_load();
-        check_invarients();
-        return true;
-    } else {
-        return false;
+bool ImageWidget::load_from_file(const char * filename) noexcept
+    { return load_budgeted(detail::BudgetedTexture(filename, sf::IntRect())); }
+
+bool ImageWidget::load_from_file
+    (const char * filename, const sf::IntRect & area) noexcept
+{ return load_budgeted(detail::BudgetedTexture(filename, area)); }
+
+bool ImageWidget::load_from_atlas
+    (std::shared_ptr<const sf::Image> atlas, const sf::IntRect & area)
+{
+    if (!atlas) {
+        throw std::invalid_argument(
+            "ImageWidget::load_from_atlas: atlas must not be null.");
     }
+    return load_budgeted(detail::BudgetedTexture(atlas, area));
 }
 
 void ImageWidget::load_from_image(const sf::Image & image) {
+    flag_visual_change();
+    m_budgeted_texture = detail::BudgetedTexture();
     auto & texture = m_texture_storage.reset<sf::Texture>();
     if (!texture.loadFromImage(image))
         throw Error(CANNOT_UPLOAD_TEXTURE_MSG);
@@ -63,6 +70,8 @@ void ImageWidget::load_from_image(const sf::Image & image) {
 void ImageWidget::set_texture
     (const sf::Texture & texture_, const sf::IntRect & trect_)
 {
+    flag_visual_change();
+    m_budgeted_texture = detail::BudgetedTexture();
     const auto & texture = m_texture_storage.reset<sf::Texture>(texture_);
     m_spt.setTexture(texture);
     if (trect_ != sf::IntRect())
@@ -74,6 +83,8 @@ void ImageWidget::set_texture
 void ImageWidget::set_texture_shared_pointer
     (std::shared_ptr<const sf::Texture> shrd_ptr)
 {
+    flag_visual_change();
+    m_budgeted_texture = detail::BudgetedTexture();
     m_texture_storage = TextureMultiType(shrd_ptr);
     m_spt.setTexture(*shrd_ptr);
     update_size_post_load();
@@ -81,16 +92,22 @@ void ImageWidget::set_texture_shared_pointer
 }
 
 void ImageWidget::assign_texture(const sf::Texture * tptr) {
+    flag_visual_change();
+    m_budgeted_texture = detail::BudgetedTexture();
     m_texture_storage = TextureMultiType(tptr);
     update_size_post_load();
     check_invarients();
 }
 
-void ImageWidget::reset_texture_rectangle(const sf::IntRect & trect_)
-    { m_spt.setTextureRect(trect_); }
+void ImageWidget::reset_texture_rectangle(const sf::IntRect & trect_) {
+    flag_visual_change();
+    m_spt.setTextureRect(trect_);
+}
 
-void ImageWidget::set_location(float x, float y)
-    { m_spt.setPosition(x, y); }
+void ImageWidget::set_location(float x, float y) {
+    flag_visual_change();
+    m_spt.setPosition(x, y);
+}
 
 VectorF ImageWidget::location() const { return m_spt.getPosition(); }
 
@@ -99,6 +116,7 @@ float ImageWidget::width() const { return m_size.x; }
 float ImageWidget::height() const { return m_size.y; }
 
 void ImageWidget::set_size(float w, float h) {
+    flag_visual_change();
     m_size = sf::Vector2f(w, h);
     update_size_post_load();
     check_invarients();
@@ -106,10 +124,16 @@ void ImageWidget::set_size(float w, float h) {
 
 /* private */ void ImageWidget::draw
     (sf::RenderTarget & target, sf::RenderStates) const
-    { target.draw(m_spt); }
+{
+    // drawing is what counts as "use" for the texture budget, an evicted
+    // texture is reloaded here
+    if (m_budgeted_texture.has_source() && !m_budgeted_texture.acquire())
+        return;
+    target.draw(m_spt);
+}
 
 /* private */ void ImageWidget::check_invarients() const {
-    if (m_texture_storage.is_valid()) {
+    if (m_texture_storage.is_valid() || m_budgeted_texture.has_source()) {
         assert(m_spt.getTexture());
     } else {
         assert(!m_spt.getTexture());
@@ -123,4 +147,18 @@ void ImageWidget::set_size(float w, float h) {
     }
 }
 
+/* private */ bool ImageWidget::load_budgeted(detail::BudgetedTexture && texture) {
+    flag_visual_change();
+    m_budgeted_texture = std::move(texture);
+    if (!m_budgeted_texture.acquire()) {
+        m_budgeted_texture = detail::BudgetedTexture();
+        return false;
+    }
+    m_texture_storage = TextureMultiType();
+    m_spt.setTexture(m_budgeted_texture.texture());
+    update_size_post_load();
+    check_invarients();
+    return true;
+}
+
 } // end of ksg namespace
@@ -0,0 +1,224 @@
+/****************************************************************************
+
+    File: LogArea.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include <ksg/LogArea.hpp>
+#include <ksg/TextArea.hpp>
+#include <ksg/GlyphPrewarmer.hpp>
+
+#include <SFML/Window/Event.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <stdexcept>
+
+#include <cmath>
+
+namespace ksg {
+
+/* static */ constexpr const std::size_t LogArea::k_default_capacity;
+/* static */ constexpr const int LogArea::k_lines_per_wheel_step;
+
+LogArea::LogArea():
+    m_ring(k_default_capacity)
+{}
+
+void LogArea::process_event(const sf::Event & event) {
+    if (event.type != sf::Event::MouseWheelScrolled) return;
+    sf::FloatRect bounds(m_location, m_size);
+    if (!bounds.contains(float(event.mouseWheelScroll.x),
+                         float(event.mouseWheelScroll.y)))
+    { return; }
+    int steps = int(std::round(event.mouseWheelScroll.delta));
+    set_lines_scrolled_back(m_scrolled_back + steps*k_lines_per_wheel_step);
+}
+
+void LogArea::set_location(float x, float y) {
+    flag_visual_change();
+    m_location = VectorF(x, y);
+    refresh_view();
+}
+
+void LogArea::set_style(const StyleMap & smap) {
+    flag_visual_change();
+    set_if_present(m_line_template, smap, styles::k_global_font,
+                   TextArea::k_text_size, TextArea::k_text_color);
+    refresh_view();
+}
+
+void LogArea::add_glyphs_to(GlyphPrewarmer & prewarmer) const {
+    for (const auto & text : m_view) prewarmer.add(text);
+}
+
+void LogArea::set_size(float w, float h) {
+    flag_visual_change();
+    if (w < 0.f || h < 0.f) {
+        throw std::invalid_argument(
+            "LogArea::set_size: width and height must be non-negative real "
+            "numbers.");
+    }
+    m_size = VectorF(w, h);
+    refresh_view();
+}
+
+void LogArea::append_line(const UString & str) {
+    flag_visual_change();
+    auto line_beg = str.begin();
+    for (auto itr = str.begin(); itr != str.end(); ++itr) {
+        if (*itr != U'\n') continue;
+        push_line(line_beg, itr);
+        line_beg = itr + 1;
+    }
+    push_line(line_beg, str.end());
+    update_view();
+}
+
+void LogArea::set_capacity(std::size_t new_capacity) {
+    flag_visual_change();
+    if (new_capacity == 0) {
+        throw std::invalid_argument(
+            "LogArea::set_capacity: capacity must be a positive integer.");
+    }
+    auto kept = std::min(Sequence(new_capacity), Sequence(line_count()));
+    std::vector<UString> ring(new_capacity);
+    for (auto seq = m_end_sequence - kept; seq != m_end_sequence; ++seq) {
+        ring[seq % new_capacity] = std::move(m_ring[seq % m_ring.size()]);
+    }
+    m_ring.swap(ring);
+    m_begin_sequence = m_end_sequence - kept;
+    set_lines_scrolled_back(m_scrolled_back);
+}
+
+const LogArea::UString & LogArea::line(std::size_t index) const {
+    if (index >= line_count()) {
+        throw std::out_of_range(
+            "LogArea::line: index must be [0 line_count()).");
+    }
+    return line_at(m_begin_sequence + index);
+}
+
+void LogArea::clear() {
+    flag_visual_change();
+    // strings are left in the ring, so that their memory is reused
+    m_begin_sequence = m_end_sequence;
+    m_scrolled_back  = 0;
+    update_view();
+}
+
+void LogArea::set_lines_scrolled_back(int lines) {
+    flag_visual_change();
+    int most = std::max(0, int(line_count()) - visible_line_count());
+    m_scrolled_back = std::max(0, std::min(lines, most));
+    update_view();
+}
+
+void LogArea::set_character_size(int size) {
+    flag_visual_change();
+    m_line_template.set_character_size(size);
+    refresh_view();
+}
+
+void LogArea::set_color(sf::Color color) {
+    flag_visual_change();
+    m_line_template.set_color(color);
+    for (auto & text : m_view) text.set_color(color);
+}
+
+void LogArea::assign_font(const sf::Font & font) {
+    flag_visual_change();
+    m_line_template.assign_font(&font);
+    refresh_view();
+}
+
+/* private */ void LogArea::draw
+    (sf::RenderTarget & target, sf::RenderStates states) const
+{
+    // every line is laid out at the top, and drawn moved down to its row
+    const float line_height = m_line_template.line_height();
+    for (std::size_t row = 0; row != m_view.size(); ++row) {
+        auto row_states = states;
+        row_states.transform.translate(0.f, float(row)*line_height);
+        target.draw(m_view[row], row_states);
+    }
+}
+
+/* private */ void LogArea::push_line
+    (UString::const_iterator beg, UString::const_iterator end)
+{
+    if (line_count() == capacity()) ++m_begin_sequence;
+    // assigning reuses the evicted line's memory
+    m_ring[m_end_sequence % m_ring.size()].assign(beg, end);
+    ++m_end_sequence;
+    if (m_scrolled_back > 0) {
+        // a view scrolled back stays on the same lines, for as long as
+        // they are kept
+        int most = std::max(0, int(line_count()) - visible_line_count());
+        m_scrolled_back = std::min(m_scrolled_back + 1, most);
+    }
+}
+
+/* private */ const LogArea::UString & LogArea::line_at(Sequence seq) const
+    { return m_ring[seq % m_ring.size()]; }
+
+/* private */ int LogArea::visible_line_count() const {
+    const float line_height = m_line_template.line_height();
+    if (line_height <= 0.f) return 0;
+    return std::max(1, int(m_size.y / line_height));
+}
+
+/* private */ void LogArea::update_view() {
+    const auto rows = Sequence(visible_line_count());
+    const Sequence view_end = m_end_sequence - Sequence(m_scrolled_back);
+    const Sequence view_begin = view_end - std::min(rows, view_end - m_begin_sequence);
+
+    // lines which are still in view are kept as they are
+    if (view_begin >= m_view_begin + m_view.size() || view_end <= m_view_begin) {
+        m_view.clear();
+    }
+    if (m_view.empty()) m_view_begin = view_begin;
+    while (m_view_begin < view_begin) {
+        m_view.pop_front();
+        ++m_view_begin;
+    }
+    while (m_view_begin + m_view.size() > view_end) {
+        m_view.pop_back();
+    }
+    while (m_view_begin > view_begin) {
+        m_view.push_front(make_line_text(--m_view_begin));
+    }
+    while (m_view_begin + m_view.size() < view_end) {
+        m_view.push_back(make_line_text(m_view_begin + m_view.size()));
+    }
+}
+
+/* private */ void LogArea::refresh_view() {
+    m_view.clear();
+    update_view();
+}
+
+/* private */ Text LogArea::make_line_text(Sequence seq) const {
+    Text text(m_line_template);
+    text.set_location(m_location);
+    text.set_string(line_at(seq));
+    if (m_size.x > 0.f) text.set_viewport(0.f, m_size.x);
+    return text;
+}
+
+} // end of ksg namespace
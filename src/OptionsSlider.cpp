@@ -23,6 +23,7 @@
 #include <ksg/Frame.hpp>
 #include <ksg/TextButton.hpp>
 #include <ksg/TextArea.hpp>
+#include <ksg/GlyphPrewarmer.hpp>
 
 #include <SFML/Graphics/RenderTarget.hpp>
 
@@ -69,6 +70,7 @@ void OptionsSlider::process_event(const sf::Event & evnt) {
 }
 
 void OptionsSlider::set_location(float x, float y) {
+    flag_visual_change();
     m_left_arrow.set_location(x, y);
     if (is_horizontal()) {
         m_back .set_position(x + m_left_arrow.width(), y);
@@ -95,6 +97,7 @@ float OptionsSlider::height() const
     { return m_size.y; }
 
 void OptionsSlider::set_style(const StyleMap & smap) {
+    flag_visual_change();
     using namespace styles;
     m_left_arrow.set_style(smap);
     m_right_arrow.set_style(smap);
@@ -112,7 +115,15 @@ void OptionsSlider::set_style(const StyleMap & smap) {
     // setting style should not invoke any kind of geometry update
 }
 
+void OptionsSlider::add_glyphs_to(GlyphPrewarmer & prewarmer) const {
+    if (!m_text.has_font_assigned()) return;
+    for (const auto & option : m_options) {
+        prewarmer.add(m_text.assigned_font(), m_text.character_size(), option);
+    }
+}
+
 void OptionsSlider::set_interior_size(float w, float h) {
+    flag_visual_change();
     if (w == 0.f || h == 0.f) return;
 #   if 0
     if (m_padding > w || m_padding > h) {
@@ -149,6 +160,7 @@ void OptionsSlider::set_options(std::vector<UString> && options) {
 }
 
 void OptionsSlider::select_option(std::size_t index) {
+    flag_visual_change();
     if (index >= m_options.size()) {
         throw std::out_of_range("OptionsSlider::select_option: Index is out "
                                 "of range");
@@ -169,6 +181,7 @@ void OptionsSlider::set_option_change_event(BlankFunctor && func)
     { m_press_func = std::move(func); }
 
 void OptionsSlider::set_wrap_enabled(bool b) {
+    flag_visual_change();
     m_wrap_enabled = b;
 
     if (m_options.empty()) return;
@@ -200,10 +213,9 @@ void OptionsSlider::set_wrap_enabled(bool b) {
 /* private */ void OptionsSlider::issue_auto_resize() {
     if (width() != 0.f || height() != 0.f || !m_text.has_font_assigned()) return;
     float width_ = 0.f;
-    for (const auto & str : m_options) {
-        auto gv = m_text.measure_text(str);
-        width_  = std::max(width_ , gv.width );
-    }
+    for (float w : Text::measure_widths
+         (m_text.assigned_font(), m_text.character_size(), m_options, true))
+    { width_ = std::max(width_, w); }
 
     float height_ = m_text.line_height() + 2.f*padding();
     set_interior_size(width_, height_);
@@ -0,0 +1,48 @@
+/****************************************************************************
+
+    File: ParallelTextLayout.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include <ksg/ParallelTextLayout.hpp>
+#include <ksg/Text.hpp>
+
+namespace ksg {
+
+ParallelTextLayout::ParallelTextLayout(unsigned thread_count):
+    m_thread_count(thread_count)
+{}
+
+ParallelTextLayout::~ParallelTextLayout() { run(); }
+
+void ParallelTextLayout::defer(Text & text) {
+    if (text.m_is_layout_deferred) return;
+    text.m_is_layout_deferred = true;
+    m_texts.push_back(&text);
+}
+
+void ParallelTextLayout::run() {
+    if (m_texts.empty()) return;
+    // (texts deferred while running belong to the next run)
+    auto texts = std::move(m_texts);
+    m_texts.clear();
+    Text::lay_out_deferred(texts, m_thread_count);
+}
+
+} // end of ksg namespace
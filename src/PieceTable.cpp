@@ -0,0 +1,381 @@
+/****************************************************************************
+
+    File: PieceTable.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include <ksg/PieceTable.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <cassert>
+
+namespace ksg {
+
+PieceTable::PieceTable(UString original) {
+    m_original.text.swap(original);
+    for (std::size_t i = 0; i != m_original.text.size(); ++i) {
+        if (m_original.text[i] == U'\n') m_original.newlines.push_back(i);
+    }
+    if (!m_original.text.empty()) {
+        m_root = make_node(Piece { Source::k_original, 0, m_original.text.size() });
+    }
+}
+
+void PieceTable::insert(std::size_t position, const UString & str) {
+    if (position > size()) {
+        throw std::out_of_range("PieceTable::insert: position must be [0 size()].");
+    }
+    if (str.empty()) return;
+    insert_without_record(position, str);
+    m_redo_log.clear();
+    if (!m_undo_log.empty()) {
+        auto & last = m_undo_log.back();
+        if (   last.is_insertion && last.text.back() != U'\n'
+            && last.position + last.text.size() == position)
+        {
+            last.text += str;
+            return;
+        }
+    }
+    m_undo_log.push_back(EditRecord { true, position, str });
+}
+
+void PieceTable::erase(std::size_t position, std::size_t count) {
+    if (position > size()) {
+        throw std::out_of_range("PieceTable::erase: position must be [0 size()].");
+    }
+    count = std::min(count, size() - position);
+    if (count == 0) return;
+    auto removed = substring(position, count);
+    erase_without_record(position, count);
+    m_redo_log.clear();
+    m_undo_log.push_back(EditRecord { false, position, std::move(removed) });
+}
+
+bool PieceTable::undo() {
+    if (m_undo_log.empty()) return false;
+    auto record = std::move(m_undo_log.back());
+    m_undo_log.pop_back();
+    if (record.is_insertion)
+        erase_without_record(record.position, record.text.size());
+    else
+        insert_without_record(record.position, record.text);
+    m_redo_log.push_back(std::move(record));
+    return true;
+}
+
+bool PieceTable::redo() {
+    if (m_redo_log.empty()) return false;
+    auto record = std::move(m_redo_log.back());
+    m_redo_log.pop_back();
+    if (record.is_insertion)
+        insert_without_record(record.position, record.text);
+    else
+        erase_without_record(record.position, record.text.size());
+    m_undo_log.push_back(std::move(record));
+    return true;
+}
+
+void PieceTable::clear_history() {
+    m_undo_log.clear();
+    m_redo_log.clear();
+}
+
+std::size_t PieceTable::size() const noexcept
+    { return subtree_length(m_root); }
+
+int PieceTable::line_count() const noexcept
+    { return 1 + int(subtree_newlines(m_root)); }
+
+std::size_t PieceTable::line_start(int line) const {
+    if (line < 0 || line >= line_count()) {
+        throw std::out_of_range("PieceTable::line_start: line must be [0 line_count()).");
+    }
+    if (line == 0) return 0;
+    // the line starts just after the line'th newline
+    auto target = std::size_t(line);
+    std::size_t begin = 0;
+    auto node = m_root;
+    while (true) {
+        assert(node != k_no_node);
+        const auto & current = m_nodes[node];
+        const auto left_newlines = subtree_newlines(current.left);
+        if (target <= left_newlines) {
+            node = current.left;
+            continue;
+        }
+        target -= left_newlines;
+        begin  += subtree_length(current.left);
+        if (target <= current.newlines) break;
+        target -= current.newlines;
+        begin  += current.piece.length;
+        node    = current.right;
+    }
+    const auto & piece    = m_nodes[node].piece;
+    const auto & newlines = buffer_of(piece).newlines;
+    auto first = std::lower_bound(newlines.begin(), newlines.end(), piece.start);
+    auto newline = *(first + std::ptrdiff_t(target - 1));
+    return begin + (newline - piece.start) + 1;
+}
+
+std::size_t PieceTable::line_end(int line) const {
+    if (line + 1 == line_count()) {
+        if (line < 0) {
+            throw std::out_of_range("PieceTable::line_end: line must be [0 line_count()).");
+        }
+        return size();
+    }
+    return line_start(line + 1) - 1;
+}
+
+int PieceTable::line_of(std::size_t position) const {
+    if (position > size()) {
+        throw std::out_of_range("PieceTable::line_of: position must be [0 size()].");
+    }
+    if (position == size()) return line_count() - 1;
+    std::size_t newlines = 0;
+    auto node = m_root;
+    while (true) {
+        assert(node != k_no_node);
+        const auto & current = m_nodes[node];
+        const auto left_length = subtree_length(current.left);
+        if (position < left_length) {
+            node = current.left;
+            continue;
+        }
+        position -= left_length;
+        newlines += subtree_newlines(current.left);
+        if (position < current.piece.length) {
+            return int(newlines + count_newlines(current.piece, position));
+        }
+        position -= current.piece.length;
+        newlines += current.newlines;
+        node      = current.right;
+    }
+}
+
+PieceTable::UString PieceTable::line(int line_) const {
+    auto beg = line_start(line_);
+    return substring(beg, line_end(line_) - beg);
+}
+
+PieceTable::UString PieceTable::substring
+    (std::size_t position, std::size_t count) const
+{
+    if (position > size()) {
+        throw std::out_of_range("PieceTable::substring: position must be [0 size()].");
+    }
+    count = std::min(count, size() - position);
+    UString rv;
+    if (count == 0) return rv;
+    rv.reserve(count);
+    append_text(m_root, position, count, rv);
+    return rv;
+}
+
+PieceTable::UString PieceTable::to_string() const
+    { return substring(0, size()); }
+
+/* private */ void PieceTable::Buffer::append(const UString & str) {
+    for (std::size_t i = 0; i != str.size(); ++i) {
+        if (str[i] == U'\n') newlines.push_back(text.size() + i);
+    }
+    text += str;
+}
+
+/* private */ void PieceTable::insert_without_record
+    (std::size_t position, const UString & str)
+{
+    const auto added_start    = m_added.text.size();
+    const auto newlines_start = m_added.newlines.size();
+    m_added.append(str);
+    auto parts = split(m_root, position);
+    // typing continues the piece which ends at the end of the added buffer
+    if (!extend_last_piece(parts.left, added_start, str.size(),
+                           m_added.newlines.size() - newlines_start))
+    {
+        auto node = make_node(Piece { Source::k_added, added_start, str.size() });
+        parts.left = merge(parts.left, node);
+    }
+    m_root = merge(parts.left, parts.right);
+}
+
+/* private */ void PieceTable::erase_without_record
+    (std::size_t position, std::size_t count)
+{
+    auto before = split(m_root, position);
+    auto erased = split(before.right, count);
+    free_nodes(erased.left);
+    m_root = merge(before.left, erased.right);
+}
+
+/* private */ std::size_t PieceTable::make_node(const Piece & piece) {
+    // xorshift, priorities need only be well spread, not unpredictable
+    m_priority_state ^= m_priority_state << 13;
+    m_priority_state ^= m_priority_state >> 17;
+    m_priority_state ^= m_priority_state << 5;
+
+    const auto newlines = count_newlines(piece, piece.length);
+    Node node { piece, newlines, piece.length, newlines, m_priority_state,
+                k_no_node, k_no_node };
+    if (m_free_nodes.empty()) {
+        m_nodes.push_back(node);
+        return m_nodes.size() - 1;
+    }
+    auto index = m_free_nodes.back();
+    m_free_nodes.pop_back();
+    m_nodes[index] = node;
+    return index;
+}
+
+/* private */ void PieceTable::free_nodes(std::size_t node) {
+    if (node == k_no_node) return;
+    free_nodes(m_nodes[node].left );
+    free_nodes(m_nodes[node].right);
+    m_free_nodes.push_back(node);
+}
+
+/* private */ PieceTable::Split PieceTable::split
+    (std::size_t node, std::size_t position)
+{
+    if (node == k_no_node) return Split { k_no_node, k_no_node };
+    const auto left_length = subtree_length(m_nodes[node].left);
+    const auto piece_end   = left_length + m_nodes[node].piece.length;
+    if (position <= left_length) {
+        auto parts = split(m_nodes[node].left, position);
+        m_nodes[node].left = parts.right;
+        update_totals(node);
+        return Split { parts.left, node };
+    }
+    if (position >= piece_end) {
+        auto parts = split(m_nodes[node].right, position - piece_end);
+        m_nodes[node].right = parts.left;
+        update_totals(node);
+        return Split { node, parts.right };
+    }
+    // the position is inside this node's piece, which is cut in two
+    const auto offset = position - left_length;
+    auto rest = m_nodes[node].piece;
+    rest.start  += offset;
+    rest.length -= offset;
+    // may reallocate m_nodes
+    const auto rest_node = make_node(rest);
+
+    auto & cut = m_nodes[node];
+    cut.piece.length = offset;
+    cut.newlines    -= m_nodes[rest_node].newlines;
+    const auto right = cut.right;
+    cut.right = k_no_node;
+    update_totals(node);
+    return Split { node, merge(rest_node, right) };
+}
+
+/* private */ std::size_t PieceTable::merge
+    (std::size_t left, std::size_t right)
+{
+    if (left  == k_no_node) return right;
+    if (right == k_no_node) return left;
+    if (m_nodes[left].priority > m_nodes[right].priority) {
+        m_nodes[left].right = merge(m_nodes[left].right, right);
+        update_totals(left);
+        return left;
+    }
+    m_nodes[right].left = merge(left, m_nodes[right].left);
+    update_totals(right);
+    return right;
+}
+
+/* private */ void PieceTable::update_totals(std::size_t node) {
+    auto & current = m_nodes[node];
+    current.subtree_length   =   subtree_length(current.left)
+                               + current.piece.length
+                               + subtree_length(current.right);
+    current.subtree_newlines =   subtree_newlines(current.left)
+                               + current.newlines
+                               + subtree_newlines(current.right);
+}
+
+/* private */ bool PieceTable::extend_last_piece
+    (std::size_t node, std::size_t added_start, std::size_t length,
+     std::size_t newlines)
+{
+    if (node == k_no_node) return false;
+    auto & current = m_nodes[node];
+    if (current.right != k_no_node) {
+        if (!extend_last_piece(current.right, added_start, length, newlines))
+            return false;
+    } else {
+        if (   current.piece.source != Source::k_added
+            || current.piece.start + current.piece.length != added_start)
+        { return false; }
+        current.piece.length += length;
+        current.newlines     += newlines;
+    }
+    update_totals(node);
+    return true;
+}
+
+/* private */ void PieceTable::append_text
+    (std::size_t node, std::size_t position, std::size_t count,
+     UString & rv) const
+{
+    if (node == k_no_node || count == 0) return;
+    const auto & current    = m_nodes[node];
+    const auto end          = position + count;
+    const auto piece_begin  = subtree_length(current.left);
+    const auto piece_end    = piece_begin + current.piece.length;
+    if (position < piece_begin) {
+        append_text(current.left, position, std::min(end, piece_begin) - position, rv);
+    }
+    if (position < piece_end && end > piece_begin) {
+        const auto beg  = std::max(position, piece_begin);
+        const auto last = std::min(end, piece_end);
+        rv.append(buffer_of(current.piece).text,
+                  current.piece.start + (beg - piece_begin), last - beg);
+    }
+    if (end > piece_end) {
+        const auto beg = std::max(position, piece_end);
+        append_text(current.right, beg - piece_end, end - beg, rv);
+    }
+}
+
+/* private */ std::size_t PieceTable::subtree_length
+    (std::size_t node) const noexcept
+{ return node == k_no_node ? 0 : m_nodes[node].subtree_length; }
+
+/* private */ std::size_t PieceTable::subtree_newlines
+    (std::size_t node) const noexcept
+{ return node == k_no_node ? 0 : m_nodes[node].subtree_newlines; }
+
+/* private */ std::size_t PieceTable::count_newlines
+    (const Piece & piece, std::size_t length) const
+{
+    const auto & newlines = buffer_of(piece).newlines;
+    auto beg = std::lower_bound(newlines.begin(), newlines.end(), piece.start);
+    auto end = std::lower_bound(beg, newlines.end(), piece.start + length);
+    return std::size_t(end - beg);
+}
+
+/* private */ const PieceTable::Buffer & PieceTable::buffer_of
+    (const Piece & piece) const
+{ return piece.source == Source::k_original ? m_original : m_added; }
+
+} // end of ksg namespace
@@ -42,6 +42,7 @@ using VectorF = ksg::Widget::VectorF;
 void ProgressBar::process_event(const sf::Event &) {}
 
 void ProgressBar::set_location(float x, float y) {
+    flag_visual_change();
     m_outer.set_position(x, y);
     update_positions_using_outer();
 }
@@ -50,6 +51,7 @@ VectorF ProgressBar::location() const
     { return VectorF(m_outer.x(), m_outer.y()); }
 
 void ProgressBar::set_size(float w, float h) {
+    flag_visual_change();
     m_outer.set_size(w, h);
     update_sizes_using_outer();
 }
@@ -61,6 +63,7 @@ float ProgressBar::height() const
     { return m_outer.height(); }
 
 void ProgressBar::set_style(const StyleMap & smap) {
+    flag_visual_change();
 #   if 0
     if (auto * pad = styles::find<float>(smap, k_padding)) {
         m_padding = *pad;
@@ -86,18 +89,25 @@ void ProgressBar::set_style(const StyleMap & smap) {
     update_sizes_using_outer();
 }
 
-void ProgressBar::set_outer_color(sf::Color color_)
-    { m_outer.set_color(color_); }
+void ProgressBar::set_outer_color(sf::Color color_) {
+    flag_visual_change();
+    m_outer.set_color(color_);
+}
 
-void ProgressBar::set_inner_front_color(sf::Color color_)
-    { m_inner_front.set_color(color_); }
+void ProgressBar::set_inner_front_color(sf::Color color_) {
+    flag_visual_change();
+    m_inner_front.set_color(color_);
+}
 
-void ProgressBar::set_inner_back_color(sf::Color color_)
-    { m_inner_back.set_color(color_); }
+void ProgressBar::set_inner_back_color(sf::Color color_) {
+    flag_visual_change();
+    m_inner_back.set_color(color_);
+}
 
 void ProgressBar::set_fill_amount(float fill_amount) {
     if (fill_amount < 0.f or fill_amount > 1.f)
         throw std::out_of_range(k_fill_out_of_range_msg);
+    flag_visual_change();
     m_fill_amount = fill_amount;
     set_size(width(), height());
 }
@@ -106,6 +116,7 @@ float ProgressBar::fill_amount() const
     { return m_fill_amount; }
 
 void ProgressBar::set_padding(float p) {
+    flag_visual_change();
     m_padding = p;
     update_sizes_using_outer();
 }
@@ -0,0 +1,376 @@
+/****************************************************************************
+
+    File: QuadKernels.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include <ksg/QuadKernels.hpp>
+#include <ksg/DrawCharacter.hpp>
+
+#include <cassert>
+
+// Vector kernels are only built for x86-64, where SSE2 is always present,
+// and where scalar floating point math is also done with SSE (so that
+// results are identical to the bit). The AVX2 kernel is built for its own
+// target, and only used if the processor supports it.
+#if defined(__x86_64__) || defined(_M_X64)
+#   define MACRO_KSG_SSE2_QUAD_KERNEL
+#   include <emmintrin.h>
+#   if defined(__GNUC__) || defined(__clang__)
+#       define MACRO_KSG_AVX2_QUAD_KERNEL
+#       include <immintrin.h>
+#   endif
+#endif
+
+namespace {
+
+using VectorF    = sf::Vector2f;
+using GlyphRun   = ksg::detail::GlyphRun;
+using QuadClip   = ksg::detail::QuadClip;
+using QuadKernel = ksg::detail::QuadKernel;
+
+// the reference for all kernels, uses DrawableCharacter's own cuts
+std::size_t make_clipped_quads_scalar
+    (const GlyphRun &, std::size_t first, const QuadClip &, sf::Vertex * out);
+
+void write_quad(sf::Vertex * out, const float * edges, sf::Color);
+
+#ifdef MACRO_KSG_SSE2_QUAD_KERNEL
+std::size_t make_clipped_quads_sse2
+    (const GlyphRun &, const QuadClip &, sf::Vertex * out);
+#endif
+
+#ifdef MACRO_KSG_AVX2_QUAD_KERNEL
+std::size_t make_clipped_quads_avx2
+    (const GlyphRun &, const QuadClip &, sf::Vertex * out);
+#endif
+
+// indices of the edges given to write_quad
+enum {
+    k_left, k_top, k_right, k_bottom,
+    k_tex_left, k_tex_top, k_tex_right, k_tex_bottom,
+    k_edge_count
+};
+
+} // end of <anonymous> namespace
+
+namespace ksg {
+
+namespace detail {
+
+QuadKernel best_quad_kernel() {
+    static const QuadKernel kernel = [] {
+        if (is_quad_kernel_supported(QuadKernel::k_avx2)) return QuadKernel::k_avx2;
+        if (is_quad_kernel_supported(QuadKernel::k_sse2)) return QuadKernel::k_sse2;
+        return QuadKernel::k_scalar;
+    } ();
+    return kernel;
+}
+
+bool is_quad_kernel_supported(QuadKernel kernel) {
+    switch (kernel) {
+    case QuadKernel::k_scalar: return true;
+#   ifdef MACRO_KSG_SSE2_QUAD_KERNEL
+    case QuadKernel::k_sse2: return true;
+#   endif
+#   ifdef MACRO_KSG_AVX2_QUAD_KERNEL
+    case QuadKernel::k_avx2: return __builtin_cpu_supports("avx2");
+#   endif
+    default: return false;
+    }
+}
+
+std::size_t make_clipped_quads
+    (QuadKernel kernel, const GlyphRun & run, const QuadClip & clip, sf::Vertex * out)
+{
+    assert(run.size <= GlyphRun::k_capacity);
+    assert(is_quad_kernel_supported(kernel));
+    switch (kernel) {
+#   ifdef MACRO_KSG_SSE2_QUAD_KERNEL
+    case QuadKernel::k_sse2: return make_clipped_quads_sse2(run, clip, out);
+#   endif
+#   ifdef MACRO_KSG_AVX2_QUAD_KERNEL
+    case QuadKernel::k_avx2: return make_clipped_quads_avx2(run, clip, out);
+#   endif
+    default: return make_clipped_quads_scalar(run, 0, clip, out);
+    }
+}
+
+std::size_t make_clipped_quads
+    (const GlyphRun & run, const QuadClip & clip, sf::Vertex * out)
+{ return make_clipped_quads(best_quad_kernel(), run, clip, out); }
+
+} // end of detail namespace
+
+} // end of ksg namespace
+
+namespace {
+
+std::size_t make_clipped_quads_scalar
+    (const GlyphRun & run, std::size_t first, const QuadClip & clip, sf::Vertex * out)
+{
+    using namespace ksg::detail;
+    std::size_t count = 0;
+    for (std::size_t i = first; i != run.size; ++i) {
+        GlyphQuad quad;
+        quad.bounds.width  = run.width [i];
+        quad.bounds.height = run.height[i];
+        quad.texture_rect = sf::FloatRect(run.tex_left [i], run.tex_top   [i],
+                                          run.tex_width[i], run.tex_height[i]);
+        DrawableCharacter dc(VectorF(run.x[i], run.y[i]), quad, run.colors[i]);
+        dc.cut_on_bottom(clip.bottom);
+        dc.cut_on_right (clip.right );
+        if (dc.whiped_out()) continue;
+        if (!(   dc.location().x >= clip.view_left
+              && dc.location().x + dc.width() <= clip.view_right))
+        {
+            dc.cut_on_left (clip.view_left );
+            dc.cut_on_right(clip.view_right);
+            if (dc.whiped_out()) continue;
+        }
+        dc.write_verticies(out + count*4, clip.offset);
+        ++count;
+    }
+    return count;
+}
+
+void write_quad(sf::Vertex * out, const float * edges, sf::Color color) {
+    using Vector2f = sf::Vector2f;
+    const float l  = edges[k_left    ], t  = edges[k_top       ];
+    const float r  = edges[k_right   ], b  = edges[k_bottom    ];
+    const float tl = edges[k_tex_left], tt = edges[k_tex_top   ];
+    const float tr = edges[k_tex_right], tb = edges[k_tex_bottom];
+    out[0] = sf::Vertex(Vector2f(l, t), color, Vector2f(tl, tt));
+    out[1] = sf::Vertex(Vector2f(r, t), color, Vector2f(tr, tt));
+    out[2] = sf::Vertex(Vector2f(r, b), color, Vector2f(tr, tb));
+    out[3] = sf::Vertex(Vector2f(l, b), color, Vector2f(tl, tb));
+}
+
+// Vector kernels follow DrawableCharacter's cuts operation for operation
+// (no operation is reordered or fused), every lane computes each outcome of
+// a cut, and the one the scalar branches would take is selected.
+
+#ifdef MACRO_KSG_SSE2_QUAD_KERNEL
+
+inline __m128 select(__m128 mask, __m128 a, __m128 b)
+    { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+inline __m128 is_whiped_out(__m128 l, __m128 t, __m128 r, __m128 b) {
+    const __m128 sign = _mm_set1_ps(-0.f);
+    const __m128 one  = _mm_set1_ps(1.f);
+    return _mm_or_ps(_mm_cmplt_ps(_mm_andnot_ps(sign, _mm_sub_ps(r, l)), one),
+                     _mm_cmplt_ps(_mm_andnot_ps(sign, _mm_sub_ps(b, t)), one));
+}
+
+// as DrawableCharacter::cut_on_right (and cut_on_bottom on the y axis)
+inline void cut_far_side
+    (__m128 cut, __m128 near, __m128 & far, __m128 tex_near, __m128 & tex_far)
+{
+    const __m128 keep     = _mm_cmpgt_ps(cut, far);
+    const __m128 collapse = _mm_cmplt_ps(cut, near);
+    const __m128 ratio    = _mm_div_ps(_mm_sub_ps(cut, near), _mm_sub_ps(far, near));
+    const __m128 tex_cut  = _mm_add_ps(tex_near,
+        _mm_mul_ps(_mm_sub_ps(tex_far, tex_near), ratio));
+    tex_far = select(keep, tex_far, select(collapse, tex_far, tex_cut));
+    far     = select(keep, far    , select(collapse, near   , cut    ));
+}
+
+// as DrawableCharacter::cut_on_left
+inline void cut_near_side
+    (__m128 cut, __m128 & near, __m128 far, __m128 & tex_near, __m128 tex_far)
+{
+    const __m128 keep     = _mm_cmplt_ps(cut, near);
+    const __m128 collapse = _mm_cmpgt_ps(cut, far);
+    const __m128 ratio    = _mm_div_ps(_mm_sub_ps(cut, near), _mm_sub_ps(far, near));
+    const __m128 tex_cut  = _mm_add_ps(tex_near,
+        _mm_mul_ps(_mm_sub_ps(tex_far, tex_near), ratio));
+    tex_near = select(keep, tex_near, select(collapse, tex_near, tex_cut));
+    near     = select(keep, near    , select(collapse, far     , cut    ));
+}
+
+std::size_t make_clipped_quads_sse2
+    (const GlyphRun & run, const QuadClip & clip, sf::Vertex * out)
+{
+    static constexpr const std::size_t k_lanes = 4;
+    const __m128 bottom     = _mm_set1_ps(clip.bottom    );
+    const __m128 right      = _mm_set1_ps(clip.right     );
+    const __m128 view_left  = _mm_set1_ps(clip.view_left );
+    const __m128 view_right = _mm_set1_ps(clip.view_right);
+    const __m128 offset_x   = _mm_set1_ps(clip.offset.x  );
+    const __m128 offset_y   = _mm_set1_ps(clip.offset.y  );
+
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + k_lanes <= run.size; i += k_lanes) {
+        // quads, as DrawableCharacter's constructor makes them
+        __m128 l  = _mm_load_ps(run.x + i);
+        __m128 t  = _mm_load_ps(run.y + i);
+        __m128 r  = _mm_add_ps(l, _mm_load_ps(run.width  + i));
+        __m128 b  = _mm_add_ps(t, _mm_load_ps(run.height + i));
+        __m128 tl = _mm_load_ps(run.tex_left + i);
+        __m128 tt = _mm_load_ps(run.tex_top  + i);
+        __m128 tr = _mm_add_ps(tl, _mm_load_ps(run.tex_width  + i));
+        __m128 tb = _mm_add_ps(tt, _mm_load_ps(run.tex_height + i));
+
+        cut_far_side(bottom, t, b, tt, tb);
+        cut_far_side(right , l, r, tl, tr);
+        const __m128 whiped = is_whiped_out(l, t, r, b);
+
+        const __m128 inside = _mm_and_ps(_mm_cmpge_ps(l, view_left),
+            _mm_cmple_ps(_mm_add_ps(l, _mm_sub_ps(r, l)), view_right));
+        __m128 cut_l = l, cut_r = r, cut_tl = tl, cut_tr = tr;
+        cut_near_side(view_left , cut_l, cut_r, cut_tl, cut_tr);
+        cut_far_side (view_right, cut_l, cut_r, cut_tl, cut_tr);
+        l  = select(inside, l , cut_l );
+        r  = select(inside, r , cut_r );
+        tl = select(inside, tl, cut_tl);
+        tr = select(inside, tr, cut_tr);
+
+        int kept = ~_mm_movemask_ps(_mm_or_ps(whiped, is_whiped_out(l, t, r, b)))
+                 & ((1 << k_lanes) - 1);
+        if (!kept) continue;
+        alignas(16) float edges[k_edge_count][k_lanes];
+        _mm_store_ps(edges[k_left      ], _mm_add_ps(l, offset_x));
+        _mm_store_ps(edges[k_top       ], _mm_add_ps(t, offset_y));
+        _mm_store_ps(edges[k_right     ], _mm_add_ps(r, offset_x));
+        _mm_store_ps(edges[k_bottom    ], _mm_add_ps(b, offset_y));
+        _mm_store_ps(edges[k_tex_left  ], tl);
+        _mm_store_ps(edges[k_tex_top   ], tt);
+        _mm_store_ps(edges[k_tex_right ], tr);
+        _mm_store_ps(edges[k_tex_bottom], tb);
+        for (std::size_t lane = 0; lane != k_lanes; ++lane) {
+            if (!(kept & (1 << lane))) continue;
+            float quad[k_edge_count];
+            for (int e = 0; e != k_edge_count; ++e) quad[e] = edges[e][lane];
+            write_quad(out + count*4, quad, run.colors[i + lane]);
+            ++count;
+        }
+    }
+    return count + make_clipped_quads_scalar(run, i, clip, out + count*4);
+}
+
+#endif
+
+#ifdef MACRO_KSG_AVX2_QUAD_KERNEL
+
+// (FMA is not enabled, so that no multiply and add is fused)
+#define MACRO_KSG_AVX2_TARGET __attribute__((target("avx2")))
+
+MACRO_KSG_AVX2_TARGET inline __m256 select(__m256 mask, __m256 a, __m256 b)
+    { return _mm256_blendv_ps(b, a, mask); }
+
+MACRO_KSG_AVX2_TARGET inline __m256 is_whiped_out
+    (__m256 l, __m256 t, __m256 r, __m256 b)
+{
+    const __m256 sign = _mm256_set1_ps(-0.f);
+    const __m256 one  = _mm256_set1_ps(1.f);
+    return _mm256_or_ps(
+        _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(r, l)), one, _CMP_LT_OQ),
+        _mm256_cmp_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(b, t)), one, _CMP_LT_OQ));
+}
+
+MACRO_KSG_AVX2_TARGET inline void cut_far_side
+    (__m256 cut, __m256 near, __m256 & far, __m256 tex_near, __m256 & tex_far)
+{
+    const __m256 keep     = _mm256_cmp_ps(cut, far , _CMP_GT_OQ);
+    const __m256 collapse = _mm256_cmp_ps(cut, near, _CMP_LT_OQ);
+    const __m256 ratio    = _mm256_div_ps(_mm256_sub_ps(cut, near), _mm256_sub_ps(far, near));
+    const __m256 tex_cut  = _mm256_add_ps(tex_near,
+        _mm256_mul_ps(_mm256_sub_ps(tex_far, tex_near), ratio));
+    tex_far = select(keep, tex_far, select(collapse, tex_far, tex_cut));
+    far     = select(keep, far    , select(collapse, near   , cut    ));
+}
+
+MACRO_KSG_AVX2_TARGET inline void cut_near_side
+    (__m256 cut, __m256 & near, __m256 far, __m256 & tex_near, __m256 tex_far)
+{
+    const __m256 keep     = _mm256_cmp_ps(cut, near, _CMP_LT_OQ);
+    const __m256 collapse = _mm256_cmp_ps(cut, far , _CMP_GT_OQ);
+    const __m256 ratio    = _mm256_div_ps(_mm256_sub_ps(cut, near), _mm256_sub_ps(far, near));
+    const __m256 tex_cut  = _mm256_add_ps(tex_near,
+        _mm256_mul_ps(_mm256_sub_ps(tex_far, tex_near), ratio));
+    tex_near = select(keep, tex_near, select(collapse, tex_near, tex_cut));
+    near     = select(keep, near    , select(collapse, far     , cut    ));
+}
+
+MACRO_KSG_AVX2_TARGET std::size_t make_clipped_quads_avx2
+    (const GlyphRun & run, const QuadClip & clip, sf::Vertex * out)
+{
+    static constexpr const std::size_t k_lanes = 8;
+    const __m256 bottom     = _mm256_set1_ps(clip.bottom    );
+    const __m256 right      = _mm256_set1_ps(clip.right     );
+    const __m256 view_left  = _mm256_set1_ps(clip.view_left );
+    const __m256 view_right = _mm256_set1_ps(clip.view_right);
+    const __m256 offset_x   = _mm256_set1_ps(clip.offset.x  );
+    const __m256 offset_y   = _mm256_set1_ps(clip.offset.y  );
+
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + k_lanes <= run.size; i += k_lanes) {
+        __m256 l  = _mm256_load_ps(run.x + i);
+        __m256 t  = _mm256_load_ps(run.y + i);
+        __m256 r  = _mm256_add_ps(l, _mm256_load_ps(run.width  + i));
+        __m256 b  = _mm256_add_ps(t, _mm256_load_ps(run.height + i));
+        __m256 tl = _mm256_load_ps(run.tex_left + i);
+        __m256 tt = _mm256_load_ps(run.tex_top  + i);
+        __m256 tr = _mm256_add_ps(tl, _mm256_load_ps(run.tex_width  + i));
+        __m256 tb = _mm256_add_ps(tt, _mm256_load_ps(run.tex_height + i));
+
+        cut_far_side(bottom, t, b, tt, tb);
+        cut_far_side(right , l, r, tl, tr);
+        const __m256 whiped = is_whiped_out(l, t, r, b);
+
+        const __m256 inside = _mm256_and_ps(
+            _mm256_cmp_ps(l, view_left, _CMP_GE_OQ),
+            _mm256_cmp_ps(_mm256_add_ps(l, _mm256_sub_ps(r, l)), view_right, _CMP_LE_OQ));
+        __m256 cut_l = l, cut_r = r, cut_tl = tl, cut_tr = tr;
+        cut_near_side(view_left , cut_l, cut_r, cut_tl, cut_tr);
+        cut_far_side (view_right, cut_l, cut_r, cut_tl, cut_tr);
+        l  = select(inside, l , cut_l );
+        r  = select(inside, r , cut_r );
+        tl = select(inside, tl, cut_tl);
+        tr = select(inside, tr, cut_tr);
+
+        int kept = ~_mm256_movemask_ps(_mm256_or_ps(whiped, is_whiped_out(l, t, r, b)))
+                 & ((1 << k_lanes) - 1);
+        if (!kept) continue;
+        alignas(32) float edges[k_edge_count][k_lanes];
+        _mm256_store_ps(edges[k_left      ], _mm256_add_ps(l, offset_x));
+        _mm256_store_ps(edges[k_top       ], _mm256_add_ps(t, offset_y));
+        _mm256_store_ps(edges[k_right     ], _mm256_add_ps(r, offset_x));
+        _mm256_store_ps(edges[k_bottom    ], _mm256_add_ps(b, offset_y));
+        _mm256_store_ps(edges[k_tex_left  ], tl);
+        _mm256_store_ps(edges[k_tex_top   ], tt);
+        _mm256_store_ps(edges[k_tex_right ], tr);
+        _mm256_store_ps(edges[k_tex_bottom], tb);
+        for (std::size_t lane = 0; lane != k_lanes; ++lane) {
+            if (!(kept & (1 << lane))) continue;
+            float quad[k_edge_count];
+            for (int e = 0; e != k_edge_count; ++e) quad[e] = edges[e][lane];
+            write_quad(out + count*4, quad, run.colors[i + lane]);
+            ++count;
+        }
+    }
+    return count + make_clipped_quads_scalar(run, i, clip, out + count*4);
+}
+
+#undef MACRO_KSG_AVX2_TARGET
+
+#endif
+
+} // end of <anonymous> namespace
@@ -21,9 +21,13 @@
 
 #include <ksg/SelectionMenu.hpp>
 #include <ksg/TextArea.hpp>
+#include <ksg/GlyphPrewarmer.hpp>
 
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Window/Event.hpp>
+
+#include <algorithm>
+#include <map>
 #if 0
 #include <iostream>
 #endif
@@ -56,16 +60,25 @@ void SelectionEntry::assign_parent(SelectionEntryReciever & parent, std::size_t
 }
 
 void SelectionEntry::set_string(const UString & ustr) {
+    flag_visual_change();
     m_display_text.set_string(ustr);
     recenter_text();
 }
 
 void SelectionEntry::set_string(UString && ustr) {
+    flag_visual_change();
     m_display_text.set_string(std::move(ustr));
     recenter_text();
 }
 
+void SelectionEntry::set_string(std::string_view utf8) {
+    flag_visual_change();
+    m_display_text.set_string(utf8);
+    recenter_text();
+}
+
 void SelectionEntry::set_location(float x, float y) {
+    flag_visual_change();
     m_background.set_position(x + padding(), y + padding());
     recenter_text();
 }
@@ -83,6 +96,7 @@ float SelectionEntry::height() const {
 }
 
 void SelectionEntry::set_size(float width, float height) {
+    flag_visual_change();
     if (width == 0.f || height == 0.f) return;
     m_background.set_size(width - padding()*2.f, height - padding()*2.f);
     m_display_text.set_limiting_dimensions(width, height);
@@ -93,6 +107,7 @@ const UString & SelectionEntry::string() const
     { return m_display_text.string(); }
 
 void SelectionEntry::set_style(const StyleMap & styles) {
+    flag_visual_change();
 
     using SelMenu = SelectionMenu;
     m_display_text.assign_font(styles, styles::k_global_font);
@@ -126,9 +141,15 @@ void SelectionEntry::set_style(const StyleMap & styles) {
     m_background.set_color(m_no_highlight);
 }
 
+void SelectionEntry::add_glyphs_to(GlyphPrewarmer & prewarmer) const
+    { prewarmer.add(m_display_text); }
+
 float SelectionEntry::content_width() const
     { return m_display_text.width() + padding()*2.f; }
 
+float SelectionEntry::content_width(float text_width) const
+    { return text_width + padding()*2.f; }
+
 float SelectionEntry::content_height() const
     { return m_display_text.height() + padding()*2.f; }
 
@@ -210,6 +231,7 @@ float SelectionEntry::content_height() const
 /* private static */ constexpr const std::size_t SelectionMenu::k_uninit;
 
 void SelectionMenu::add_options(std::vector<UString> && options) {
+    flag_visual_change();
     if (!m_entries.empty()) {
         if (m_entries.size() != options.size()) {
             throw std::invalid_argument(
@@ -219,7 +241,7 @@ void SelectionMenu::add_options(std::vector<UString> && options) {
         }
     }
     m_entries.reserve(options.size());
-    for (auto opt : options) {
+    for (auto & opt : options) {
         m_entries.emplace_back();
         SelectionEntry & entry = m_entries.back();
         entry.assign_parent(*this, m_entries.size() - 1);
@@ -229,7 +251,17 @@ void SelectionMenu::add_options(std::vector<UString> && options) {
     options.clear();
 }
 
+void SelectionMenu::add_options(const std::vector<std::string> & utf8_options) {
+    flag_visual_change();
+    // decoded strings are moved into the entries' texts, not copied
+    std::vector<UString> options(utf8_options.size());
+    for (std::size_t i = 0; i != options.size(); ++i)
+        { decode_utf8(utf8_options[i], options[i], Utf8Errors::k_replace); }
+    add_options(std::move(options));
+}
+
 void SelectionMenu::set_size(float width_, float height_) {
+    flag_visual_change();
     m_bounds.width = width_;
     m_bounds.height = height_;
     for (auto & entry : m_entries) {
@@ -268,9 +300,14 @@ void SelectionMenu::set_size(float width_, float height_) {
 }
 
 /* private */ void SelectionMenu::set_style(const StyleMap & smap) {
+    // a menu may have thousands of entries, they are laid out together once
+    // all of their fonts and sizes are set
+    ParallelTextLayout layouts;
+    for (auto & wid : m_entries) wid.defer_layout_to(layouts);
     for (auto & wid : m_entries) {
         wid.set_style(smap);
     }
+    layouts.run();
 }
 
 /* private */ void SelectionMenu::iterate_children_(ChildWidgetIterator & itr) {
@@ -305,10 +342,34 @@ void SelectionMenu::set_size(float width_, float height_) {
 }
 
 /* private */ void SelectionMenu::issue_auto_resize() {
+    // strings are measured unwrapped, in one batch per font and size (most
+    // menus have only the one)
+    using FontAndSize = std::pair<const sf::Font *, int>;
+    std::map<FontAndSize, std::vector<std::size_t>> batches;
+    for (std::size_t i = 0; i != m_entries.size(); ++i) {
+        const auto & text = m_entries[i].display_text();
+        if (!text.has_font_assigned()) continue;
+        batches[FontAndSize(&text.assigned_font(), text.character_size())].push_back(i);
+    }
+    std::vector<float> text_widths(m_entries.size(), 0.f);
+    std::vector<const UString *> strings;
+    for (const auto & batch : batches) {
+        strings.clear();
+        for (auto i : batch.second) strings.push_back(&m_entries[i].string());
+        auto widths = Text::measure_widths
+            (*batch.first.first, batch.first.second, strings, true);
+        for (std::size_t j = 0; j != widths.size(); ++j)
+            { text_widths[batch.second[j]] = widths[j]; }
+    }
+    // an entry's laid out text maybe wider than the sum of its advances
+    // (glyphs may overhang their advances, and markup may set parts of it
+    // in other fonts and sizes)
     float entry_width  = 0.f;
     float entry_height = 0.f;
-    for (const auto & wid : m_entries) {
-        entry_width  = std::max(entry_width , wid.content_width ());
+    for (std::size_t i = 0; i != m_entries.size(); ++i) {
+        const auto & wid = m_entries[i];
+        entry_width  = std::max({ entry_width, wid.content_width(),
+                                  wid.content_width(text_widths[i]) });
         entry_height = std::max(entry_height, wid.content_height());
     }
     for (auto & wid : m_entries) {
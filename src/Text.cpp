@@ -47,13 +47,27 @@
 #include <common/Util.hpp>
 
 #include <ksg/DrawCharacter.hpp>
+#include <ksg/GlyphAtlas.hpp>
+#include <ksg/QuadKernels.hpp>
+#include <ksg/TextLayoutCache.hpp>
+#include <ksg/ParallelTextLayout.hpp>
 
 #include <SFML/Graphics/RenderTarget.hpp>
 
 #include <array>
+#include <atomic>
+#include <exception>
 #include <memory>
 #include <algorithm>
-
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <functional>
+#include <unordered_map>
+#include <type_traits>
+
+#include <cmath>
 #include <cassert>
 
 using UChar                  = ksg::Text::UString::value_type;
@@ -65,38 +79,387 @@ using TextSize               = ksg::Text::TextSize;
 using VectorF                = ksg::Text::VectorF;
 using InvalidArg             = std::invalid_argument;
 using DrawableCharacter      = ksg::detail::DrawableCharacter;
+using GlyphQuad              = ksg::detail::GlyphQuad;
+using ColorSpan              = ksg::detail::ColorSpan;
+using TextStyle              = ksg::detail::TextStyle;
+using StyleRun               = ksg::detail::StyleRun;
+using GlyphAtlas             = ksg::GlyphAtlas;
+using MonospaceMetrics       = ksg::detail::MonospaceMetrics;
+using MonospaceMetricsCache  = ksg::detail::MonospaceMetricsCache;
 
 namespace {
 
 bool is_whitespace(UChar c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
 bool is_newline   (UChar c) { return c == '\n'; }
 
+// chunks alternate between breakable (whitespace), newlines and
+// unbreakable text
+// @returns end of the chunk starting at beg (beg must not be end)
+UString::const_iterator next_chunk_end
+    (UString::const_iterator beg, UString::const_iterator end);
+
 // each iterator is a chunk begining
 // we can and SHOULD test this! :)
 std::vector<UString::const_iterator> find_chunks_dividers(const UString &);
 
-void place_renderables(const sf::Font & font, const UString & ustr,
-       float width_constraint, int char_size, sf::Color color,
-       std::vector<DrawableCharacter> & renderables);
-
-void cut_renderables(float width_constraint, float height_constraint,
-                     std::vector<DrawableCharacter> & renderables);
+// ------------------------------ monospace fast path -------------------------
+// Monospaced fonts have a constant advance and no kerning, widths are then
+// simply count*advance. This is only taken for characters known to share
+// the advance (printable ASCII), and advances that are multiples of 1/64th
+// (as FreeType gives them), so that the products are exactly equal to
+// summing advances one by one.
+
+constexpr const UChar k_monospace_first = U' ';
+constexpr const UChar k_monospace_last  = U'~';
+constexpr const std::size_t k_monospace_count =
+    std::size_t(k_monospace_last - k_monospace_first) + 1;
+// widths are exact up to this (24 bit mantissa, 6 of which are fractional)
+constexpr const float k_monospace_exact_limit = float(1 << 18);
+
+bool is_monospace_char(UChar c)
+    { return c >= k_monospace_first && c <= k_monospace_last; }
+
+/** Detection is done once per font and size, and shared by all text.
+ *  @param hinted if the font is said to be monospaced, kerning is not checked
+ */
+MonospaceMetrics find_monospace_metrics
+    (const sf::Font &, int char_size, bool hinted);
+
+/** As find_monospace_metrics, though only the first lookup (for each hint)
+ *  is shared, others are answered by the cache.
+ */
+const MonospaceMetrics & find_monospace_metrics
+    (MonospaceMetricsCache &, const sf::Font &, int char_size, bool hinted);
+
+float measure_line_width
+    (const sf::Font & font, int char_size, bool monospace_hint,
+     UString::const_iterator beg, UString::const_iterator end);
+
+// as above, with monospace metrics from the cache
+float measure_line_width
+    (MonospaceMetricsCache &, const sf::Font & font, int char_size,
+     bool monospace_hint, UString::const_iterator beg, UString::const_iterator end);
+
+/** Distance field atlases scale glyph metrics from one reference size, text
+ *  using one is then measured from the atlas' glyphs rather than the font's
+ *  (which would rasterize every size), and never takes the monospace path.
+ */
+bool has_scaled_metrics(const GlyphAtlas * atlas)
+    { return atlas && atlas->mode() == GlyphAtlas::Mode::k_distance_field; }
+
+// ---------------------------- metrics snapshots ---------------------------
+// Fonts (and atlases) are not thread safe. Measuring and laying out many
+// strings is split in two: first all metrics the strings need are looked
+// up into a snapshot (see ksg::detail::GlyphMetricsSnapshot, below), on the
+// font's thread; then strings are measured or laid out reading only the
+// snapshot, maybe on several threads.
+
+// batches with fewer characters are always measured on the calling thread
+constexpr const std::size_t k_parallel_measure_threshold = 1 << 16;
+// likewise for layouts, which do much more per character
+constexpr const std::size_t k_parallel_layout_threshold  = 1 << 12;
+
+template <typename StringAt>
+std::vector<float> measure_widths_of
+    (const sf::Font &, int char_size, std::size_t count, StringAt && string_at,
+     bool in_parallel);
+
+// ------------------------------- styles -----------------------------------
+// Style 0 is the text's own font and size, others are its styles from one.
+
+const sf::Font & font_of_style
+    (const sf::Font & own_font, const std::vector<TextStyle> &, int style);
+
+int size_of_style(int own_size, const std::vector<TextStyle> &, int style);
+
+// finds the styles of characters, walking along them (stepping back is
+// allowed, but slower)
+class StyleCursor {
+public:
+    explicit StyleCursor(const std::vector<StyleRun> & runs):
+        m_runs(runs), m_itr(runs.begin()) {}
+
+    int style_at(std::size_t index);
+
+private:
+    const std::vector<StyleRun> & m_runs;
+    std::vector<StyleRun>::const_iterator m_itr;
+};
+
+// moves spans as count characters are inserted before index (a span
+// which the insertion falls in grows)
+template <typename SpanType>
+void insert_into_spans(std::vector<SpanType> &, int index, int count);
+
+template <typename SpanType>
+void erase_from_spans(std::vector<SpanType> &, int index, int count);
+
+// drops spans emptied by erasing, and joins touching spans of the same
+// value
+template <typename SpanType>
+void merge_spans(std::vector<SpanType> &);
+
+bool has_same_value(const ColorSpan & lhs, const ColorSpan & rhs)
+    { return lhs.color == rhs.color; }
+
+bool has_same_value(const StyleRun & lhs, const StyleRun & rhs)
+    { return lhs.style == rhs.style; }
+
+struct LayoutSettings {
+    const sf::Font & font;
+    int char_size;
+    const std::vector<TextStyle> & styles;
+    const std::vector<StyleRun> & style_runs;
+    float line_spacing;
+    int baseline_offset;
+    float width_constraint;
+    bool monospace_hint;
+    // the text's own, not used if metrics are given
+    MonospaceMetricsCache & monospace_metrics;
+    ksg::GlyphAtlas * atlas;
+    // if not null, all metrics are read from this instead of the font (and
+    // atlas), which are then never touched
+    const ksg::detail::GlyphMetricsSnapshot * metrics;
+};
+
+// all but the line and glyph tables have an element per character
+struct LayoutOutput {
+    std::vector<VectorF>       & glyph_origins;
+    std::vector<std::uint32_t> & glyph_ids;
+    // new glyphs are added as they are met
+    std::vector<GlyphQuad> & glyph_quads;
+    std::unordered_map<std::uint64_t, std::uint32_t> & glyph_ids_by_char;
+    std::vector<float> & character_offsets;
+    std::vector<int>   & line_starts;
+    std::vector<float> & line_widths;
+    // chunk tables must end with the last chunk before start
+    std::vector<int>   & chunk_ends;
+    std::vector<float> & chunk_widths;
+    std::vector<float> & chunk_advances;
+};
+
+/** Places characters from start up to stop, continuing from the given pen
+ *  position.
+ *  Outputs must already be sized for the string, and line tables must end
+ *  with the line which start is on.
+ *  @param stop the string's length, or a chunk boundary, only placing to
+ *         the string's end finishes the last line (and the end's offset)
+ *  @param start_wrapped true if start begins a line because its chunk was
+ *         wrapped, the chunk is then not checked for wrapping again
+ *  @returns the pen position at stop
+ */
+VectorF place_renderables(const LayoutSettings &, const UString &,
+                          std::size_t start, std::size_t stop, bool start_wrapped,
+                          VectorF write_pos, LayoutOutput);
+
+/** Cuts characters from start to the end, and stores a running maximum of
+ *  the right/bottom edges of characters which are still visible. Cuts are
+ *  not kept, characters are cut again as they are expanded to be drawn.
+ *  @param expand f(std::size_t index) returning the character's uncut quad
+ *  @returns true if any character was (possibly) cut
+ */
+template <typename ExpandFunc>
+bool cut_renderables(float width_constraint, float height_constraint,
+                     std::size_t start, ExpandFunc && expand,
+                     std::vector<VectorF> & extents);
+
+// shared by all text, so that quads are expanded into the same memory
+// each draw
+VertexContainer & draw_buffer();
+
+// the line and chunk tables of what an edit places again, before they're
+// spliced into the text's, shared by all text so that edits need not
+// allocate
+struct EditTables {
+    std::vector<int>   line_starts;
+    std::vector<float> line_widths;
+    std::vector<int>   chunk_ends;
+    std::vector<float> chunk_widths;
+    std::vector<float> chunk_advances;
+};
+
+EditTables & edit_tables();
+
+// as cut_renderables, for a character which can not be cut (without width
+// and height constraints): grows the extent to the character's right/bottom
+// edges, if it's visible
+void extend_to_character(VectorF & extent, VectorF origin, const GlyphQuad &);
 
 } // end of <anonymous> namespace
 
 namespace ksg {
 
+namespace detail {
+
+/** Glyph metrics of one font and size (and atlas) for the strings added to
+ *  it. Adding a string looks up (rasterizing as needed) everything that
+ *  measuring or laying it out needs, in the same order that doing so
+ *  directly would, so that fonts and atlases end up just as they would.
+ *  Strings are added on the font's thread, afterward the snapshot is only
+ *  read, and maybe shared by any number of threads.
+ */
+class GlyphMetricsSnapshot {
+public:
+    struct Entry {
+        sf::Glyph glyph;
+        int page = 0;
+        bool is_known = false;
+    };
+
+    GlyphMetricsSnapshot(const sf::Font &, int char_size, GlyphAtlas * atlas,
+                         bool monospace_hint);
+
+    // everything measure_line_width needs (without the monospace hint)
+    void add_measured(UString::const_iterator beg, UString::const_iterator end);
+
+    // everything place_renderables needs, for a whole unstyled string
+    void add_laid_out(const UString &);
+
+    // the same as measure_line_width (without the monospace hint)
+    float width_of(UString::const_iterator beg, UString::const_iterator end) const;
+
+    // the glyph for a character's quad (from the atlas if there is one)
+    const Entry & quad_glyph(UChar) const;
+
+    float kerning(UChar, UChar) const;
+
+    float line_spacing() const noexcept { return m_line_spacing; }
+
+    // @returns what place_renderables finds for a whole string
+    MonospaceMetrics layout_monospace(const UString &) const;
+
+private:
+    class GlyphTable {
+    public:
+        Entry & operator [] (UChar);
+        const Entry & operator [] (UChar) const;
+    private:
+        std::array<Entry, k_monospace_count> m_ascii;
+        std::unordered_map<UChar, Entry> m_others;
+    };
+
+    // not yet looked up
+    static float unknown() { return std::numeric_limits<float>::quiet_NaN(); }
+
+    static bool is_layout_monospace_char(UChar c)
+        { return is_newline(c) || is_monospace_char(c); }
+
+    bool is_monospace_range
+        (UString::const_iterator beg, UString::const_iterator end) const;
+
+    const Entry & look_up_font_glyph(UChar);
+
+    const Entry & look_up_quad_glyph(UChar);
+
+    void look_up_kerning(UChar, UChar);
+
+    float & kerning_slot(UChar, UChar);
+
+    const sf::Font & m_font;
+    unsigned m_char_size;
+    GlyphAtlas * m_atlas;
+    bool m_monospace_hint;
+    float m_line_spacing;
+    // as find_monospace_metrics gives, with and without the hint
+    bool m_has_mono = false;
+    MonospaceMetrics m_mono;
+    bool m_has_layout_mono = false;
+    MonospaceMetrics m_layout_mono;
+    GlyphTable m_font_glyphs;
+    // only used with an atlas (otherwise the font's glyphs are the quads')
+    GlyphTable m_atlas_glyphs;
+    // ascii pairs, indexed first*k_monospace_count + second
+    std::vector<float> m_ascii_kernings;
+    std::unordered_map<std::uint64_t, float> m_kernings;
+};
+
+} // end of detail namespace
+
 /* static */ constexpr const int   Text::k_max_string_length;
 /* static */ constexpr const float Text::k_inf;
 
 void Text::set_string(const UString & str) {
-    UString temp(str);
-    set_string(std::move(temp));
+    // assigning reuses the string's memory
+    m_string = str;
+    update_after_new_string();
 }
 
 void Text::set_string(UString && str) {
     m_string.swap(str);
-    update_geometry();
+    update_after_new_string();
+}
+
+void Text::set_string(std::u32string_view str) {
+    m_string.assign(str.begin(), str.end());
+    update_after_new_string();
+}
+
+void Text::set_string(const UChar * str) {
+    set_string(std::u32string_view(str));
+}
+
+void Text::set_string(std::string_view utf8) {
+    decode_utf8(utf8, m_string, Utf8Errors::k_replace);
+    update_after_new_string();
+}
+
+void Text::insert(int index, const UString & str) {
+    if (index < 0 || std::size_t(index) > m_string.size()) {
+        throw std::out_of_range(
+            "Text::insert: index must be [0 len], where \"len\" is the "
+            "length of this text's string.");
+    }
+    if (str.empty()) return;
+    const bool had_layout = has_layout();
+    m_string.insert(std::size_t(index), str);
+    insert_into_spans(m_color_spans, index, int(str.size()));
+    insert_into_spans(m_style_runs , index, int(str.size()));
+    if (!had_layout) return update_geometry();
+
+    // shift everything after the edit, only those are laid out again
+    unshare_layout();
+    auto splice = [index, &str](auto & container) {
+        using ValueType = typename std::remove_reference_t<decltype(container)>::value_type;
+        container.insert(container.begin() + index, str.size(), ValueType());
+    };
+    splice(m_layout->glyph_origins);
+    splice(m_layout->glyph_ids);
+    splice(m_layout->extents);
+    splice(m_layout->character_offsets);
+    if (std::none_of(str.begin(), str.end(), is_newline) &&
+        place_edit_within_line(index, 0, int(str.size())))
+    { return; }
+    update_geometry_after(index);
+}
+
+void Text::erase(int index, int count) {
+    if (index < 0 || std::size_t(index) > m_string.size() || count < 0) {
+        throw std::out_of_range(
+            "Text::erase: index must be [0 len], where \"len\" is the "
+            "length of this text's string, and count must be non-negative.");
+    }
+    count = std::min(count, int(m_string.size()) - index);
+    if (count == 0) return;
+    const bool had_layout = has_layout();
+    const auto erased_beg = m_string.begin() + index;
+    const bool erases_newline =
+        std::any_of(erased_beg, erased_beg + count, is_newline);
+    m_string.erase(std::size_t(index), std::size_t(count));
+    erase_from_spans(m_color_spans, index, count);
+    erase_from_spans(m_style_runs , index, count);
+    if (!had_layout) return update_geometry();
+
+    unshare_layout();
+    auto splice = [index, count](auto & container) {
+        auto beg = container.begin() + index;
+        container.erase(beg, beg + count);
+    };
+    splice(m_layout->glyph_origins);
+    splice(m_layout->glyph_ids);
+    splice(m_layout->extents);
+    splice(m_layout->character_offsets);
+    if (!erases_newline && place_edit_within_line(index, count, 0)) return;
+    update_geometry_after(index);
 }
 
 void Text::set_limiting_width(float w) {
@@ -120,6 +483,8 @@ void Text::set_limiting_dimensions(float w, float h) {
     if (h <= 0.f) { throw InvalidArg(make_bad_dim_msg("height")); }
     m_width_constraint  = w;
     m_height_constraint = h;
+    // while a frame is being resized, only line breaking needs to be redone
+    if (rewrap_renderables()) return;
     update_geometry();
 }
 
@@ -135,7 +500,22 @@ void Text::relieve_size_limit() {
     set_limiting_dimensions(k_inf, k_inf);
 }
 
+void Text::set_viewport(float offset, float width) {
+    if (width <= 0.f) {
+        throw InvalidArg("Text::set_viewport: width must be a positive real "
+                         "number, or infinity.");
+    }
+    m_viewport_offset = offset;
+    m_viewport_width  = width;
+}
+
+void Text::relieve_viewport() {
+    m_viewport_offset = 0.f;
+    m_viewport_width  = k_inf;
+}
+
 void Text::set_character_size(int char_size) {
+    if (char_size != m_char_size) reset_glyph_quads();
     m_char_size = char_size;
     update_geometry();
 }
@@ -156,29 +536,168 @@ void Text::set_location(VectorF r) {
 
 void Text::assign_font(const sf::Font * ptr) {
     m_font_ptr = FontMtPtr(ptr);
+    reset_glyph_quads();
     update_geometry();
 }
 
 void Text::assign_font(const std::shared_ptr<const sf::Font> & ptr) {
     m_font_ptr = FontMtPtr(ptr);
+    reset_glyph_quads();
+    update_geometry();
+}
+
+void Text::assign_glyph_atlas(GlyphAtlas * atlas) {
+    if (atlas != m_glyph_atlas) reset_glyph_quads();
+    m_glyph_atlas = atlas;
+    update_geometry();
+}
+
+void Text::set_monospace_hint(bool b) {
+    m_monospace_hint = b;
     update_geometry();
 }
 
 void Text::set_color_for_character(int index, sf::Color clr) {
-    m_renderables.at(std::size_t(index)).set_color(clr);
+    if (index < 0 || std::size_t(index) >= m_string.size()) {
+        throw std::out_of_range(
+            "Text::set_color_for_character: index must be [0 len), where "
+            "\"len\" is the length of this text's string.");
+    }
+    set_color_span(index, index + 1, clr);
+}
+
+void Text::set_color_span(int begin, int end, sf::Color clr) {
+    if (begin < 0 || end < begin || std::size_t(end) > m_string.size()) {
+        throw std::out_of_range(
+            "Text::set_color_span: span must satisfy 0 <= begin <= end <= "
+            "len, where \"len\" is the length of this text's string.");
+    }
+    if (begin == end) return;
+    // spans overlapping the new one are replaced, save for the parts
+    // sticking out of either side
+    auto first = std::upper_bound(m_color_spans.begin(), m_color_spans.end(), begin,
+        [](int idx, const ColorSpan & span) { return idx < span.end; });
+    auto last = std::lower_bound(first, m_color_spans.end(), end,
+        [](const ColorSpan & span, int idx) { return span.begin < idx; });
+    std::array<ColorSpan, 3> replacements;
+    std::size_t count = 0;
+    if (first != last && first->begin < begin)
+        { replacements[count++] = ColorSpan { first->begin, begin, first->color }; }
+    replacements[count++] = ColorSpan { begin, end, clr };
+    if (first != last && (last - 1)->end > end)
+        { replacements[count++] = ColorSpan { end, (last - 1)->end, (last - 1)->color }; }
+
+    auto pos = m_color_spans.erase(first, last);
+    m_color_spans.insert(pos, replacements.begin(), replacements.begin() + std::ptrdiff_t(count));
+    merge_spans(m_color_spans);
+}
+
+void Text::clear_color_spans() {
+    m_color_spans.clear();
+}
+
+void Text::set_markup(const UString & markup) {
+    static const StyleMap k_no_named_styles;
+    set_markup(markup, k_no_named_styles);
+}
+
+void Text::set_markup(const UString & markup, const StyleMap & named_styles) {
+    // named styles may have changed since the last markup was set (as with a
+    // theme switch), so the markup is always compiled, only laying out again
+    // is skipped
+    auto compiled = detail::compile_markup(markup, named_styles);
+
+    auto same_style = [](const TextStyle & lhs, const TextStyle & rhs)
+        { return lhs.font == rhs.font && lhs.char_size == rhs.char_size; };
+    auto same_span = [](const ColorSpan & lhs, const ColorSpan & rhs)
+        { return lhs.begin == rhs.begin && lhs.end == rhs.end && lhs.color == rhs.color; };
+    auto same_run = [](const StyleRun & lhs, const StyleRun & rhs)
+        { return lhs.begin == rhs.begin && lhs.end == rhs.end && lhs.style == rhs.style; };
+    const bool has_same_styles =
+        std::equal(m_styles.begin(), m_styles.end(), compiled.styles.begin(),
+                   compiled.styles.end(), same_style);
+    if (   has_same_styles && m_string == compiled.string
+        && std::equal(m_color_spans.begin(), m_color_spans.end(),
+                      compiled.color_spans.begin(), compiled.color_spans.end(), same_span)
+        && std::equal(m_style_runs.begin(), m_style_runs.end(),
+                      compiled.style_runs.begin(), compiled.style_runs.end(), same_run))
+    { return; }
+
+    // quads are kept, unless styles they're for have changed
+    if (!has_same_styles) reset_glyph_quads();
+    m_styles.swap(compiled.styles);
+    m_style_runs.swap(compiled.style_runs);
+    m_color_spans.swap(compiled.color_spans);
+    m_string.swap(compiled.string);
+    update_geometry();
 }
 
+/* static */ UString Text::escape_markup(const UString & str)
+    { return detail::escape_markup(str); }
+
 VectorF Text::character_location(int index) const {
-    if (m_renderables.size() == std::size_t(index)) {
+    if (m_layout->glyph_origins.size() == std::size_t(index)) {
         return location() + VectorF(m_bounds.width, 0);
-    } else if (m_renderables.size() > std::size_t(index)) {
-        return m_renderables.at(std::size_t(index)).location();
+    } else if (m_layout->glyph_origins.size() > std::size_t(index)) {
+        return m_layout->glyph_origins.at(std::size_t(index));
     }
     throw std::out_of_range(
         "Text::character_location: index must be [0 len], where \"len\" is "
         "the length of this text's string.");
 }
 
+int Text::line_count() const noexcept {
+    return has_line_table() ? int(m_layout->line_starts.size()) : 0;
+}
+
+int Text::character_index_at(VectorF point) const {
+    if (!has_line_table()) return 0;
+    const auto & layout = *m_layout;
+    float line_y = (point.y - m_bounds.top) / line_height();
+    int line = int(std::floor(std::max(0.f, line_y)));
+    line = std::min(line, line_count() - 1);
+    // the last boundary of all but the last line is before its final
+    // character (a newline or the space a line wrapped after)
+    int begin = layout.line_starts[std::size_t(line)];
+    int last  = line_end(line);
+    if (line + 1 != line_count()) last = std::max(begin, last - 1);
+
+    float x = point.x - m_bounds.left;
+    if (m_viewport_width != k_inf) x += m_viewport_offset;
+    auto offsets_beg = layout.character_offsets.begin() + begin;
+    auto offsets_end = layout.character_offsets.begin() + last + 1;
+    auto itr = std::upper_bound(offsets_beg, offsets_end, x);
+    int index = std::max(begin, int(itr - layout.character_offsets.begin()) - 1);
+    // round to the closer boundary
+    if (index < last) {
+        float mid = (layout.character_offsets[std::size_t(index)] +
+                     layout.character_offsets[std::size_t(index + 1)]) / 2.f;
+        if (x > mid) ++index;
+    }
+    return index;
+}
+
+int Text::fitting_prefix_length(float width) const {
+    if (!has_line_table()) return 0;
+    int end = line_end(0);
+    if (m_layout->line_widths.front() <= width) return end;
+    if (end == 0) return 0;
+    auto offsets_beg = m_layout->character_offsets.begin();
+    // the prefix of length i ends where character i begins
+    auto itr = std::upper_bound(offsets_beg + 1, offsets_beg + end, width);
+    return int(itr - offsets_beg) - 1;
+}
+
+float Text::character_offset(int index) const {
+    if (index < 0 || std::size_t(index) > m_string.size()) {
+        throw std::out_of_range(
+            "Text::character_offset: index must be [0 len], where \"len\" is "
+            "the length of this text's string.");
+    }
+    if (!has_line_table()) return 0.f;
+    return m_layout->character_offsets[std::size_t(index)];
+}
+
 VectorF Text::location() const {
     return VectorF(m_bounds.left, m_bounds.top);
 }
@@ -189,7 +708,13 @@ float Text::height() const { return m_bounds.height; }
 
 float Text::line_height() const {
     if (!has_font_assigned()) return 0.f;
-    return font_ptr()->getLineSpacing(m_char_size);
+    float spacing = 0.f;
+    for (int style = 0; style != int(m_styles.size()) + 1; ++style) {
+        const auto & font = font_of_style(*font_ptr(), m_styles, style);
+        auto char_size = size_of_style(m_char_size, m_styles, style);
+        spacing = std::max(spacing, font.getLineSpacing(unsigned(char_size)));
+    }
+    return spacing;
 }
 
 const UString & Text::string() const
@@ -213,7 +738,19 @@ TextSize Text::measure_text(const UString & ustring) const {
 }
 
 float Text::measure_width(UStringConstIter beg, UStringConstIter end) {
-    return Text::measure_width(assigned_font(), m_char_size, beg, end);
+    if (m_char_size < 1) return 0.f;
+    if (has_scaled_metrics(m_glyph_atlas)) {
+        // (as layout measures, from the atlas' glyphs)
+        const auto & font = assigned_font();
+        float w = 0.f;
+        for (auto itr = beg; itr != end; ++itr) {
+            w += m_glyph_atlas->glyph(font, unsigned(m_char_size), *itr).glyph.advance;
+            if (itr + 1 != end) w += font.getKerning(*itr, *(itr + 1), unsigned(m_char_size));
+        }
+        return w;
+    }
+    return measure_line_width(m_monospace_metrics, assigned_font(), m_char_size,
+                              m_monospace_hint, beg, end);
 }
 
 float Text::maximum_height(UStringConstIter beg, UStringConstIter end) {
@@ -244,16 +781,25 @@ bool Text::is_visible() const {
      UStringConstIter beg, UStringConstIter end)
 {
     if (character_size < 1) return 0.f;
-    assert(beg <= end);
-    float w = 0.f;
-    for (auto itr = beg; itr != end; ++itr) {
-        const auto & glyph = font.getGlyph(*itr, character_size, false);
-        w += glyph.advance;
-        if (itr + 1 != end) {
-            w += font.getKerning(*itr, *(itr + 1), character_size);
-        }
-    }
-    return w;
+    return measure_line_width(font, character_size, false, beg, end);
+}
+
+/* static */ std::vector<float> Text::measure_widths
+    (const sf::Font & font, int character_size,
+     const std::vector<UString> & strings, bool in_parallel)
+{
+    return measure_widths_of(font, character_size, strings.size(),
+        [&strings](std::size_t i) -> const UString & { return strings[i]; },
+        in_parallel);
+}
+
+/* static */ std::vector<float> Text::measure_widths
+    (const sf::Font & font, int character_size,
+     const std::vector<const UString *> & strings, bool in_parallel)
+{
+    return measure_widths_of(font, character_size, strings.size(),
+        [&strings](std::size_t i) -> const UString & { return *strings[i]; },
+        in_parallel);
 }
 
 /* static */ float Text::maximum_height
@@ -294,17 +840,174 @@ bool Text::is_visible() const {
     assert(rv[2] - ustr.begin() == 4);
     assert(rv[3] == ustr.end());
     }
+    {
+    // a theme switch changes what names refer to, and not the markup
+    StyleMap theme;
+    theme["accent"] = StylesField(sf::Color::Red);
+    Text text;
+    text.set_markup(U"[color=accent]a[/color]b", theme);
+    assert(text.m_color_spans.size() == 1);
+    assert(text.m_color_spans[0].color == sf::Color::Red);
+    theme["accent"] = StylesField(sf::Color::Blue);
+    text.set_markup(U"[color=accent]a[/color]b", theme);
+    assert(text.m_color_spans.size() == 1);
+    assert(text.m_color_spans[0].color == sf::Color::Blue);
+    }
+}
+
+/* static */ void Text::run_tests(const sf::Font & font) {
+    // texts laid out from glyph metric snapshots, on several threads, must be
+    // laid out exactly as they are one after another
+    auto & cache = TextLayoutCache::instance();
+    const auto old_limit = cache.byte_limit();
+    cache.set_byte_limit(0);
+
+    std::vector<UString> strings;
+    for (int i = 0; i != 400; ++i) {
+        UString str = U"Entry " + UString(std::size_t(i % 7) + 1, char32_t(U'A' + char32_t(i % 26)));
+        if (i % 3 == 0) str += U" with \u00e9 accents, \u00fc and kerning: AVAWTo";
+        if (i % 5 == 0) str += U"\nand a second line\n\nafter a blank one";
+        if (i % 11 == 0) str += UString(300, U'x');
+        strings.push_back(std::move(str));
+    }
+    for (int size : { 12, 20 }) {
+    for (float width : { k_inf, 150.f }) {
+    for (bool hint : { false, true }) {
+        auto setup = [=](Text & text, const UString & str) {
+            text.assign_font(&font);
+            text.set_character_size(size);
+            text.set_monospace_hint(hint);
+            text.set_limiting_width(width);
+            text.set_string(str);
+        };
+        std::vector<Text> serial(strings.size()), parallel(strings.size());
+        for (std::size_t i = 0; i != strings.size(); ++i)
+            { setup(serial[i], strings[i]); }
+        {
+        ParallelTextLayout layouts(4);
+        for (auto & text : parallel) layouts.defer(text);
+        for (std::size_t i = 0; i != strings.size(); ++i)
+            { setup(parallel[i], strings[i]); }
+        layouts.run();
+        }
+        auto same_quad = [](const detail::GlyphQuad & lhs, const detail::GlyphQuad & rhs) {
+            return lhs.bounds == rhs.bounds && lhs.texture_rect == rhs.texture_rect &&
+                   lhs.advance == rhs.advance && lhs.page == rhs.page;
+        };
+        for (std::size_t i = 0; i != strings.size(); ++i) {
+            const auto & lhs = *serial  [i].m_layout;
+            const auto & rhs = *parallel[i].m_layout;
+            assert(lhs.glyph_origins     == rhs.glyph_origins    );
+            assert(lhs.extents           == rhs.extents          );
+            assert(lhs.character_offsets == rhs.character_offsets);
+            assert(lhs.line_starts       == rhs.line_starts      );
+            assert(lhs.line_widths       == rhs.line_widths      );
+            assert(lhs.glyph_ids.size()  == rhs.glyph_ids.size() );
+            for (std::size_t j = 0; j != lhs.glyph_ids.size(); ++j) {
+                assert(same_quad(lhs.glyph_quads[lhs.glyph_ids[j]],
+                                 rhs.glyph_quads[rhs.glyph_ids[j]]));
+            }
+            assert(serial[i].m_bounds == parallel[i].m_bounds);
+        }
+    }}}
+    cache.set_byte_limit(old_limit);
 }
 
 /* private */ void Text::draw
     (sf::RenderTarget & target, sf::RenderStates states) const
 {
     if (!has_font_assigned()) return;
-    states.texture = &font_ptr()->getTexture(unsigned(m_char_size));
-    states.transform.translate(m_bounds.left, m_bounds.top);
-    for (const auto & dc : m_renderables) {
-        target.draw(dc, states);
+    float scroll = (m_viewport_width == k_inf) ? 0.f : m_viewport_offset;
+    states.transform.translate(m_bounds.left - scroll, m_bounds.top);
+    // quads are expanded here, and drawn in one call per texture
+    auto & verticies = draw_buffer();
+    auto draw_page = [this, &target, &states, &verticies](int page) {
+        verticies.clear();
+        append_verticies(verticies, VectorF(), page);
+        if (!verticies.empty())
+            target.draw(verticies.data(), verticies.size(), sf::Quads, states);
+    };
+    if (!m_glyph_atlas) {
+        // glyphs are on their font's texture for their size, which is
+        // different for each style
+        if (m_styles.empty()) {
+            states.texture = &font_ptr()->getTexture(unsigned(m_char_size));
+            return draw_page(-1);
+        }
+        for (int style = 0; style != int(m_styles.size()) + 1; ++style) {
+            const auto & font = font_of_style(*font_ptr(), m_styles, style);
+            auto char_size = size_of_style(m_char_size, m_styles, style);
+            states.texture = &font.getTexture(unsigned(char_size));
+            draw_page(style);
+        }
+        return;
     }
+
+    m_glyph_atlas->flush();
+    states.shader = m_glyph_atlas->shader();
+    for (int page = 0; page != m_glyph_atlas->page_count(); ++page) {
+        states.texture = &m_glyph_atlas->page_texture(page);
+        draw_page(page);
+    }
+}
+
+/* private */ bool Text::has_layout() const noexcept {
+    const auto length = m_string.size();
+    return has_line_table() && m_layout->glyph_ids.size() == length &&
+           m_layout->glyph_origins.size() == length && m_layout->extents.size() == length &&
+           (!m_layout->chunk_ends.empty() || length == 0);
+}
+
+/* private */ std::pair<int, bool> Text::find_resumable_line
+    (int line, int last_unchanged) const noexcept
+{
+    // Layout may resume at the start of a line if:
+    // - the line was started by a newline (or is the first), it then starts
+    //   as any other line would, at the first of any empty lines, where its
+    //   first chunk's wrapping is still to be checked
+    // - its first chunk was wrapped, and is unchanged, it's then known
+    //   that the chunk starts the last line sharing its start
+    while (line > 0) {
+        int first = line;
+        while (first > 0 && m_layout->line_starts[std::size_t(first - 1)] ==
+                            m_layout->line_starts[std::size_t(first)])
+        { --first; }
+        int start = m_layout->line_starts[std::size_t(first)];
+        if (start == 0 || is_newline(m_string[std::size_t(start - 1)]))
+            return std::make_pair(first, false);
+
+        int last = line_of(start);
+        if (   std::size_t(last + 1) < m_layout->line_starts.size()
+            && m_layout->line_starts[std::size_t(last + 1)] <= last_unchanged)
+        { return std::make_pair(last, true); }
+        line = first - 1;
+    }
+    return std::make_pair(0, false);
+}
+
+/* private */ int Text::line_of(int index) const noexcept {
+    auto itr = std::upper_bound(m_layout->line_starts.begin(), m_layout->line_starts.end(), index);
+    return std::max(0, int(itr - m_layout->line_starts.begin()) - 1);
+}
+
+/* private */ bool Text::has_line_table() const noexcept {
+    return !m_layout->line_starts.empty() &&
+           m_layout->character_offsets.size() == m_string.size() + 1;
+}
+
+/* private */ bool Text::has_chunk_table() const noexcept {
+    if (m_layout->chunk_ends.empty()) return m_string.empty();
+    return std::size_t(m_layout->chunk_ends.back()) == m_string.size();
+}
+
+/* private */ std::size_t Text::chunk_begin_of(std::size_t index) const noexcept {
+    auto itr = std::upper_bound(m_layout->chunk_ends.begin(), m_layout->chunk_ends.end(), int(index));
+    return (itr == m_layout->chunk_ends.begin()) ? 0 : std::size_t(*(itr - 1));
+}
+
+/* private */ int Text::line_end(int line) const noexcept {
+    if (std::size_t(line + 1) == m_layout->line_starts.size()) return int(m_string.size());
+    return m_layout->line_starts[std::size_t(line + 1)];
 }
 
 /* private */ const sf::Font * Text::font_ptr() const noexcept {
@@ -317,113 +1020,1090 @@ bool Text::is_visible() const {
     }
 }
 
-void Text::update_geometry() {
-    if (!has_font_assigned() || m_char_size < 1 ||
-        (m_string.empty() && m_renderables.empty()))
-    { return; }
+void Text::update_geometry() { update_geometry_after(0); }
+
+void Text::update_geometry_after(int edit_index) {
+    if (m_is_layout_deferred) return defer_layout();
+    if (!has_font_assigned() || m_char_size < 1) return;
+
+    // only whole layouts are shared
+    const bool use_cache = edit_index == 0 && is_layout_cacheable();
+    detail::TextLayoutKey key;
+    if (use_cache) {
+        key = layout_cache_key();
+        if (auto layout = TextLayoutCache::instance().find(key, m_string)) {
+            m_layout = std::move(layout);
+            return update_bounds();
+        }
+    }
+    auto start = place_renderables(edit_index);
+    cut_renderables(start);
+    update_bounds();
+    if (use_cache) TextLayoutCache::instance().offer(key, m_string, m_layout);
+}
 
-    place_renderables(m_renderables);
-    cut_renderables  (m_renderables);
+void Text::defer_layout() {
+    m_has_pending_layout = true;
+    // glyph quads are kept, as laying out anew would keep them
+    unshare_layout();
+    auto & layout = *m_layout;
+    layout.glyph_origins    .clear();
+    layout.glyph_ids        .clear();
+    layout.extents          .clear();
+    layout.character_offsets.clear();
+    layout.line_starts      .clear();
+    layout.line_widths      .clear();
+    layout.chunk_ends       .clear();
+    layout.chunk_widths     .clear();
+    layout.chunk_advances   .clear();
+    layout.has_cuts = false;
+    update_bounds();
+}
+
+/* static */ void Text::lay_out_deferred
+    (const std::vector<Text *> & texts, unsigned thread_count)
+{
+    using Snapshot    = detail::GlyphMetricsSnapshot;
+    using SnapshotKey = std::tuple<const sf::Font *, int, GlyphAtlas *, bool>;
+    struct Job {
+        Text * text;
+        const Snapshot * metrics;
+        bool use_cache;
+        detail::TextLayoutKey key;
+    };
+    // Everything touching fonts, atlases or the layout cache is done here, in
+    // order, on this thread. Styled texts are simply laid out here.
+    std::map<SnapshotKey, std::unique_ptr<Snapshot>> snapshots;
+    std::vector<Job> jobs;
+    std::size_t char_count = 0;
+    for (auto * text : texts) {
+        text->m_is_layout_deferred = false;
+        if (!text->m_has_pending_layout) continue;
+        text->m_has_pending_layout = false;
+        if (!text->has_font_assigned() || text->m_char_size < 1) continue;
+        if (!text->m_styles.empty() || !text->m_style_runs.empty()) {
+            text->update_geometry();
+            continue;
+        }
+        Job job { text, nullptr, text->is_layout_cacheable(), detail::TextLayoutKey() };
+        if (job.use_cache) {
+            job.key = text->layout_cache_key();
+            if (auto layout = TextLayoutCache::instance().find(job.key, text->m_string)) {
+                text->m_layout = std::move(layout);
+                text->update_bounds();
+                continue;
+            }
+        }
+        auto & snapshot = snapshots[SnapshotKey(
+            text->font_ptr(), text->m_char_size, text->m_glyph_atlas,
+            text->m_monospace_hint)];
+        if (!snapshot) {
+            snapshot = std::make_unique<Snapshot>(
+                *text->font_ptr(), text->m_char_size, text->m_glyph_atlas,
+                text->m_monospace_hint);
+        }
+        snapshot->add_laid_out(text->m_string);
+        job.metrics = snapshot.get();
+        jobs.push_back(job);
+        char_count += text->m_string.size();
+    }
+
+    // texts are independent, workers take the next one until none are left
+    std::atomic<std::size_t> next_job(0);
+    std::exception_ptr error;
+    std::mutex error_mtx;
+    auto work = [&]() {
+        try {
+            for (auto i = next_job++; i < jobs.size(); i = next_job++) {
+                auto & text = *jobs[i].text;
+                text.cut_renderables(text.place_renderables(0, jobs[i].metrics));
+                text.update_bounds();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mtx);
+            if (!error) error = std::current_exception();
+            next_job = jobs.size();
+        }
+    };
+    if (thread_count == 0) thread_count = std::thread::hardware_concurrency();
+    if (char_count < k_parallel_layout_threshold) thread_count = 1;
+    thread_count = unsigned(std::min(std::size_t(thread_count), jobs.size()));
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count > 1 ? thread_count - 1 : 0);
+    for (unsigned i = 1; i < thread_count; ++i) workers.emplace_back(work);
+    work();
+    for (auto & worker : workers) worker.join();
+    if (error) std::rethrow_exception(error);
+
+    for (const auto & job : jobs) {
+        if (!job.use_cache) continue;
+        TextLayoutCache::instance().offer(job.key, job.text->m_string, job.text->m_layout);
+    }
+}
+
+void Text::update_after_new_string() {
+    erase_from_spans(m_color_spans, int(m_string.size()), k_max_string_length);
+    erase_from_spans(m_style_runs , int(m_string.size()), k_max_string_length);
+    update_geometry();
+}
 
+void Text::update_bounds() {
     m_bounds.width = m_bounds.height = 0.f;
+    if (!m_layout->extents.empty()) {
+        m_bounds.width  = std::max(0.f, m_layout->extents.back().x);
+        m_bounds.height = std::max(0.f, m_layout->extents.back().y);
+    }
+}
+
+std::size_t Text::place_renderables
+    (int edit_index, const detail::GlyphMetricsSnapshot * metrics)
+{
+    unshare_layout();
+    auto & layout = *m_layout;
+    const auto & font = *font_ptr();
+    const float line_spacing = metrics ? metrics->line_spacing() : line_height();
+    std::size_t start = 0;
+    bool start_wrapped = false;
+    int line = 0;
+    VectorF write_pos;
+    if (edit_index > 0 && has_layout()) {
+        auto resume = std::size_t(edit_index - 1);
+        // a run of newlines only breaks the line once, so it's placed whole
+        while (resume > 0 && is_newline(m_string[resume]) &&
+               is_newline(m_string[resume - 1]))
+        { --resume; }
+        line = line_of(int(resume));
+        if (m_width_constraint == k_inf) {
+            // without wrapping, nothing before the edit can change, layout
+            // resumes at a chunk's start so that chunks are measured whole
+            start       = chunk_begin_of(resume);
+            line        = line_of(int(start));
+            write_pos.x = layout.character_offsets[start];
+        } else {
+            // the first word of a line may now fit on the previous one
+            std::tie(line, start_wrapped) = find_resumable_line(line - 1, int(resume));
+            start = std::size_t(layout.line_starts[std::size_t(line)]);
+        }
+        // line spacing is a multiple of 1/64th, so this is what summing
+        // each line's spacing gives
+        write_pos.y = float(line)*line_spacing;
+    }
+
+    const auto length = m_string.size();
+    layout.line_starts.resize(std::size_t(line) + 1);
+    layout.line_widths.resize(std::size_t(line));
+    layout.glyph_origins    .resize(length);
+    layout.glyph_ids        .resize(length);
+    layout.extents          .resize(length);
+    layout.character_offsets.resize(length + 1);
+    // start is always a chunk boundary, chunks before it are unchanged
+    auto kept_chunks = std::size_t(
+        std::upper_bound(layout.chunk_ends.begin(), layout.chunk_ends.end(), int(start))
+        - layout.chunk_ends.begin());
+    layout.chunk_ends    .resize(kept_chunks);
+    layout.chunk_widths  .resize(kept_chunks);
+    layout.chunk_advances.resize(kept_chunks);
+
+    ::place_renderables(
+        LayoutSettings { font, m_char_size, m_styles, m_style_runs,
+                         line_spacing, baseline_offset(), m_width_constraint,
+                         m_monospace_hint, m_monospace_metrics, m_glyph_atlas,
+                         metrics },
+        m_string, start, m_string.size(), start_wrapped, write_pos,
+        LayoutOutput { layout.glyph_origins, layout.glyph_ids, layout.glyph_quads,
+                       layout.glyph_ids_by_char, layout.character_offsets,
+                       layout.line_starts, layout.line_widths, layout.chunk_ends,
+                       layout.chunk_widths, layout.chunk_advances });
+    return start;
+}
+
+bool Text::place_edit_within_line(int index, int removed, int inserted) {
+    // (as update_geometry_after)
+    if (m_is_layout_deferred || !has_font_assigned() || m_char_size < 1) return false;
+    // constraints may wrap or cut anything after the edit, and scaled
+    // advances would not move exactly
+    if (m_width_constraint != k_inf || m_height_constraint != k_inf ||
+        has_scaled_metrics(m_glyph_atlas))
+    { return false; }
+    auto & layout = *m_layout;
+    const int delta      = inserted - removed;
+    const int old_length = int(m_string.size()) - delta;
+    // (line and chunk tables are still the old string's)
+    if (layout.chunk_ends.empty() || layout.chunk_ends.back() != old_length ||
+        layout.line_widths.size() != layout.line_starts.size())
+    { return false; }
+
+    // Chunks are divided by the classes of neighboring characters, so every
+    // chunk after the one the edit ends in is unchanged, and only moves.
+    // Without wrapping, it moves along its line by as much as the pen did,
+    // and lines after it do not move at all.
+    const auto tail_chunk = std::size_t(std::upper_bound(
+        layout.chunk_ends.begin(), layout.chunk_ends.end(), index + removed)
+        - layout.chunk_ends.begin());
+    if (tail_chunk == layout.chunk_ends.size() ||
+        layout.chunk_ends[tail_chunk] == old_length)
+    { return false; }
+    // between newlines, an edit splits or joins a run of them, which breaks
+    // the line once however long it is
+    const auto after = std::size_t(index + inserted);
+    if (index > 0 && after < m_string.size() &&
+        is_newline(m_string[std::size_t(index - 1)]) && is_newline(m_string[after]))
+    { return false; }
+    const int old_tail = layout.chunk_ends[tail_chunk];
+    const auto tail    = std::size_t(old_tail + delta);
+    const auto old_line = std::size_t(line_of(old_tail));
+
+    // (as place_renderables resumes, without wrapping; at the start, the
+    // first offset may be one spliced in, or moved by the edit)
+    const auto start = index > 0 ? chunk_begin_of(std::size_t(index - 1)) : std::size_t(0);
+    const auto start_line = std::size_t(line_of(int(start)));
+    const auto kept_chunks = std::size_t(std::upper_bound(
+        layout.chunk_ends.begin(), layout.chunk_ends.end(), int(start))
+        - layout.chunk_ends.begin());
+    const float line_spacing = line_height();
+
+    auto & tables = edit_tables();
+    tables.line_starts.assign(1, layout.line_starts[start_line]);
+    tables.line_widths   .clear();
+    tables.chunk_ends    .clear();
+    tables.chunk_widths  .clear();
+    tables.chunk_advances.clear();
+    const auto pen = ::place_renderables(
+        LayoutSettings { *font_ptr(), m_char_size, m_styles, m_style_runs,
+                         line_spacing, baseline_offset(), m_width_constraint,
+                         m_monospace_hint, m_monospace_metrics, m_glyph_atlas,
+                         nullptr },
+        m_string, start, tail, false,
+        VectorF(start ? layout.character_offsets[start] : 0.f,
+                float(start_line)*line_spacing),
+        LayoutOutput { layout.glyph_origins, layout.glyph_ids, layout.glyph_quads,
+                       layout.glyph_ids_by_char, layout.character_offsets,
+                       tables.line_starts, tables.line_widths, tables.chunk_ends,
+                       tables.chunk_widths, tables.chunk_advances });
+
+    // the rest of the tail's line, up to and including the newlines which
+    // end it (whose offsets are where the line ends)
+    const float dx = pen.x - layout.character_offsets[tail];
+    const auto length = m_string.size();
+    if (dx != 0.f) {
+        auto i = tail;
+        for (; i != length && !is_newline(m_string[i]); ++i) {
+            layout.glyph_origins    [i].x += dx;
+            layout.character_offsets[i]   += dx;
+        }
+        for (; i != length && is_newline(m_string[i]); ++i)
+            { layout.character_offsets[i] += dx; }
+        if (i == length) layout.character_offsets[i] += dx;
+    }
+
+    // the tables' entries for what was placed are replaced
+    auto & line_starts = layout.line_starts;
+    auto & line_widths = layout.line_widths;
+    const float tail_line_width = line_widths[old_line] + dx;
+    line_starts.erase (line_starts.begin() + std::ptrdiff_t(start_line + 1),
+                       line_starts.begin() + std::ptrdiff_t(old_line + 1));
+    line_starts.insert(line_starts.begin() + std::ptrdiff_t(start_line + 1),
+                       tables.line_starts.begin() + 1, tables.line_starts.end());
+    line_widths.erase (line_widths.begin() + std::ptrdiff_t(start_line),
+                       line_widths.begin() + std::ptrdiff_t(old_line));
+    line_widths.insert(line_widths.begin() + std::ptrdiff_t(start_line),
+                       tables.line_widths.begin(), tables.line_widths.end());
+    const auto tail_line = start_line + tables.line_widths.size();
+    line_widths[tail_line] = tail_line_width;
+    for (auto line = tail_line + 1; line < line_starts.size(); ++line)
+        { line_starts[line] += delta; }
+
+    auto replace_chunks = [kept_chunks, tail_chunk](auto & old_table, const auto & table) {
+        old_table.erase (old_table.begin() + std::ptrdiff_t(kept_chunks),
+                         old_table.begin() + std::ptrdiff_t(tail_chunk + 1));
+        old_table.insert(old_table.begin() + std::ptrdiff_t(kept_chunks),
+                         table.begin(), table.end());
+    };
+    replace_chunks(layout.chunk_ends    , tables.chunk_ends    );
+    replace_chunks(layout.chunk_widths  , tables.chunk_widths  );
+    replace_chunks(layout.chunk_advances, tables.chunk_advances);
+    for (auto chunk = kept_chunks + tables.chunk_ends.size();
+         chunk != layout.chunk_ends.size(); ++chunk)
+    { layout.chunk_ends[chunk] += delta; }
+
+    // nothing can be cut, extents are only running maximums
+    VectorF extent = start ? layout.extents[start - 1] : VectorF(-k_inf, -k_inf);
+    for (auto i = start; i != length; ++i) {
+        extend_to_character(extent, layout.glyph_origins[i],
+                            layout.glyph_quads[layout.glyph_ids[i]]);
+        layout.extents[i] = extent;
+    }
+    update_bounds();
+    return true;
+}
+
+void Text::cut_renderables(std::size_t start) {
+    unshare_layout();
+    auto & layout = *m_layout;
+    // (colors have no bearing on cuts)
+    auto expand = [this, &layout](std::size_t i) {
+        return DrawableCharacter(layout.glyph_origins[i],
+                                 layout.glyph_quads[layout.glyph_ids[i]], m_color);
+    };
+    bool has_cuts = ::cut_renderables(m_width_constraint, m_height_constraint,
+                                      start, expand, layout.extents);
+    layout.has_cuts = has_cuts || (start > 0 && layout.has_cuts);
+}
+
+void Text::append_verticies
+    (VertexContainer & verticies, VectorF offset, int page) const
+{
+    const auto & layout = *m_layout;
+    // characters are gathered into runs, which are clipped together
+    detail::QuadClip clip;
+    clip.bottom = m_height_constraint;
+    clip.right  = m_width_constraint;
+    clip.offset = offset;
+    detail::GlyphRun run;
+    auto flush_run = [&verticies, &clip, &run]() {
+        const auto old_size = verticies.size();
+        verticies.resize(old_size + run.size*4);
+        auto count = detail::make_clipped_quads(run, clip, verticies.data() + old_size);
+        verticies.resize(old_size + count*4);
+        run.size = 0;
+    };
+    auto add_characters = [&](std::size_t beg, std::size_t end) {
+        // spans are walked along with the characters
+        auto span = std::upper_bound(m_color_spans.begin(), m_color_spans.end(), int(beg),
+            [](int idx, const ColorSpan & rhs) { return idx < rhs.end; });
+        for (auto i = beg; i != end; ++i) {
+            // characters without a quad need not be clipped
+            if (layout.glyph_ids[i] == 0) continue;
+            while (span != m_color_spans.end() && span->end <= int(i)) ++span;
+            const bool in_span = span != m_color_spans.end() && span->begin <= int(i);
+            const auto & quad = layout.glyph_quads[layout.glyph_ids[i]];
+            if (page >= 0 && quad.page != page) continue;
+            const auto & origin = layout.glyph_origins[i];
+            const auto & texture_rect = quad.texture_rect;
+            run.push(origin.x, origin.y, quad.bounds.width, quad.bounds.height,
+                     texture_rect.left, texture_rect.top, texture_rect.width,
+                     texture_rect.height, in_span ? span->color : m_color);
+            if (run.is_full()) flush_run();
+        }
+    };
 
-    float right_most  = -k_inf;
-    float bottom_most = -k_inf;
-    for (const auto & dc : m_renderables) {
-        right_most  = std::max(right_most , dc.location().x + dc.width ());
-        bottom_most = std::max(bottom_most, dc.location().y + dc.height());
-        assert(is_real(right_most) && is_real(bottom_most));
-        assert(&dc >= &m_renderables.front() && &dc <= &m_renderables.back());
+    if (m_viewport_width == k_inf || !has_layout()) {
+        add_characters(0, layout.glyph_ids.size());
+        return flush_run();
+    }
+    clip.view_left  = m_viewport_offset;
+    clip.view_right = m_viewport_offset + m_viewport_width;
+    const auto offsets = layout.character_offsets.begin();
+    for (int line = 0; line != line_count(); ++line) {
+        auto beg = offsets + layout.line_starts[std::size_t(line)];
+        auto end = offsets + line_end(line);
+        // the character the left edge is on starts before it
+        auto first = std::upper_bound(beg, end, clip.view_left);
+        if (first != beg) --first;
+        auto last = std::lower_bound(first, end, clip.view_right);
+        add_characters(std::size_t(first - offsets), std::size_t(last - offsets));
     }
-    m_bounds.width  = std::max(0.f, right_most );
-    m_bounds.height = std::max(0.f, bottom_most);
+    flush_run();
+}
+
+void Text::reset_glyph_quads() {
+    m_monospace_metrics = detail::MonospaceMetricsCache();
+    // nothing of a shared layout would be kept
+    if (m_layout.use_count() > 1) {
+        m_layout = std::make_shared<detail::TextLayout>();
+        return;
+    }
+    m_layout->glyph_quads.clear();
+    m_layout->glyph_quads.emplace_back();
+    m_layout->glyph_ids_by_char.clear();
+    // any layout refers to the old quads
+    m_layout->glyph_ids.clear();
+    m_layout->glyph_origins.clear();
+}
+
+void Text::unshare_layout() {
+    if (m_layout.use_count() > 1)
+        { m_layout = std::make_shared<detail::TextLayout>(*m_layout); }
 }
 
-void Text::place_renderables(std::vector<detail::DrawableCharacter> & renderables) const {
-    ::place_renderables(*font_ptr(), m_string, m_width_constraint,
-                        m_char_size, m_color, renderables);
+bool Text::is_layout_cacheable() const noexcept {
+    return m_styles.empty() && !m_string.empty() &&
+           m_string.size() <= TextLayoutCache::k_max_string_length;
 }
 
-void Text::cut_renderables(std::vector<detail::DrawableCharacter> & renderables) const {
-    ::cut_renderables(m_width_constraint, m_height_constraint, renderables);
+detail::TextLayoutKey Text::layout_cache_key() const {
+    detail::TextLayoutKey key;
+    key.font              = font_ptr();
+    key.font_family       = key.font ? key.font->getInfo().family : std::string();
+    key.atlas             = m_glyph_atlas;
+    key.char_size         = m_char_size;
+    key.width_constraint  = m_width_constraint;
+    key.height_constraint = m_height_constraint;
+    key.monospace_hint    = m_monospace_hint;
+    key.string_hash       = std::hash<UString>()(m_string);
+    return key;
 }
 
+int Text::baseline_offset() const {
+    int offset = m_char_size;
+    for (int style = 1; style != int(m_styles.size()) + 1; ++style)
+        { offset = std::max(offset, size_of_style(m_char_size, m_styles, style)); }
+    return offset;
+}
+
+bool Text::rewrap_renderables() {
+    // scaled (distance field) advances are not multiples of 1/64th, so
+    // moving chunks would not give exactly what placing anew does
+    if (!has_font_assigned() || m_char_size < 1 || !has_layout() ||
+        m_layout->has_cuts || !has_chunk_table() ||
+        has_scaled_metrics(m_glyph_atlas))
+    { return false; }
+    unshare_layout();
+    auto & layout = *m_layout;
+
+    // Replays the line breaking of place_renderables over cached chunk
+    // widths. Each chunk is moved whole, the pen positions within are
+    // unchanged (as advances and kerning are multiples of 1/64th, moving
+    // is exactly what placing anew would give).
+    const float spacing = line_height();
+    // new tables are built in the previous tables' memory
+    auto & line_starts = m_spare_line_starts;
+    auto & line_widths = m_spare_line_widths;
+    line_starts.clear();
+    line_widths.clear();
+    line_starts.push_back(0);
+
+    float pen_x = 0.f;
+    int line = 0;
+    std::size_t old_line = 0;
+    int chunk_begin = 0;
+    auto start_line = [&](int index) {
+        line_widths.push_back(pen_x);
+        line_starts.push_back(index);
+        pen_x = 0.f;
+        ++line;
+    };
+    for (std::size_t chunk = 0; chunk != layout.chunk_ends.size(); ++chunk) {
+        const int chunk_end = layout.chunk_ends[chunk];
+        while (old_line + 1 < layout.line_starts.size() &&
+               layout.line_starts[old_line + 1] <= chunk_begin)
+        { ++old_line; }
+        const bool is_newline_chunk = is_newline(m_string[std::size_t(chunk_begin)]);
+        if (!is_newline_chunk && pen_x + layout.chunk_widths[chunk] > m_width_constraint)
+            { start_line(chunk_begin); }
+
+        const float dx = pen_x - layout.character_offsets[std::size_t(chunk_begin)];
+        const float dy = float(line)*spacing - float(old_line)*spacing;
+        if (dx != 0.f || dy != 0.f) {
+            for (auto i = std::size_t(chunk_begin); i != std::size_t(chunk_end); ++i) {
+                layout.character_offsets[i] += dx;
+                // newlines have no quad to move
+                if (!is_newline_chunk) layout.glyph_origins[i] += VectorF(dx, dy);
+            }
+        }
+        if (is_newline_chunk) {
+            start_line(chunk_end);
+        } else {
+            pen_x += layout.chunk_advances[chunk];
+        }
+        chunk_begin = chunk_end;
+    }
+    layout.character_offsets.back() = pen_x;
+    line_widths.push_back(pen_x);
+    layout.line_starts.swap(line_starts);
+    layout.line_widths.swap(line_widths);
+
+    cut_renderables(0);
+    update_bounds();
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+namespace detail {
+
+GlyphMetricsSnapshot::GlyphMetricsSnapshot
+    (const sf::Font & font, int char_size, GlyphAtlas * atlas, bool monospace_hint):
+    m_font(font),
+    m_char_size(unsigned(char_size)),
+    m_atlas(atlas),
+    m_monospace_hint(monospace_hint),
+    m_line_spacing(std::max(0.f, font.getLineSpacing(unsigned(char_size))))
+{}
+
+void GlyphMetricsSnapshot::add_measured
+    (UString::const_iterator beg, UString::const_iterator end)
+{
+    if (has_scaled_metrics(m_atlas)) {
+        for (auto itr = beg; itr != end; ++itr) {
+            look_up_quad_glyph(*itr);
+            if (itr + 1 != end) look_up_kerning(*itr, *(itr + 1));
+        }
+        return;
+    }
+    // (mirrors measure_line_width)
+    if (std::all_of(beg, end, is_monospace_char)) {
+        if (!m_has_mono) {
+            m_mono = find_monospace_metrics(m_font, int(m_char_size), false);
+            m_has_mono = true;
+        }
+        if (is_monospace_range(beg, end)) return;
+    }
+    for (auto itr = beg; itr != end; ++itr) {
+        look_up_font_glyph(*itr);
+        if (itr + 1 != end) look_up_kerning(*itr, *(itr + 1));
+    }
+}
+
+void GlyphMetricsSnapshot::add_laid_out(const UString & str) {
+    // (mirrors place_renderables)
+    MonospaceMetrics mono;
+    if (!has_scaled_metrics(m_atlas) &&
+        std::all_of(str.begin(), str.end(), is_layout_monospace_char))
+    {
+        if (!m_has_layout_mono) {
+            m_layout_mono = find_monospace_metrics(m_font, int(m_char_size),
+                                                   m_monospace_hint);
+            m_has_layout_mono = true;
+        }
+        mono = m_layout_mono;
+    }
+    for (auto itr = str.begin(); itr != str.end(); ) {
+        const auto chunk_end = next_chunk_end(itr, str.end());
+        if (is_newline(*itr)) {
+            itr = chunk_end;
+            continue;
+        }
+        const float w = float(chunk_end - itr)*mono.advance;
+        if (!mono.is_monospace || w >= k_monospace_exact_limit)
+            { add_measured(itr, chunk_end); }
+        for (auto jtr = itr; jtr != chunk_end; ++jtr) {
+            look_up_quad_glyph(*jtr);
+            if (!mono.is_monospace && jtr + 1 != str.end())
+                { look_up_kerning(*jtr, *(jtr + 1)); }
+        }
+        itr = chunk_end;
+    }
+}
+
+float GlyphMetricsSnapshot::width_of
+    (UString::const_iterator beg, UString::const_iterator end) const
+{
+    if (m_has_mono && is_monospace_range(beg, end))
+        { return float(end - beg)*m_mono.advance; }
+    const auto & glyphs = has_scaled_metrics(m_atlas) ? m_atlas_glyphs : m_font_glyphs;
+    float w = 0.f;
+    for (auto itr = beg; itr != end; ++itr) {
+        w += glyphs[*itr].glyph.advance;
+        if (itr + 1 != end) w += kerning(*itr, *(itr + 1));
+    }
+    return w;
+}
+
+const GlyphMetricsSnapshot::Entry & GlyphMetricsSnapshot::quad_glyph(UChar c) const
+    { return m_atlas ? m_atlas_glyphs[c] : m_font_glyphs[c]; }
+
+float GlyphMetricsSnapshot::kerning(UChar a, UChar b) const {
+    if (is_monospace_char(a) && is_monospace_char(b)) {
+        return m_ascii_kernings[std::size_t(a - k_monospace_first)*k_monospace_count +
+                                std::size_t(b - k_monospace_first)];
+    }
+    return m_kernings.find((std::uint64_t(a) << 32) | std::uint64_t(b))->second;
+}
+
+MonospaceMetrics GlyphMetricsSnapshot::layout_monospace(const UString & str) const {
+    if (m_has_layout_mono &&
+        std::all_of(str.begin(), str.end(), is_layout_monospace_char))
+    { return m_layout_mono; }
+    return MonospaceMetrics();
+}
+
+/* private */ GlyphMetricsSnapshot::Entry &
+    GlyphMetricsSnapshot::GlyphTable::operator [] (UChar c)
+{
+    if (is_monospace_char(c)) return m_ascii[std::size_t(c - k_monospace_first)];
+    return m_others[c];
+}
+
+/* private */ const GlyphMetricsSnapshot::Entry &
+    GlyphMetricsSnapshot::GlyphTable::operator [] (UChar c) const
+{
+    if (is_monospace_char(c)) return m_ascii[std::size_t(c - k_monospace_first)];
+    return m_others.find(c)->second;
+}
+
+/* private */ bool GlyphMetricsSnapshot::is_monospace_range
+    (UString::const_iterator beg, UString::const_iterator end) const
+{
+    if (!m_mono.is_monospace) return false;
+    if (float(end - beg)*m_mono.advance >= k_monospace_exact_limit) return false;
+    return std::all_of(beg, end, is_monospace_char);
+}
+
+/* private */ const GlyphMetricsSnapshot::Entry &
+    GlyphMetricsSnapshot::look_up_font_glyph(UChar c)
+{
+    auto & entry = m_font_glyphs[c];
+    if (!entry.is_known) {
+        entry.glyph    = m_font.getGlyph(c, m_char_size, false);
+        entry.is_known = true;
+    }
+    return entry;
+}
+
+/* private */ const GlyphMetricsSnapshot::Entry &
+    GlyphMetricsSnapshot::look_up_quad_glyph(UChar c)
+{
+    if (!m_atlas) return look_up_font_glyph(c);
+    auto & entry = m_atlas_glyphs[c];
+    if (!entry.is_known) {
+        const auto & atlas_entry = m_atlas->glyph(m_font, m_char_size, c);
+        entry.glyph    = atlas_entry.glyph;
+        entry.page     = atlas_entry.page;
+        entry.is_known = true;
+    }
+    return entry;
+}
+
+/* private */ void GlyphMetricsSnapshot::look_up_kerning(UChar a, UChar b) {
+    auto & kerning = kerning_slot(a, b);
+    if (std::isnan(kerning)) kerning = m_font.getKerning(a, b, m_char_size);
+}
+
+/* private */ float & GlyphMetricsSnapshot::kerning_slot(UChar a, UChar b) {
+    if (is_monospace_char(a) && is_monospace_char(b)) {
+        if (m_ascii_kernings.empty())
+            { m_ascii_kernings.resize(k_monospace_count*k_monospace_count, unknown()); }
+        return m_ascii_kernings[std::size_t(a - k_monospace_first)*k_monospace_count +
+                                std::size_t(b - k_monospace_first)];
+    }
+    return m_kernings.emplace((std::uint64_t(a) << 32) | std::uint64_t(b), unknown())
+           .first->second;
+}
+
+} // end of detail namespace
+
 } // end of ksg namespace
 
 namespace {
 
-std::vector<UString::const_iterator> find_chunks_dividers(const UString & ustr) {
+UString::const_iterator next_chunk_end
+    (UString::const_iterator beg, UString::const_iterator end)
+{
     static const auto class_of_char = [](UChar c) {
         if (is_whitespace(c) && !is_newline(c)) return 0;
         if (is_newline   (c)) return 1;
         return 2;
     };
-    std::vector<UString::const_iterator> rv;
-    assert(!ustr.empty());
-    int char_class = class_of_char(ustr[0]);
+    assert(beg != end);
+    const int char_class = class_of_char(*beg);
+    return std::find_if(beg + 1, end,
+        [char_class](UChar c) { return class_of_char(c) != char_class; });
+}
 
-    for (auto itr = ustr.begin(); itr != ustr.end(); ++itr) {
-        if (char_class == class_of_char(*itr)) continue;
+std::vector<UString::const_iterator> find_chunks_dividers(const UString & ustr) {
+    assert(!ustr.empty());
+    std::vector<UString::const_iterator> rv;
+    for (auto itr = ustr.begin(); itr != ustr.end(); ) {
+        itr = next_chunk_end(itr, ustr.end());
         rv.push_back(itr);
-        char_class = class_of_char(*itr);
     }
-    rv.push_back(ustr.end());
     return rv;
 }
 
-void place_renderables(const sf::Font & font, const UString & ustr,
-       float width_constraint, int char_size, sf::Color color,
-       std::vector<DrawableCharacter> & renderables)
+const sf::Font & font_of_style
+    (const sf::Font & own_font, const std::vector<TextStyle> & styles, int style)
 {
-    renderables.clear();
+    if (style == 0) return own_font;
+    const auto * font = styles[std::size_t(style - 1)].font;
+    return font ? *font : own_font;
+}
 
-    if (ustr.empty()) {
-        // nothing to render
-        return;
+int size_of_style(int own_size, const std::vector<TextStyle> & styles, int style) {
+    if (style == 0) return own_size;
+    int char_size = styles[std::size_t(style - 1)].char_size;
+    return char_size > 0 ? char_size : own_size;
+}
+
+int StyleCursor::style_at(std::size_t index) {
+    const int idx = int(index);
+    if (m_itr != m_runs.begin() && (m_itr - 1)->end > idx) {
+        m_itr = std::upper_bound(m_runs.begin(), m_itr, idx,
+            [](int idx, const StyleRun & run) { return idx < run.end; });
     }
+    while (m_itr != m_runs.end() && m_itr->end <= idx) ++m_itr;
+    return (m_itr != m_runs.end() && m_itr->begin <= idx) ? m_itr->style : 0;
+}
 
-    renderables.reserve(ustr.size());
-    VectorF write_pos;
-    auto itr = ustr.begin();
-    for (auto chunk_end : find_chunks_dividers(ustr)) {
-        assert(itr <= chunk_end);
+template <typename SpanType>
+void insert_into_spans(std::vector<SpanType> & spans, int index, int count) {
+    for (auto & span : spans) {
+        if (span.begin >= index) span.begin += count;
+        if (span.end   >  index) span.end   += count;
+    }
+}
+
+template <typename SpanType>
+void erase_from_spans(std::vector<SpanType> & spans, int index, int count) {
+    // (count maybe large enough to overflow on adding)
+    auto erase_from = [index, count](int & idx) {
+        if (idx > index) idx = (idx - index > count) ? idx - count : index;
+    };
+    for (auto & span : spans) {
+        erase_from(span.begin);
+        erase_from(span.end);
+    }
+    merge_spans(spans);
+}
+
+template <typename SpanType>
+void merge_spans(std::vector<SpanType> & spans) {
+    auto out = spans.begin();
+    for (const auto & span : spans) {
+        if (span.begin == span.end) continue;
+        if (out != spans.begin() && (out - 1)->end == span.begin &&
+            has_same_value(*(out - 1), span))
+        {
+            (out - 1)->end = span.end;
+            continue;
+        }
+        *out++ = span;
+    }
+    spans.erase(out, spans.end());
+}
+
+MonospaceMetrics find_monospace_metrics
+    (const sf::Font & font, int char_size, bool hinted)
+{
+    using Key = std::tuple<const sf::Font *, int, bool>;
+    // family name guards against a new font reusing an old font's address
+    struct CacheEntry {
+        std::string family;
+        MonospaceMetrics metrics;
+    };
+    static std::mutex mtx;
+    static std::map<Key, CacheEntry> cache;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    const auto & family = font.getInfo().family;
+    auto & entry = cache[Key(&font, char_size, hinted)];
+    if (entry.family == family) return entry.metrics;
+
+    entry.family  = family;
+    entry.metrics = MonospaceMetrics();
+    const auto size = unsigned(char_size);
+    const float advance = font.getGlyph(k_monospace_first, size, false).advance;
+    if (advance*64.f != std::floor(advance*64.f)) return entry.metrics;
+    for (UChar c = k_monospace_first; c <= k_monospace_last; ++c) {
+        if (font.getGlyph(c, size, false).advance != advance)
+            return entry.metrics;
+    }
+    if (!hinted) {
+        for (UChar a = k_monospace_first; a <= k_monospace_last; ++a) {
+        for (UChar b = k_monospace_first; b <= k_monospace_last; ++b) {
+            if (font.getKerning(a, b, size) != 0.f) return entry.metrics;
+        }}
+    }
+    entry.metrics.advance      = advance;
+    entry.metrics.is_monospace = true;
+    return entry.metrics;
+}
+
+const MonospaceMetrics & find_monospace_metrics
+    (MonospaceMetricsCache & cache, const sf::Font & font, int char_size, bool hinted)
+{
+    auto & metrics = cache.metrics[hinted];
+    if (!cache.is_known[hinted]) {
+        metrics = find_monospace_metrics(font, char_size, hinted);
+        cache.is_known[hinted] = true;
+    }
+    return metrics;
+}
+
+float measure_line_width
+    (const sf::Font & font, int char_size, bool monospace_hint,
+     UString::const_iterator beg, UString::const_iterator end)
+{
+    MonospaceMetricsCache cache;
+    return measure_line_width(cache, font, char_size, monospace_hint, beg, end);
+}
+
+float measure_line_width
+    (MonospaceMetricsCache & cache, const sf::Font & font, int char_size,
+     bool monospace_hint, UString::const_iterator beg, UString::const_iterator end)
+{
+    assert(beg <= end);
+    if (std::all_of(beg, end, is_monospace_char)) {
+        const auto & mono = find_monospace_metrics(cache, font, char_size, monospace_hint);
+        float w = float(end - beg)*mono.advance;
+        if (mono.is_monospace && w < k_monospace_exact_limit) return w;
+    }
+    float w = 0.f;
+    for (auto itr = beg; itr != end; ++itr) {
+        const auto & glyph = font.getGlyph(*itr, unsigned(char_size), false);
+        w += glyph.advance;
+        if (itr + 1 != end) {
+            w += font.getKerning(*itr, *(itr + 1), unsigned(char_size));
+        }
+    }
+    return w;
+}
+
+template <typename StringAt>
+std::vector<float> measure_widths_of
+    (const sf::Font & font, int char_size, std::size_t count, StringAt && string_at,
+     bool in_parallel)
+{
+    std::vector<float> rv(count, 0.f);
+    if (char_size < 1) return rv;
+
+    ksg::detail::GlyphMetricsSnapshot metrics(font, char_size, nullptr, false);
+    std::size_t char_count = 0;
+    for (std::size_t i = 0; i != count; ++i) {
+        const UString & str = string_at(i);
+        metrics.add_measured(str.begin(), str.end());
+        char_count += str.size();
+    }
+    auto measure_range = [&](std::size_t beg, std::size_t end) {
+        for (std::size_t i = beg; i != end; ++i) {
+            const UString & str = string_at(i);
+            rv[i] = metrics.width_of(str.begin(), str.end());
+        }
+    };
+    std::size_t thread_count = 1;
+    if (in_parallel && char_count >= k_parallel_measure_threshold) {
+        thread_count = std::min(count, std::size_t(std::thread::hardware_concurrency()));
+    }
+    if (thread_count < 2) {
+        measure_range(0, count);
+        return rv;
+    }
+    // the calling thread takes the last range
+    const std::size_t per_thread = (count + thread_count - 1) / thread_count;
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    std::size_t beg = 0;
+    for (; beg + per_thread < count; beg += per_thread)
+        { threads.emplace_back(measure_range, beg, beg + per_thread); }
+    measure_range(beg, count);
+    for (auto & thread : threads) thread.join();
+    return rv;
+}
+
+VectorF place_renderables(const LayoutSettings & settings, const UString & ustr,
+                          std::size_t start, std::size_t stop, bool start_wrapped,
+                          VectorF write_pos, LayoutOutput out)
+{
+    const auto & font     = settings.font;
+    const auto char_size  = settings.char_size;
+    const auto & styles   = settings.styles;
+    auto * atlas          = settings.atlas;
+    const auto * metrics  = settings.metrics;
+    const bool is_styled  = !settings.style_runs.empty();
+    // (snapshots are only taken for whole, unstyled layouts)
+    assert(!metrics || (!is_styled && start == 0));
+    StyleCursor style_cursor(settings.style_runs);
+    assert(out.glyph_origins.size() == ustr.size() &&
+           out.glyph_ids    .size() == ustr.size());
+    assert(out.character_offsets.size() == ustr.size() + 1);
+    assert(!out.glyph_quads.empty());
+    assert(out.line_starts.size() == out.line_widths.size() + 1);
+    assert(out.chunk_ends.size() == out.chunk_widths.size() &&
+           out.chunk_ends.size() == out.chunk_advances.size());
+
+    auto index_of = [&ustr](UString::const_iterator itr)
+        { return std::size_t(itr - ustr.begin()); };
+    auto style_of = [&](UString::const_iterator itr)
+        { return is_styled ? style_cursor.style_at(index_of(itr)) : 0; };
+    // metrics are identical either way, only texture rectangles differ
+    // (without an atlas, a glyph's texture is its style's)
+    auto lookup_glyph = [&](UChar c, int style, int & page) -> const sf::Glyph & {
+        if (metrics) {
+            const auto & entry = metrics->quad_glyph(c);
+            page = entry.page;
+            return entry.glyph;
+        }
+        const auto & style_font = font_of_style(font, styles, style);
+        const auto style_size   = unsigned(size_of_style(char_size, styles, style));
+        if (!atlas) {
+            page = style;
+            return style_font.getGlyph(c, style_size, false);
+        }
+        const auto & entry = atlas->glyph(style_font, style_size, c);
+        page = entry.page;
+        return entry.glyph;
+    };
+    // kerning only applies between characters of the same style
+    auto get_kerning = [&](UString::const_iterator itr) {
+        if (metrics) return metrics->kerning(*itr, *(itr + 1));
+        if (!is_styled) return font.getKerning(*itr, *(itr + 1), unsigned(char_size));
+        int style = style_of(itr);
+        if (style != style_of(itr + 1)) return 0.f;
+        return font_of_style(font, styles, style).getKerning(
+            *itr, *(itr + 1), unsigned(size_of_style(char_size, styles, style)));
+    };
+
+    const auto beg = ustr.begin() + std::ptrdiff_t(start);
+    const auto finish = ustr.begin() + std::ptrdiff_t(stop);
+    const bool measures_quads = is_styled || has_scaled_metrics(atlas);
+    MonospaceMetrics mono;
+    if (!is_styled && !has_scaled_metrics(atlas) &&
+        std::all_of(beg, finish,
+                    [](UChar c) { return is_newline(c) || is_monospace_char(c); }))
+    {
+        mono = metrics ? metrics->layout_monospace(ustr) :
+               find_monospace_metrics(settings.monospace_metrics, font, char_size,
+                                      settings.monospace_hint);
+    }
+
+    // small cache for printable ASCII, sparing most table lookups, it's
+    // for one style at a time
+    static constexpr const auto k_uncached = std::numeric_limits<std::uint32_t>::max();
+    std::array<std::uint32_t, k_monospace_count> id_cache;
+    id_cache.fill(k_uncached);
+    int cached_style = 0;
+    auto get_glyph_id = [&](UChar c, int style) {
+        if (style != cached_style) {
+            id_cache.fill(k_uncached);
+            cached_style = style;
+        }
+        std::uint32_t temp = k_uncached;
+        auto & cached = is_monospace_char(c) ?
+            id_cache[std::size_t(c - k_monospace_first)] : temp;
+        if (cached != k_uncached) return cached;
+        const auto key = (std::uint64_t(style) << 32) | std::uint64_t(c);
+        auto itr = out.glyph_ids_by_char.find(key);
+        if (itr != out.glyph_ids_by_char.end()) return (cached = itr->second);
+
+        int page = 0;
+        const auto & glyph = lookup_glyph(c, style, page);
+        cached = std::uint32_t(out.glyph_quads.size());
+        out.glyph_quads.emplace_back(glyph, page);
+        out.glyph_ids_by_char.emplace(key, cached);
+        return cached;
+    };
+    auto get_width = [&](UString::const_iterator beg, UString::const_iterator end) {
+        float w = float(end - beg)*mono.advance;
+        if (mono.is_monospace && w < k_monospace_exact_limit) return w;
+        if (metrics) return metrics->width_of(beg, end);
+        if (!measures_quads) {
+            return measure_line_width(settings.monospace_metrics, font, char_size,
+                                      false, beg, end);
+        }
+        // (as measure_line_width, but with each character's style and quad)
+        w = 0.f;
+        for (auto itr = beg; itr != end; ++itr) {
+            w += out.glyph_quads[get_glyph_id(*itr, style_of(itr))].advance;
+            if (itr + 1 != end) w += get_kerning(itr);
+        }
+        return w;
+    };
+
+    auto start_line = [&](UString::const_iterator itr) {
+        out.line_widths.push_back(write_pos.x);
+        out.line_starts.push_back(int(index_of(itr)));
+    };
+    auto offset_of = [&](UString::const_iterator itr) -> float &
+        { return out.character_offsets[index_of(itr)]; };
+    auto add_chunk = [&](UString::const_iterator end, float width, float advance) {
+        out.chunk_ends    .push_back(int(index_of(end)));
+        out.chunk_widths  .push_back(width);
+        out.chunk_advances.push_back(advance);
+    };
+
+    // chunks are scanned in place, so that layout need not allocate
+    for (auto itr = beg; itr != finish; ) {
+        const auto chunk_end = next_chunk_end(itr, ustr.end());
         if (is_newline(*itr)) {
+            for (auto jtr = itr; jtr != chunk_end; ++jtr) {
+                offset_of(jtr) = write_pos.x;
+                out.glyph_origins[index_of(jtr)] = VectorF();
+                out.glyph_ids    [index_of(jtr)] = 0;
+            }
+            add_chunk(chunk_end, 0.f, 0.f);
+            start_line(chunk_end);
             write_pos.x = 0.f;
-            write_pos.y += font.getLineSpacing(char_size);
+            write_pos.y += settings.line_spacing;
 
             itr = chunk_end;
             continue;
         }
 
-        auto chunk_width = ksg::Text::measure_width(font, char_size, itr, chunk_end);
-        if (write_pos.x + chunk_width > width_constraint) {
+        auto chunk_width = get_width(itr, chunk_end);
+        if (start_wrapped) {
+            start_wrapped = false;
+        } else if (write_pos.x + chunk_width > settings.width_constraint) {
+            start_line(itr);
             write_pos.x = 0.f;
-            write_pos.y += font.getLineSpacing(char_size);
+            write_pos.y += settings.line_spacing;
         }
+        const float chunk_start_x = write_pos.x;
         for (auto jtr = itr; jtr != chunk_end; ++jtr) {
-            const auto & glyph = font.getGlyph(*jtr, char_size, false);
-            VectorF p(write_pos.x + glyph.bounds.left, write_pos.y + glyph.bounds.top + char_size);
-            renderables.emplace_back(p, glyph, color);
-            write_pos.x += glyph.advance;
-            if (jtr + 1 != ustr.end()) {
-                write_pos.x += font.getKerning(*jtr, *(jtr + 1), char_size);
+            offset_of(jtr) = write_pos.x;
+            const auto id = get_glyph_id(*jtr, style_of(jtr));
+            const auto & quad = out.glyph_quads[id];
+            const auto i = index_of(jtr);
+            out.glyph_origins[i] = VectorF(write_pos.x + quad.bounds.left,
+                                           write_pos.y + quad.bounds.top + settings.baseline_offset);
+            out.glyph_ids    [i] = id;
+            write_pos.x += quad.advance;
+            if (!mono.is_monospace && jtr + 1 != ustr.end()) {
+                write_pos.x += get_kerning(jtr);
             }
         }
+        add_chunk(chunk_end, chunk_width, write_pos.x - chunk_start_x);
         itr = chunk_end;
     }
+    if (finish == ustr.end()) {
+        out.character_offsets.back() = write_pos.x;
+        out.line_widths.push_back(write_pos.x);
+    }
+    return write_pos;
 }
 
-void cut_renderables(float width_constraint, float height_constraint,
-                     std::vector<DrawableCharacter> & renderables)
+template <typename ExpandFunc>
+bool cut_renderables(float width_constraint, float height_constraint,
+                     std::size_t start, ExpandFunc && expand,
+                     std::vector<VectorF> & extents)
 {
-    for (auto & renderable : renderables) {
+    static constexpr const float k_inf = ksg::Text::k_inf;
+    VectorF extent = start ? extents[start - 1] : VectorF(-k_inf, -k_inf);
+    bool has_cuts = false;
+    for (std::size_t i = start; i != extents.size(); ++i) {
+        DrawableCharacter renderable = expand(i);
+        // (mirrors when a cut changes a character)
+        has_cuts = has_cuts ||
+            renderable.location().x + renderable.width () >= width_constraint ||
+            renderable.location().y + renderable.height() >= height_constraint;
         renderable.cut_on_bottom(height_constraint);
         renderable.cut_on_right (width_constraint );
+        if (!renderable.whiped_out()) {
+            extent.x = std::max(extent.x, renderable.location().x + renderable.width ());
+            extent.y = std::max(extent.y, renderable.location().y + renderable.height());
+            assert(is_real(extent.x) && is_real(extent.y));
+        }
+        extents[i] = extent;
     }
-    renderables.erase(
-        std::remove_if(renderables.begin(), renderables.end(),
-                       [](const DrawableCharacter & dc) { return dc.whiped_out(); }),
-        renderables.end());
+    return has_cuts;
+}
+
+VertexContainer & draw_buffer() {
+    static thread_local VertexContainer verticies;
+    return verticies;
+}
+
+EditTables & edit_tables() {
+    static thread_local EditTables tables;
+    return tables;
+}
+
+void extend_to_character(VectorF & extent, VectorF origin, const GlyphQuad & quad) {
+    // (mirrors DrawableCharacter, its construction and whiped_out)
+    const float width  = (origin.x + quad.bounds.width ) - origin.x;
+    const float height = (origin.y + quad.bounds.height) - origin.y;
+    if (std::abs(width) < 1.f || std::abs(height) < 1.f) return;
+    extent.x = std::max(extent.x, origin.x + width );
+    extent.y = std::max(extent.y, origin.y + height);
 }
 
 } // end of <anonymous> namespace
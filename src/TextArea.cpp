@@ -21,8 +21,10 @@
 
 #include <ksg/TextArea.hpp>
 #include <ksg/TextButton.hpp>
+#include <ksg/GlyphPrewarmer.hpp>
 
 #include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/View.hpp>
 
 #include <array>
 
@@ -65,12 +67,14 @@ namespace ksg {
 /* static */ constexpr const char * const TextArea::k_text_color;
 /* static */ constexpr const char * const TextArea::k_text_size ;
 /* static */ constexpr const float TextArea::k_unassigned_size;
+/* static */ constexpr const int TextArea::k_virtual_line_margin;
 
 TextArea::TextArea() {}
 
 void TextArea::process_event(const sf::Event &) {}
 
 void TextArea::set_location(float x, float y) {
+    flag_visual_change();
     m_bounds.left = x;
     m_bounds.top  = y;
     recompute_geometry();
@@ -80,23 +84,33 @@ VectorF TextArea::location() const
     { return m_draw_text.location(); }
 
 float TextArea::width() const {
-    if (is_unassigned(m_bounds.width))
-        return m_draw_text.width();
-    return m_bounds.width;
+    if (!is_unassigned(m_bounds.width)) return m_bounds.width;
+    if (!m_virtual_lines) return m_draw_text.width();
+    if (!is_unassigned(m_max_width)) return m_max_width;
+    float rv = 0.f;
+    for (const auto & text : m_window) rv = std::max(rv, text.width());
+    return rv;
 }
 
 float TextArea::height() const {
+    if (m_virtual_lines) return view_height();
     if (is_unassigned(m_bounds.height))
         return m_draw_text.height();
     return m_bounds.height;
 }
 
 void TextArea::set_style(const StyleMap & smap) {
+    flag_visual_change();
     using namespace styles;
     set_if_present(m_draw_text, smap, k_global_font, k_text_size, k_text_color);
     recompute_geometry();
 }
 
+void TextArea::add_glyphs_to(GlyphPrewarmer & prewarmer) const {
+    prewarmer.add(m_draw_text);
+    for (const auto & text : m_window) prewarmer.add(text);
+}
+
 void TextArea::issue_auto_resize() {
     recompute_geometry();
 }
@@ -107,34 +121,102 @@ void TextArea::set_text(const UString & str) {
 }
 
 void TextArea::set_string(const UString & str) {
-    m_draw_text.set_string(str);
-    recompute_geometry();
+    flag_visual_change();
+    if (m_virtual_lines) {
+        m_virtual_string = str;
+    } else {
+        m_draw_text.set_string(str);
+    }
+    update_after_new_string();
+}
+
+void TextArea::set_string(std::u32string_view str) {
+    flag_visual_change();
+    if (m_virtual_lines) {
+        m_virtual_string.assign(str.begin(), str.end());
+    } else {
+        m_draw_text.set_string(str);
+    }
+    update_after_new_string();
+}
+
+void TextArea::set_string(const Text::UChar * str)
+    { set_string(std::u32string_view(str)); }
+
+void TextArea::set_string(std::string_view utf8) {
+    flag_visual_change();
+    if (m_virtual_lines) {
+        decode_utf8(utf8, m_virtual_string, Utf8Errors::k_replace);
+    } else {
+        m_draw_text.set_string(utf8);
+    }
+    update_after_new_string();
+}
+
+const TextArea::UString & TextArea::string() const
+    { return m_virtual_lines ? m_virtual_string : m_draw_text.string(); }
+
+void TextArea::set_color_for_index(int index, sf::Color c) {
+    flag_visual_change();
+    if (m_virtual_lines) {
+        throw std::runtime_error(
+            "TextArea::set_color_for_index: coloring individual characters is "
+            "not supported with virtual lines.");
+    }
+    m_draw_text.set_color_for_character(index, c);
+}
+
+void TextArea::set_color_span(int begin, int end, sf::Color c) {
+    flag_visual_change();
+    if (m_virtual_lines) {
+        throw std::runtime_error(
+            "TextArea::set_color_span: coloring individual characters is "
+            "not supported with virtual lines.");
+    }
+    m_draw_text.set_color_span(begin, end, c);
+}
+
+void TextArea::clear_color_spans() {
+    flag_visual_change();
+    m_draw_text.clear_color_spans();
+}
+
+void TextArea::set_color(sf::Color c) {
+    flag_visual_change();
+    m_draw_text.set_color(c);
+    for (auto & text : m_window) text.set_color(c);
 }
 
 void TextArea::set_character_size(int size_) {
+    flag_visual_change();
     m_draw_text.set_character_size(size_);
     recompute_geometry();
 }
 
 void TextArea::set_width(float w) {
+    flag_visual_change();
     set_size(w, m_bounds.height);
 }
 
 void TextArea::set_height(float h) {
+    flag_visual_change();
     set_size(m_bounds.width, h);
 }
 
 void TextArea::set_max_width(float w) {
+    flag_visual_change();
     set_max_width_no_update(w);
     recompute_geometry();
 }
 
 void TextArea::set_max_height(float h) {
+    flag_visual_change();
     set_max_height_no_update(h);
     recompute_geometry();
 }
 
 void TextArea::set_size(float w, float h) {
+    flag_visual_change();
     m_bounds.width = verify_valid_size(w, "TextArea::set_size", "width");
     set_max_width_no_update(w);
 
@@ -145,17 +227,102 @@ void TextArea::set_size(float w, float h) {
 }
 
 void TextArea::assign_font(const sf::Font & font) {
+    flag_visual_change();
     m_draw_text.assign_font(&font);
     recompute_geometry();
 }
 
+void TextArea::enable_virtual_lines() {
+    flag_visual_change();
+    if (m_virtual_lines) return;
+    m_virtual_lines = true;
+    m_virtual_string = m_draw_text.string();
+    m_draw_text.set_string(UString());
+    index_virtual_lines();
+    m_scroll_offset = 0.f;
+    recompute_geometry();
+}
+
+void TextArea::disable_virtual_lines() {
+    flag_visual_change();
+    if (!m_virtual_lines) return;
+    m_virtual_lines = false;
+    m_draw_text.set_string(std::move(m_virtual_string));
+    m_virtual_string.clear();
+    m_line_starts.clear();
+    m_window.clear();
+    m_window_begin  = 0;
+    m_scroll_offset = 0.f;
+    recompute_geometry();
+}
+
+void TextArea::set_scroll_offset(float offset) {
+    flag_visual_change();
+    if (!m_virtual_lines) return;
+    m_scroll_offset = std::max(0.f, std::min(offset, max_scroll_offset()));
+    update_virtual_window(false);
+}
+
+int TextArea::line_count() const {
+    if (m_virtual_lines) return int(m_line_starts.size());
+    return m_draw_text.line_count();
+}
+
 /* protected */ void TextArea::draw
-    (sf::RenderTarget & target, sf::RenderStates) const
+    (sf::RenderTarget & target, sf::RenderStates states) const
 {
-    target.draw(m_draw_text);
+    if (!m_virtual_lines) {
+        target.draw(m_draw_text);
+        return;
+    }
+    // scrolling only moves the lines as they are drawn, lines partly in view
+    // are drawn clipped to it
+    const float line_height = m_draw_text.line_height();
+    const float view_bottom = view_height();
+    const float clip_top    =
+        states.transform.transformPoint(VectorF(m_bounds.left, m_bounds.top)).y;
+    const float clip_bottom = states.transform.transformPoint
+        (VectorF(m_bounds.left, m_bounds.top + view_bottom)).y;
+    // where the window's first line is drawn, relative to the view's top
+    // (lines a million down are too far for a float to place exactly)
+    const float window_top =
+        float(double(m_window_begin)*double(line_height) - double(m_scroll_offset));
+    auto top_of = [=](std::size_t row) { return window_top + float(row)*line_height; };
+    auto is_in_view = [=](std::size_t row)
+        { return top_of(row) < view_bottom && top_of(row) + line_height > 0.f; };
+    auto is_cut = [=](std::size_t row)
+        { return top_of(row) < 0.f || top_of(row) + line_height > view_bottom; };
+    auto draw_row = [&](std::size_t row) {
+        auto line_states = states;
+        line_states.transform.translate(0.f, top_of(row));
+        target.draw(m_window[row], line_states);
+    };
+    bool has_cut_lines = false;
+    for (std::size_t row = 0; row != m_window.size(); ++row) {
+        if (!is_in_view(row)) continue;
+        if (is_cut(row)) {
+            has_cut_lines = true;
+            continue;
+        }
+        draw_row(row);
+    }
+    if (!has_cut_lines) return;
+
+    const auto old_view = target.getView();
+    target.setView(detail::clip_view_vertically(old_view, clip_top, clip_bottom));
+    for (std::size_t row = 0; row != m_window.size(); ++row) {
+        if (is_in_view(row) && is_cut(row)) draw_row(row);
+    }
+    target.setView(old_view);
 }
 
 /* private */ void TextArea::recompute_geometry() {
+    if (m_virtual_lines) {
+        m_draw_text.set_location(m_bounds.left, m_bounds.top);
+        m_scroll_offset = std::min(m_scroll_offset, max_scroll_offset());
+        update_virtual_window(true);
+        return;
+    }
     VectorF text_loc;
     if (is_unassigned(m_bounds.width)) {
         text_loc.x = m_bounds.left;
@@ -170,8 +337,16 @@ void TextArea::assign_font(const sf::Font & font) {
     m_draw_text.set_location(text_loc);
 }
 
+/* private */ void TextArea::update_after_new_string() {
+    if (m_virtual_lines) {
+        index_virtual_lines();
+        m_scroll_offset = std::min(m_scroll_offset, max_scroll_offset());
+    }
+    recompute_geometry();
+}
+
 /* private */ void TextArea::set_max_width_no_update(float w) {
-    verify_valid_size(w, "TextArea::set_max_width_no_update", "width");
+    m_max_width = verify_valid_size(w, "TextArea::set_max_width_no_update", "width");
     if (is_unassigned(w)) {
         m_draw_text.relieve_width_limit();
     } else {
@@ -180,7 +355,7 @@ void TextArea::assign_font(const sf::Font & font) {
 }
 
 /* private */ void TextArea::set_max_height_no_update(float h) {
-    verify_valid_size(h, "TextArea::set_max_height_no_update", "height");
+    m_max_height = verify_valid_size(h, "TextArea::set_max_height_no_update", "height");
     if (is_unassigned(h)) {
         m_draw_text.relieve_height_limit();
     } else {
@@ -188,6 +363,89 @@ void TextArea::assign_font(const sf::Font & font) {
     }
 }
 
+/* private */ void TextArea::index_virtual_lines() {
+    m_line_starts.clear();
+    m_line_starts.push_back(0);
+    for (std::size_t i = 0; i != m_virtual_string.size(); ++i) {
+        if (m_virtual_string[i] == U'\n') m_line_starts.push_back(i + 1);
+    }
+}
+
+/* private */ float TextArea::view_height() const {
+    if (!is_unassigned(m_bounds.height)) return m_bounds.height;
+    if (!is_unassigned(m_max_height)) return m_max_height;
+    return float(line_count())*m_draw_text.line_height();
+}
+
+/* private */ float TextArea::max_scroll_offset() const {
+    float content_height = float(line_count())*m_draw_text.line_height();
+    return std::max(0.f, content_height - view_height());
+}
+
+/* private */ void TextArea::update_virtual_window(bool force) {
+    const float line_height = m_draw_text.line_height();
+    if (line_height <= 0.f) {
+        m_window.clear();
+        return;
+    }
+    const int count = line_count();
+    const int first = int(std::floor(m_scroll_offset / line_height));
+    const int last  = std::min(count,
+        int(std::ceil((m_scroll_offset + view_height()) / line_height)));
+    const int window_end = m_window_begin + int(m_window.size());
+    if (!force && first >= m_window_begin && last <= window_end) return;
+
+    // lines still in the new window are kept as they are
+    const int new_begin = std::max(0, first - k_virtual_line_margin);
+    const int new_end   = std::min(count, last + k_virtual_line_margin);
+    std::vector<Text> new_window;
+    new_window.reserve(std::size_t(std::max(0, new_end - new_begin)));
+    for (int line = new_begin; line < new_end; ++line) {
+        if (!force && line >= m_window_begin && line < window_end) {
+            new_window.emplace_back(std::move(m_window[std::size_t(line - m_window_begin)]));
+        } else {
+            new_window.emplace_back(make_line_text(line));
+        }
+    }
+    m_window.swap(new_window);
+    m_window_begin = new_begin;
+}
+
+/* private */ Text TextArea::make_line_text(int line) const {
+    const auto beg = m_line_starts[std::size_t(line)];
+    const auto end = std::size_t(line + 1) < m_line_starts.size()
+        ? m_line_starts[std::size_t(line + 1)] - 1 : m_virtual_string.size();
+    Text text(m_draw_text);
+    text.relieve_size_limit();
+    text.set_location(m_bounds.left, m_bounds.top);
+    text.set_string(m_virtual_string.substr(beg, end - beg));
+    if (!is_unassigned(m_max_width) && m_max_width > 0.f) {
+        text.set_viewport(0.f, m_max_width);
+    }
+    return text;
+}
+
+namespace detail {
+
+sf::View clip_view_vertically(const sf::View & view, float top, float bottom) {
+    const auto & size   = view.getSize();
+    const auto & center = view.getCenter();
+    const float view_top = center.y - size.y / 2.f;
+    top    = std::max(top, view_top);
+    bottom = std::max(top, std::min(bottom, view_top + size.y));
+
+    // the viewport is in fractions of the target, as the view's own is
+    auto viewport = view.getViewport();
+    const float scale = viewport.height / size.y;
+    viewport.top   += (top - view_top)*scale;
+    viewport.height = (bottom - top)*scale;
+    sf::View rv(sf::FloatRect(center.x - size.x / 2.f, top, size.x, bottom - top));
+    rv.setViewport(viewport);
+    return rv;
+}
+
+} // end of detail namespace
+
 } // end of ksg namespace
 
 namespace {
@@ -22,6 +22,7 @@
 #include <ksg/TextButton.hpp>
 #include <ksg/Frame.hpp>
 #include <ksg/TextArea.hpp>
+#include <ksg/GlyphPrewarmer.hpp>
 
 #include <SFML/Graphics/RenderTarget.hpp>
 
@@ -35,6 +36,7 @@ namespace ksg {
 TextButton::TextButton() {}
 
 void TextButton::swap_string(UString & str) {
+    flag_visual_change();
     m_text.set_string(std::move(str));
     update_string_position();
 }
@@ -44,6 +46,21 @@ void TextButton::set_string(const UString & str) {
     swap_string(t);
 }
 
+void TextButton::set_string(std::u32string_view str) {
+    flag_visual_change();
+    m_text.set_string(str);
+    update_string_position();
+}
+
+void TextButton::set_string(const Text::UChar * str)
+    { set_string(std::u32string_view(str)); }
+
+void TextButton::set_string(std::string_view utf8) {
+    flag_visual_change();
+    m_text.set_string(utf8);
+    update_string_position();
+}
+
 void TextButton::set_style(const StyleMap & smap) {
     set_if_present(m_text, smap, styles::k_global_font, k_text_size, k_text_color);
     Button::set_style(smap);
@@ -64,6 +81,9 @@ void TextButton::issue_auto_resize() {
     update_string_position();
 }
 
+void TextButton::add_glyphs_to(GlyphPrewarmer & prewarmer) const
+    { prewarmer.add(m_text); }
+
 /* private */ void TextButton::set_size_back(float w, float h) {
     assert(w > 0.f && h > 0.f);
     update_text_geometry(w, h);
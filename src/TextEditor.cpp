@@ -0,0 +1,402 @@
+/****************************************************************************
+
+    File: TextEditor.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include <ksg/TextEditor.hpp>
+#include <ksg/Button.hpp>
+#include <ksg/EditableText.hpp>
+#include <ksg/TextArea.hpp>
+#include <ksg/GlyphPrewarmer.hpp>
+
+#include <SFML/Window/Event.hpp>
+#include <SFML/Window/Clipboard.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <cmath>
+
+namespace {
+
+using VectorF = ksg::TextEditor::VectorF;
+using UString = ksg::TextEditor::UString;
+
+bool contains_newline(const UString &);
+
+// delete is handled as a key press
+bool is_control_character(UString::value_type);
+
+bool contains(const DrawRectangle &, VectorF);
+
+} // end of <anonymous> namespace
+
+namespace ksg {
+
+TextEditor::TextEditor() {}
+
+void TextEditor::process_event(const sf::Event & event) {
+    if (event.type == sf::Event::MouseButtonPressed) {
+        VectorF pos(float(event.mouseButton.x), float(event.mouseButton.y));
+        if (!contains(m_outer, pos) || m_lines.empty()) return;
+        request_focus();
+        auto row = int(std::floor((pos.y - m_lines.front().location().y) / line_height()));
+        row = std::max(0, std::min(row, int(m_lines.size()) - 1));
+        int line = m_top_line + row;
+        if (line >= line_count()) {
+            m_cursor = m_document.size();
+        } else {
+            // only the first line of each text is ever used
+            pos.y = m_lines[std::size_t(row)].location().y;
+            m_cursor = m_document.line_start(line)
+                + std::size_t(m_lines[std::size_t(row)].character_index_at(pos));
+        }
+        update_cursor();
+    } else if (event.type == sf::Event::MouseWheelScrolled) {
+        VectorF pos(float(event.mouseWheelScroll.x), float(event.mouseWheelScroll.y));
+        if (!contains(m_outer, pos)) return;
+        int steps = int(std::round(event.mouseWheelScroll.delta));
+        set_top_line(m_top_line - steps*k_lines_per_wheel_step);
+    }
+}
+
+void TextEditor::process_text_burst(const UString & characters)
+    { insert_typed(characters); }
+
+void TextEditor::set_location(float x, float y) {
+    flag_visual_change();
+    m_outer.set_position(x, y);
+    update_geometry();
+}
+
+VectorF TextEditor::location() const
+    { return m_outer.position(); }
+
+float TextEditor::width() const
+    { return m_outer.width(); }
+
+float TextEditor::height() const
+    { return m_outer.height(); }
+
+void TextEditor::set_style(const StyleMap & map) {
+    flag_visual_change();
+    using namespace styles;
+    if (!set_if_color_found(map, EditableText::k_background_color, m_inner)) {
+        m_inner.set_color(sf::Color::White);
+    }
+    set_if_color_found(map, Button::k_regular_back_color, m_outer);
+    set_if_found(map, Button::k_regular_front_color, m_reg_color);
+    set_if_found(map, Button::k_hover_front_color, m_focus_color);
+    set_if_found(map, k_global_padding, m_padding);
+    m_inner_padding = 2.f;
+    set_if_numeric_found(map, TextArea::k_text_size, m_line_template);
+    m_line_template.assign_font(map, k_global_font);
+    update_geometry();
+}
+
+void TextEditor::add_glyphs_to(GlyphPrewarmer & prewarmer) const {
+    for (const auto & text : m_lines) prewarmer.add(text);
+}
+
+void TextEditor::set_size(float w, float h) {
+    flag_visual_change();
+    m_outer.set_size(w, h);
+    update_geometry();
+}
+
+void TextEditor::set_string(UString str) {
+    flag_visual_change();
+    m_document = PieceTable(std::move(str));
+    m_cursor   = 0;
+    m_top_line = 0;
+    refresh_lines(m_top_line);
+    update_cursor();
+}
+
+void TextEditor::set_cursor_position(std::size_t position) {
+    flag_visual_change();
+    if (position > m_document.size()) {
+        throw std::out_of_range(
+            "TextEditor::set_cursor_position: position must be [0 "
+            "document().size()].");
+    }
+    m_cursor = position;
+    scroll_to_cursor();
+    update_cursor();
+}
+
+bool TextEditor::undo() {
+    if (!m_document.undo()) return false;
+    flag_visual_change();
+    // where the change was is not known here, so every line in view is
+    // refreshed
+    refresh_lines(m_top_line);
+    on_text_edited();
+    return true;
+}
+
+bool TextEditor::redo() {
+    if (!m_document.redo()) return false;
+    flag_visual_change();
+    refresh_lines(m_top_line);
+    on_text_edited();
+    return true;
+}
+
+void TextEditor::set_top_line(int line) {
+    line = std::max(0, std::min(line, line_count() - 1));
+    if (line == m_top_line) return;
+    flag_visual_change();
+    m_top_line = line;
+    refresh_lines(m_top_line);
+    update_cursor();
+}
+
+void TextEditor::set_character_size(int size) {
+    flag_visual_change();
+    m_line_template.set_character_size(size);
+    update_geometry();
+}
+
+void TextEditor::set_text_change_event(BlankFunc && f)
+    { m_change_text_func = std::move(f); }
+
+/* private */ void TextEditor::process_focus_event(const sf::Event & event) {
+    if (event.type == sf::Event::TextEntered) {
+        insert_typed(UString(1, UString::value_type(event.text.unicode)));
+    }
+    if (event.type == sf::Event::KeyPressed) {
+        const auto page = visible_line_count();
+        switch (event.key.code) {
+        case sf::Keyboard::BackSpace:
+            if (m_cursor > 0) erase_characters(m_cursor - 1, 1);
+            break;
+        case sf::Keyboard::Delete  : erase_characters(m_cursor, 1); break;
+        case sf::Keyboard::Left    :
+            if (m_cursor > 0) move_cursor(m_cursor - 1);
+            break;
+        case sf::Keyboard::Right   : move_cursor(m_cursor + 1); break;
+        case sf::Keyboard::Up      : move_cursor_by_lines(-1   ); break;
+        case sf::Keyboard::Down    : move_cursor_by_lines( 1   ); break;
+        case sf::Keyboard::PageUp  : move_cursor_by_lines(-page); break;
+        case sf::Keyboard::PageDown: move_cursor_by_lines( page); break;
+        case sf::Keyboard::Home:
+            move_cursor(m_document.line_start(cursor_line()));
+            break;
+        case sf::Keyboard::End:
+            move_cursor(m_document.line_end(cursor_line()));
+            break;
+        case sf::Keyboard::Z: if (event.key.control) undo(); break;
+        case sf::Keyboard::Y: if (event.key.control) redo(); break;
+        case sf::Keyboard::V:
+            if (event.key.control) {
+                auto pasted = sf::Clipboard::getString().toUtf32();
+                insert_typed(UString(pasted.begin(), pasted.end()));
+            }
+            break;
+        default: break;
+        }
+    }
+}
+
+/* private */ void TextEditor::notify_focus_gained()
+    { m_outer.set_color(m_focus_color); }
+
+/* private */ void TextEditor::notify_focus_lost()
+    { m_outer.set_color(m_reg_color); }
+
+/* private */ void TextEditor::draw
+    (sf::RenderTarget & target, sf::RenderStates states) const
+{
+    target.draw(m_outer, states);
+    target.draw(m_inner, states);
+    for (const auto & text : m_lines) target.draw(text, states);
+    if (has_focus()) { target.draw(m_cursor_rect, states); }
+}
+
+/* private */ void TextEditor::update_geometry() {
+    if (width() == 0.f || !m_line_template.has_font_assigned()) {
+        return;
+    }
+    auto inner_loc = location() + padding()*VectorF(1.f, 1.f);
+    m_inner.set_position(inner_loc);
+    m_inner.set_size(width() - padding()*2.f, height() - padding()*2.f);
+
+    // lines are cut off rather than wrapped
+    const float text_width = width() - (padding() + inner_padding())*2.f;
+    const auto text_loc = inner_loc + inner_padding()*VectorF(1.f, 1.f);
+    m_lines.assign(std::size_t(visible_line_count()), m_line_template);
+    for (std::size_t i = 0; i != m_lines.size(); ++i) {
+        auto & text = m_lines[i];
+        text.set_location(text_loc + VectorF(0.f, float(i)*line_height()));
+        if (text_width > 0.f) text.set_viewport(0.f, text_width);
+    }
+    refresh_lines(m_top_line);
+    scroll_to_cursor();
+    update_cursor();
+}
+
+void TextEditor::insert_at_cursor(const UString & str) {
+    flag_visual_change();
+    if (str.empty()) return;
+    const int line = cursor_line();
+    const auto row = std::size_t(line - m_top_line);
+    const auto column = m_cursor - m_document.line_start(line);
+    m_document.insert(m_cursor, str);
+    m_cursor += str.size();
+    if (contains_newline(str)) {
+        refresh_lines(line);
+    } else if (row < m_lines.size()) {
+        // only this line has changed, it is relaid out from the edit onward
+        m_lines[row].insert(int(column), str);
+    }
+    on_text_edited();
+}
+
+/* private */ void TextEditor::insert_typed(UString str) {
+    // return is typed as a carriage return, and pasted line endings may be
+    // "\r\n"
+    std::size_t out = 0;
+    for (std::size_t i = 0; i != str.size(); ++i) {
+        auto c = str[i];
+        if (c == U'\r') {
+            if (i + 1 != str.size() && str[i + 1] == U'\n') continue;
+            c = U'\n';
+        }
+        if (is_control_character(c)) continue;
+        str[out++] = c;
+    }
+    str.resize(out);
+    insert_at_cursor(str);
+}
+
+/* private */ void TextEditor::erase_characters
+    (std::size_t position, std::size_t count)
+{
+    if (position >= m_document.size()) return;
+    count = std::min(count, m_document.size() - position);
+    const int line = m_document.line_of(position);
+    const auto row = std::size_t(line - m_top_line);
+    const auto column = position - m_document.line_start(line);
+    // a newline is erased iff the erased range's end is on another line
+    const bool joins_lines = m_document.line_of(position + count) != line;
+    m_document.erase(position, count);
+    if (m_cursor > position)
+        m_cursor = std::max(position, m_cursor - count);
+    if (joins_lines) {
+        refresh_lines(line);
+    } else if (row < m_lines.size()) {
+        m_lines[row].erase(int(column), int(count));
+    }
+    on_text_edited();
+}
+
+/* private */ void TextEditor::on_text_edited() {
+    m_cursor = std::min(m_cursor, m_document.size());
+    scroll_to_cursor();
+    update_cursor();
+    m_change_text_func();
+}
+
+/* private */ void TextEditor::move_cursor(std::size_t position) {
+    m_cursor = std::min(position, m_document.size());
+    scroll_to_cursor();
+    update_cursor();
+}
+
+/* private */ void TextEditor::move_cursor_by_lines(int line_delta) {
+    const int line = cursor_line();
+    const auto column = m_cursor - m_document.line_start(line);
+    const int target = std::max(0, std::min(line + line_delta, line_count() - 1));
+    const auto start = m_document.line_start(target);
+    move_cursor(start + std::min(column, m_document.line_end(target) - start));
+}
+
+/* private */ void TextEditor::scroll_to_cursor() {
+    const int line = cursor_line();
+    const int rows = int(m_lines.size());
+    int top = m_top_line;
+    if (line < top) {
+        top = line;
+    } else if (rows > 0 && line >= top + rows) {
+        top = line - rows + 1;
+    }
+    top = std::max(0, std::min(top, line_count() - 1));
+    if (top == m_top_line) return;
+    m_top_line = top;
+    refresh_lines(m_top_line);
+}
+
+/* private */ void TextEditor::update_cursor() {
+    const int line = cursor_line();
+    const auto row = std::size_t(line - m_top_line);
+    if (line < m_top_line || row >= m_lines.size()) {
+        // scrolled out of view
+        m_cursor_rect.set_size(0.f, 0.f);
+        return;
+    }
+    const auto & text = m_lines[row];
+    const auto column = int(m_cursor - m_document.line_start(line));
+    m_cursor_rect.set_position(text.location() + VectorF(text.character_offset(column), 0.f));
+    m_cursor_rect.set_size    (line_height() / 8.f, line_height());
+    m_cursor_rect.set_color   (sf::Color::Black);
+}
+
+/* private */ void TextEditor::refresh_lines(int first) {
+    first = std::max(first, m_top_line);
+    for (auto row = std::size_t(first - m_top_line); row < m_lines.size(); ++row) {
+        int line = m_top_line + int(row);
+        if (line < line_count())
+            m_lines[row].set_string(m_document.line(line));
+        else
+            m_lines[row].set_string(UString());
+    }
+}
+
+/* private */ int TextEditor::visible_line_count() const {
+    if (line_height() <= 0.f) return 0;
+    float h = height() - (padding() + inner_padding())*2.f;
+    return std::max(1, int(h / line_height()));
+}
+
+/* private */ float TextEditor::line_height() const
+    { return m_line_template.line_height(); }
+
+/* private */ float TextEditor::padding() const noexcept
+    { return std::max(0.f, m_padding); }
+
+/* private */ float TextEditor::inner_padding() const noexcept
+    { return std::max(0.f, m_inner_padding); }
+
+} // end of ksg namespace
+
+namespace {
+
+bool contains_newline(const UString & str)
+    { return str.find(U'\n') != UString::npos; }
+
+bool is_control_character(UString::value_type c) {
+    return (c < U' ' && c != U'\n' && c != U'\t') || c == 127;
+}
+
+bool contains(const DrawRectangle & drect, VectorF r) {
+    return r.x >= drect.x() && r.x < drect.x() + drect.width() &&
+           r.y >= drect.y() && r.y < drect.y() + drect.height();
+}
+
+} // end of <anonymous> namespace
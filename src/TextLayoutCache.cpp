@@ -0,0 +1,212 @@
+/****************************************************************************
+
+    File: TextLayoutCache.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include <ksg/TextLayoutCache.hpp>
+
+#include <algorithm>
+#include <functional>
+
+#include <cassert>
+
+namespace {
+
+template <typename T>
+std::size_t vector_bytes(const std::vector<T> & vec)
+    { return vec.capacity()*sizeof(T); }
+
+void combine_hash(std::size_t & seed, std::size_t value)
+    { seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2); }
+
+} // end of <anonymous> namespace
+
+namespace ksg {
+
+namespace detail {
+
+std::size_t TextLayout::byte_size() const noexcept {
+    // each map node holds its value and a next pointer, besides the buckets
+    using MapValue = decltype(glyph_ids_by_char)::value_type;
+    return vector_bytes(glyph_origins) + vector_bytes(glyph_ids) +
+           vector_bytes(extents) + vector_bytes(glyph_quads) +
+           glyph_ids_by_char.bucket_count()*sizeof(void *) +
+           glyph_ids_by_char.size()*(sizeof(MapValue) + sizeof(void *)) +
+           vector_bytes(character_offsets) + vector_bytes(line_starts) +
+           vector_bytes(line_widths) + vector_bytes(chunk_ends) +
+           vector_bytes(chunk_widths) + vector_bytes(chunk_advances) +
+           sizeof(TextLayout);
+}
+
+bool TextLayoutKey::operator == (const TextLayoutKey & rhs) const noexcept {
+    return font == rhs.font && font_family == rhs.font_family &&
+           atlas == rhs.atlas && char_size == rhs.char_size &&
+           width_constraint  == rhs.width_constraint  &&
+           height_constraint == rhs.height_constraint &&
+           monospace_hint == rhs.monospace_hint && string_hash == rhs.string_hash;
+}
+
+std::size_t TextLayoutKey::hash() const noexcept {
+    std::size_t rv = string_hash;
+    combine_hash(rv, std::hash<const void *>()(font));
+    combine_hash(rv, std::hash<std::string>()(font_family));
+    combine_hash(rv, std::hash<const void *>()(atlas));
+    combine_hash(rv, std::hash<int>()(char_size));
+    combine_hash(rv, std::hash<float>()(width_constraint));
+    combine_hash(rv, std::hash<float>()(height_constraint));
+    combine_hash(rv, std::hash<bool>()(monospace_hint));
+    return rv;
+}
+
+} // end of detail namespace
+
+/* static */ constexpr const std::size_t TextLayoutCache::k_suggested_byte_limit;
+/* static */ constexpr const std::size_t TextLayoutCache::k_max_string_length;
+/* static */ constexpr const std::size_t TextLayoutCache::k_recent_miss_count;
+
+/* static */ TextLayoutCache & TextLayoutCache::instance() {
+    // never destroyed, so that atlases and texts may still forget their
+    // entries when destroyed at exit
+    static auto * inst = new TextLayoutCache();
+    return *inst;
+}
+
+void TextLayoutCache::set_byte_limit(std::size_t limit) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_byte_limit = limit;
+    evict_over_limit();
+}
+
+std::size_t TextLayoutCache::byte_limit() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_byte_limit;
+}
+
+TextLayoutCache::Counters TextLayoutCache::counters() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_counters;
+}
+
+void TextLayoutCache::reset_event_counters() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_counters.hit_count      = 0;
+    m_counters.miss_count     = 0;
+    m_counters.insert_count   = 0;
+    m_counters.eviction_count = 0;
+}
+
+void TextLayoutCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_lru.clear();
+    m_counters.entry_count = 0;
+    m_counters.byte_count  = 0;
+}
+
+void TextLayoutCache::forget_font(const sf::Font * font) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    erase_if([font](const Entry & entry) { return entry.key.font == font; });
+}
+
+void TextLayoutCache::forget_atlas(const GlyphAtlas * atlas) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    erase_if([atlas](const Entry & entry) { return entry.key.atlas == atlas; });
+}
+
+/* private */ TextLayoutCache::LayoutPtr TextLayoutCache::find
+    (const Key & key, const std::u32string & str)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_byte_limit == 0) return nullptr;
+    auto range = m_entries.equal_range(key);
+    for (auto itr = range.first; itr != range.second; ++itr) {
+        auto entry = itr->second;
+        if (entry->string != str) continue;
+        m_lru.splice(m_lru.begin(), m_lru, entry);
+        ++m_counters.hit_count;
+        return entry->layout;
+    }
+    ++m_counters.miss_count;
+    return nullptr;
+}
+
+/* private */ void TextLayoutCache::offer
+    (const Key & key, const std::u32string & str, const LayoutPtr & layout)
+{
+    assert(layout);
+    const auto hash = key.hash();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_byte_limit == 0) return;
+    auto recent_end = m_recent_misses.begin() +
+        std::ptrdiff_t(std::min(m_next_recent_miss, k_recent_miss_count));
+    if (std::find(m_recent_misses.begin(), recent_end, hash) == recent_end) {
+        m_recent_misses[m_next_recent_miss % k_recent_miss_count] = hash;
+        ++m_next_recent_miss;
+        return;
+    }
+    // (another text may have inserted it since the miss)
+    auto range = m_entries.equal_range(key);
+    for (auto itr = range.first; itr != range.second; ++itr) {
+        if (itr->second->string == str) return;
+    }
+
+    Entry entry;
+    entry.key       = key;
+    entry.string    = str;
+    entry.layout    = layout;
+    entry.byte_size = layout->byte_size() + str.capacity()*sizeof(char32_t);
+    m_lru.push_front(std::move(entry));
+    m_entries.emplace(key, m_lru.begin());
+    ++m_counters.entry_count;
+    ++m_counters.insert_count;
+    m_counters.byte_count += m_lru.front().byte_size;
+    evict_over_limit();
+}
+
+/* private */ void TextLayoutCache::evict_over_limit() {
+    while (m_counters.byte_count > m_byte_limit && !m_lru.empty()) {
+        erase(std::prev(m_lru.end()));
+        ++m_counters.eviction_count;
+    }
+}
+
+template <typename Func>
+/* private */ void TextLayoutCache::erase_if(Func && f) {
+    for (auto itr = m_lru.begin(); itr != m_lru.end(); ) {
+        auto next = std::next(itr);
+        if (f(*itr)) erase(itr);
+        itr = next;
+    }
+}
+
+/* private */ void TextLayoutCache::erase(EntryList::iterator entry) {
+    auto range = m_entries.equal_range(entry->key);
+    auto itr = std::find_if(range.first, range.second,
+        [entry](const decltype(m_entries)::value_type & pair)
+        { return pair.second == entry; });
+    assert(itr != range.second);
+    m_entries.erase(itr);
+    assert(m_counters.entry_count > 0);
+    --m_counters.entry_count;
+    m_counters.byte_count -= entry->byte_size;
+    m_lru.erase(entry);
+}
+
+} // end of ksg namespace
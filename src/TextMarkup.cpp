@@ -0,0 +1,279 @@
+/****************************************************************************
+
+    File: TextMarkup.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include <ksg/TextMarkup.hpp>
+
+#include <stdexcept>
+#include <algorithm>
+
+#include <cassert>
+
+using UString         = std::u32string;
+using UChar           = UString::value_type;
+using InvalidArg      = std::invalid_argument;
+using ColorSpan       = ksg::detail::ColorSpan;
+using TextStyle       = ksg::detail::TextStyle;
+using StyleRun        = ksg::detail::StyleRun;
+using CompiledMarkup  = ksg::detail::CompiledMarkup;
+
+namespace {
+
+constexpr const UChar k_tag_open  = U'[';
+constexpr const UChar k_tag_close = U']';
+// char sizes are up to this many digits
+constexpr const std::size_t k_max_size_digits = 4;
+
+struct FontRef {
+    const sf::Font * font = nullptr;
+    std::shared_ptr<const sf::Font> owner;
+};
+
+// The markup's state, each kind of tag opens onto its own stack, and the
+// top of each is current.
+struct MarkupState {
+    std::vector<sf::Color> colors;
+    std::vector<FontRef> fonts;
+    std::vector<int> sizes;
+};
+
+[[noreturn]] void throw_markup_error(const std::string & what, std::size_t index);
+
+// tags are ASCII, anything else is not a tag
+std::string tag_at(const UString & markup, std::size_t beg, std::size_t end);
+
+void apply_tag(const std::string & tag, std::size_t index,
+               const ksg::StyleMap &, MarkupState &);
+
+sf::Color parse_color
+    (const std::string & value, std::size_t index, const ksg::StyleMap &);
+
+int parse_char_size(const std::string & value, std::size_t index);
+
+FontRef find_font
+    (const std::string & name, std::size_t index, const ksg::StyleMap &);
+
+// @returns index of the style (from one), which is added if not already
+//          present, or zero if the state has no font or size
+int style_of(const MarkupState &, std::vector<TextStyle> & styles);
+
+sf::Color value_of(const ColorSpan & span) { return span.color; }
+
+int value_of(const StyleRun & run) { return run.style; }
+
+// appends a range, joining it with the previous if they touch and have
+// the same value
+template <typename SpanType, typename ValueType>
+void push_span(std::vector<SpanType> &, int begin, int end, const ValueType &);
+
+} // end of <anonymous> namespace
+
+namespace ksg {
+
+namespace detail {
+
+CompiledMarkup compile_markup
+    (const UString & markup, const StyleMap & named_styles)
+{
+    CompiledMarkup rv;
+    rv.string.reserve(markup.size());
+    MarkupState state;
+    // the state applies to characters from run_begin
+    int run_begin = 0;
+    auto end_run = [&]() {
+        const int end = int(rv.string.size());
+        if (end == run_begin) return;
+        if (!state.colors.empty())
+            { push_span(rv.color_spans, run_begin, end, state.colors.back()); }
+        if (int style = style_of(state, rv.styles))
+            { push_span(rv.style_runs, run_begin, end, style); }
+        run_begin = end;
+    };
+    for (std::size_t i = 0; i != markup.size(); ++i) {
+        if (markup[i] != k_tag_open) {
+            rv.string += markup[i];
+            continue;
+        }
+        if (i + 1 != markup.size() && markup[i + 1] == k_tag_open) {
+            rv.string += k_tag_open;
+            ++i;
+            continue;
+        }
+        auto close = markup.find(k_tag_close, i);
+        if (close == UString::npos) throw_markup_error("unterminated tag", i);
+        // characters so far were in the old state
+        end_run();
+        apply_tag(tag_at(markup, i + 1, close), i, named_styles, state);
+        i = close;
+    }
+    end_run();
+    return rv;
+}
+
+UString escape_markup(const UString & str) {
+    UString rv;
+    rv.reserve(str.size() + std::size_t(std::count(str.begin(), str.end(), k_tag_open)));
+    for (auto c : str) {
+        if (c == k_tag_open) rv += k_tag_open;
+        rv += c;
+    }
+    return rv;
+}
+
+} // end of detail namespace
+
+} // end of ksg namespace
+
+namespace {
+
+[[noreturn]] void throw_markup_error(const std::string & what, std::size_t index) {
+    throw InvalidArg("Text::set_markup: " + what + " at index " +
+                     std::to_string(index) + " of the markup.");
+}
+
+std::string tag_at(const UString & markup, std::size_t beg, std::size_t end) {
+    assert(beg <= end);
+    std::string rv;
+    rv.reserve(end - beg);
+    for (auto i = beg; i != end; ++i) {
+        if (markup[i] < U' ' || markup[i] > U'~')
+            throw_markup_error("tags may only contain printable ASCII", i);
+        rv += char(markup[i]);
+    }
+    return rv;
+}
+
+void apply_tag(const std::string & tag, std::size_t index,
+               const ksg::StyleMap & named_styles, MarkupState & state)
+{
+    auto pop = [index, &tag](auto & stack) {
+        if (stack.empty())
+            throw_markup_error("closing tag \"" + tag + "\" without an open tag", index);
+        stack.pop_back();
+    };
+    if (tag == "/color") return pop(state.colors);
+    if (tag == "/size" ) return pop(state.sizes );
+    if (tag == "/font" ) return pop(state.fonts );
+
+    auto eq = tag.find('=');
+    if (eq == std::string::npos)
+        throw_markup_error("unknown tag \"" + tag + "\"", index);
+    const auto name  = tag.substr(0, eq);
+    const auto value = tag.substr(eq + 1);
+    if (name == "color") {
+        state.colors.push_back(parse_color(value, index, named_styles));
+    } else if (name == "size") {
+        state.sizes.push_back(parse_char_size(value, index));
+    } else if (name == "font") {
+        state.fonts.push_back(find_font(value, index, named_styles));
+    } else {
+        throw_markup_error("unknown tag \"" + tag + "\"", index);
+    }
+}
+
+sf::Color parse_color
+    (const std::string & value, std::size_t index,
+     const ksg::StyleMap & named_styles)
+{
+    if (value.empty() || value[0] != '#') {
+        auto itr = named_styles.find(value);
+        if (itr == named_styles.end() || !itr->second.is_type<sf::Color>())
+            throw_markup_error("\"" + value + "\" is not a named color", index);
+        return itr->second.as<sf::Color>();
+    }
+    // #rrggbb or #rrggbbaa
+    if (value.size() != 7 && value.size() != 9)
+        throw_markup_error("color \"" + value + "\" is not #rrggbb or #rrggbbaa", index);
+    auto digit = [&value, index](std::size_t i) {
+        char c = value[i];
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        throw_markup_error("color \"" + value + "\" has a non hex digit", index);
+    };
+    auto channel = [&digit](std::size_t i)
+        { return sf::Uint8(digit(i)*16 + digit(i + 1)); };
+    return sf::Color(channel(1), channel(3), channel(5),
+                     value.size() == 9 ? channel(7) : sf::Uint8(255));
+}
+
+int parse_char_size(const std::string & value, std::size_t index) {
+    if (value.empty() || value.size() > k_max_size_digits ||
+        !std::all_of(value.begin(), value.end(),
+                     [](char c) { return c >= '0' && c <= '9'; }))
+    {
+        throw_markup_error("size \"" + value + "\" is not a positive integer "
+                           "(of at most four digits)", index);
+    }
+    int rv = std::stoi(value);
+    if (rv < 1) throw_markup_error("size must be positive", index);
+    return rv;
+}
+
+FontRef find_font
+    (const std::string & name, std::size_t index,
+     const ksg::StyleMap & named_styles)
+{
+    FontRef rv;
+    auto itr = named_styles.find(name);
+    if (itr != named_styles.end()) {
+        const auto & field = itr->second;
+        if (field.is_type<const sf::Font *>()) {
+            rv.font = field.as<const sf::Font *>();
+        } else if (field.is_type<std::shared_ptr<const sf::Font>>()) {
+            rv.owner = field.as<std::shared_ptr<const sf::Font>>();
+            rv.font  = rv.owner.get();
+        }
+    }
+    if (!rv.font)
+        throw_markup_error("\"" + name + "\" is not a named font", index);
+    return rv;
+}
+
+int style_of(const MarkupState & state, std::vector<TextStyle> & styles) {
+    if (state.fonts.empty() && state.sizes.empty()) return 0;
+    TextStyle style;
+    if (!state.fonts.empty()) {
+        style.font       = state.fonts.back().font;
+        style.font_owner = state.fonts.back().owner;
+    }
+    if (!state.sizes.empty()) style.char_size = state.sizes.back();
+    auto itr = std::find_if(styles.begin(), styles.end(),
+        [&style](const TextStyle & rhs)
+        { return rhs.font == style.font && rhs.char_size == style.char_size; });
+    if (itr == styles.end()) itr = styles.insert(itr, std::move(style));
+    return int(itr - styles.begin()) + 1;
+}
+
+template <typename SpanType, typename ValueType>
+void push_span(std::vector<SpanType> & spans, int begin, int end,
+               const ValueType & value)
+{
+    if (!spans.empty() && spans.back().end == begin &&
+        value_of(spans.back()) == value)
+    {
+        spans.back().end = end;
+        return;
+    }
+    spans.push_back(SpanType { begin, end, value });
+}
+
+} // end of <anonymous> namespace
@@ -0,0 +1,172 @@
+/****************************************************************************
+
+    File: TextureBudget.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+#include <ksg/TextureBudget.hpp>
+
+#include <cassert>
+
+namespace ksg {
+
+namespace detail {
+
+BudgetedTexture::BudgetedTexture
+    (const std::string & filename, const sf::IntRect & area):
+    m_filename(filename),
+    m_area(area)
+{}
+
+BudgetedTexture::BudgetedTexture(ImagePtr atlas, const sf::IntRect & area):
+    m_atlas(atlas),
+    m_area(area)
+{}
+
+BudgetedTexture::BudgetedTexture(const BudgetedTexture & rhs):
+    m_filename(rhs.m_filename),
+    m_atlas   (rhs.m_atlas   ),
+    m_area    (rhs.m_area    )
+{}
+
+BudgetedTexture::~BudgetedTexture() {
+    if (m_resident) TextureBudget::instance().on_released(*this);
+}
+
+BudgetedTexture & BudgetedTexture::operator = (const BudgetedTexture & rhs) {
+    if (this != &rhs) {
+        BudgetedTexture temp(rhs);
+        swap(temp);
+    }
+    return *this;
+}
+
+bool BudgetedTexture::has_source() const noexcept
+    { return !m_filename.empty() || m_atlas; }
+
+bool BudgetedTexture::acquire() const {
+    if (m_resident) {
+        TextureBudget::instance().on_used(*this);
+        return true;
+    }
+    if (!has_source()) return false;
+
+    if (!load_from_source()) {
+        TextureBudget::instance().on_failed_load();
+        return false;
+    }
+    bool is_reload  = m_loaded_before;
+    m_resident      = true;
+    m_loaded_before = true;
+    TextureBudget::instance().on_loaded(*this, is_reload);
+    return true;
+}
+
+std::size_t BudgetedTexture::byte_size() const noexcept {
+    // RGBA, no mip maps
+    auto size = m_texture.getSize();
+    return std::size_t(size.x)*std::size_t(size.y)*4;
+}
+
+void BudgetedTexture::swap(BudgetedTexture & rhs) {
+    m_filename.swap(rhs.m_filename);
+    m_atlas   .swap(rhs.m_atlas   );
+    std::swap(m_area, rhs.m_area);
+    m_texture .swap(rhs.m_texture );
+    std::swap(m_resident     , rhs.m_resident     );
+    std::swap(m_loaded_before, rhs.m_loaded_before);
+    std::swap(m_lru_position , rhs.m_lru_position );
+    // the budget refers to textures by address, the list entries must follow
+    // their textures
+    if (m_resident    ) *m_lru_position     = this;
+    if (rhs.m_resident) *rhs.m_lru_position = &rhs;
+}
+
+/* private */ bool BudgetedTexture::load_from_source() const {
+    if (!m_filename.empty()) {
+        return m_texture.loadFromFile(m_filename, m_area);
+    } else if (m_atlas) {
+        return m_texture.loadFromImage(*m_atlas, m_area);
+    }
+    return false;
+}
+
+/* private */ void BudgetedTexture::evict() const {
+    // assigning an empty texture releases the video memory
+    m_texture  = sf::Texture();
+    m_resident = false;
+}
+
+} // end of detail namespace
+
+/* static */ constexpr const std::size_t TextureBudget::k_no_limit;
+
+/* static */ TextureBudget & TextureBudget::instance() {
+    static TextureBudget inst;
+    return inst;
+}
+
+void TextureBudget::set_byte_limit(std::size_t limit) {
+    m_byte_limit = limit;
+    evict_over_limit(nullptr);
+}
+
+void TextureBudget::reset_event_counters() {
+    m_counters.reload_count   = 0;
+    m_counters.eviction_count = 0;
+    m_counters.failed_loads   = 0;
+}
+
+/* private */ void TextureBudget::on_loaded
+    (const BudgetedTexture & texture, bool is_reload)
+{
+    assert(texture.is_resident());
+    m_lru.push_front(&texture);
+    texture.m_lru_position = m_lru.begin();
+    ++m_counters.resident_count;
+    m_counters.resident_bytes += texture.byte_size();
+    if (is_reload) ++m_counters.reload_count;
+    evict_over_limit(&texture);
+}
+
+/* private */ void TextureBudget::on_used(const BudgetedTexture & texture) {
+    assert(texture.is_resident());
+    m_lru.splice(m_lru.begin(), m_lru, texture.m_lru_position);
+}
+
+/* private */ void TextureBudget::on_released(const BudgetedTexture & texture) {
+    assert(texture.is_resident());
+    assert(m_counters.resident_count > 0);
+    m_lru.erase(texture.m_lru_position);
+    --m_counters.resident_count;
+    m_counters.resident_bytes -= texture.byte_size();
+}
+
+/* private */ void TextureBudget::evict_over_limit(const BudgetedTexture * keep) {
+    while (m_counters.resident_bytes > m_byte_limit && !m_lru.empty()) {
+        const BudgetedTexture * victim = m_lru.back();
+        // the kept texture is the most recently used, if it is at the back,
+        // it is the only one left
+        if (victim == keep) break;
+        on_released(*victim);
+        victim->evict();
+        ++m_counters.eviction_count;
+    }
+}
+
+} // end of ksg namespace
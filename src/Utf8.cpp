@@ -0,0 +1,212 @@
+/****************************************************************************
+
+    File: Utf8.cpp
+    Author: Aria Janke
+    License: GPLv3
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*****************************************************************************/
+
+
+#include <ksg/Utf8.hpp>
+
+#include <stdexcept>
+#include <string>
+
+#include <cstdint>
+
+// ASCII runs are checked sixteen bytes at a time on x86-64, where SSE2 is
+// always present.
+#if defined(__x86_64__) || defined(_M_X64)
+#   define MACRO_KSG_SSE2_UTF8
+#   include <emmintrin.h>
+#endif
+
+namespace {
+
+using Byte       = unsigned char;
+using Utf8Errors = ksg::Utf8Errors;
+
+struct Sequence {
+    char32_t code_point = 0;
+    // bytes taken, for malformed sequences this is the longest prefix which
+    // could have begun a valid sequence (at least one byte)
+    std::size_t length = 1;
+    bool is_valid = false;
+};
+
+// decodes the sequence beginning at beg, which must not be ASCII
+Sequence decode_sequence(const Byte * beg, const Byte * end) noexcept;
+
+// widens ASCII from beg until the first other byte (or end)
+// @returns end of the ASCII run
+// @note out must have room for as many characters as there are bytes left
+const Byte * widen_ascii(const Byte * beg, const Byte * end, char32_t *& out) noexcept;
+
+// @returns end of the ASCII run starting at beg
+const Byte * skip_ascii(const Byte * beg, const Byte * end) noexcept;
+
+#ifdef MACRO_KSG_SSE2_UTF8
+// @returns index of the first non ASCII byte, sixteen if there are none
+int ascii_prefix_length(__m128i bytes) noexcept;
+#endif
+
+[[noreturn]] void throw_malformed(std::size_t index);
+
+} // end of <anonymous> namespace
+
+namespace ksg {
+
+void decode_utf8(std::string_view utf8, std::u32string & out, Utf8Errors errors) {
+    // never more characters than bytes, out is trimmed afterward
+    out.resize(utf8.size());
+    const auto * beg = reinterpret_cast<const Byte *>(utf8.data());
+    const auto * end = beg + utf8.size();
+    char32_t * write = out.data();
+    for (const auto * itr = beg; itr != end; ) {
+        itr = widen_ascii(itr, end, write);
+        if (itr == end) break;
+        auto seq = decode_sequence(itr, end);
+        if (!seq.is_valid) {
+            if (errors == Utf8Errors::k_throw) throw_malformed(std::size_t(itr - beg));
+            seq.code_point = k_replacement_character;
+        }
+        *write++ = seq.code_point;
+        itr += seq.length;
+    }
+    out.resize(std::size_t(write - out.data()));
+}
+
+std::u32string decode_utf8(std::string_view utf8, Utf8Errors errors) {
+    std::u32string rv;
+    decode_utf8(utf8, rv, errors);
+    return rv;
+}
+
+std::size_t find_invalid_utf8(std::string_view utf8) noexcept {
+    const auto * beg = reinterpret_cast<const Byte *>(utf8.data());
+    const auto * end = beg + utf8.size();
+    for (const auto * itr = beg; itr != end; ) {
+        itr = skip_ascii(itr, end);
+        if (itr == end) break;
+        auto seq = decode_sequence(itr, end);
+        if (!seq.is_valid) return std::size_t(itr - beg);
+        itr += seq.length;
+    }
+    return utf8.size();
+}
+
+} // end of ksg namespace
+
+namespace {
+
+Sequence decode_sequence(const Byte * beg, const Byte * end) noexcept {
+    // Unicode's table of well formed sequences: continuation bytes are
+    // 80..BF, except the second byte after E0 (overlong), ED (surrogates),
+    // F0 (overlong) and F4 (past U+10FFFF), whose ranges are narrower
+    const Byte lead = *beg;
+    Sequence rv;
+    std::size_t length = 0;
+    Byte second_low  = 0x80;
+    Byte second_high = 0xBF;
+    char32_t code_point = 0;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length     = 2;
+        code_point = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length     = 3;
+        code_point = lead & 0x0F;
+        if (lead == 0xE0) second_low  = 0xA0;
+        if (lead == 0xED) second_high = 0x9F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length     = 4;
+        code_point = lead & 0x07;
+        if (lead == 0xF0) second_low  = 0x90;
+        if (lead == 0xF4) second_high = 0x8F;
+    } else {
+        // a stray continuation byte, or one which never leads
+        return rv;
+    }
+    for (std::size_t i = 1; i != length; ++i) {
+        if (beg + i == end) return rv;
+        const Byte low  = (i == 1) ? second_low  : Byte(0x80);
+        const Byte high = (i == 1) ? second_high : Byte(0xBF);
+        if (beg[i] < low || beg[i] > high) return rv;
+        code_point = (code_point << 6) | char32_t(beg[i] & 0x3F);
+        rv.length  = i + 1;
+    }
+    rv.code_point = code_point;
+    rv.is_valid   = true;
+    return rv;
+}
+
+const Byte * widen_ascii(const Byte * itr, const Byte * end, char32_t *& out) noexcept {
+#   ifdef MACRO_KSG_SSE2_UTF8
+    // all sixteen bytes are widened and written, even past the run (out has
+    // room for them, they are overwritten by what follows)
+    const __m128i zero = _mm_setzero_si128();
+    while (end - itr >= 16 && *itr < 0x80) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(itr));
+        const __m128i low   = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i high  = _mm_unpackhi_epi8(bytes, zero);
+        auto * dest = reinterpret_cast<__m128i *>(out);
+        _mm_storeu_si128(dest    , _mm_unpacklo_epi16(low , zero));
+        _mm_storeu_si128(dest + 1, _mm_unpackhi_epi16(low , zero));
+        _mm_storeu_si128(dest + 2, _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128(dest + 3, _mm_unpackhi_epi16(high, zero));
+        const int count = ascii_prefix_length(bytes);
+        itr += count;
+        out += count;
+        if (count != 16) return itr;
+    }
+#   endif
+    for (; itr != end && *itr < 0x80; ++itr) *out++ = char32_t(*itr);
+    return itr;
+}
+
+const Byte * skip_ascii(const Byte * itr, const Byte * end) noexcept {
+#   ifdef MACRO_KSG_SSE2_UTF8
+    while (end - itr >= 16) {
+        const int count = ascii_prefix_length(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(itr)));
+        itr += count;
+        if (count != 16) return itr;
+    }
+#   endif
+    while (itr != end && *itr < 0x80) ++itr;
+    return itr;
+}
+
+#ifdef MACRO_KSG_SSE2_UTF8
+int ascii_prefix_length(__m128i bytes) noexcept {
+    // (non ASCII bytes have their high bits set)
+    unsigned mask = unsigned(_mm_movemask_epi8(bytes));
+    if (mask == 0) return 16;
+#   if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#   else
+    int count = 0;
+    for (; !(mask & 1u); mask >>= 1) ++count;
+    return count;
+#   endif
+}
+#endif
+
+[[noreturn]] void throw_malformed(std::size_t index) {
+    throw std::invalid_argument("decode_utf8: malformed UTF-8 at byte " +
+                                std::to_string(index) + ".");
+}
+
+} // end of <anonymous> namespace
@@ -69,4 +69,6 @@ void Widget::add_focus_widgets_to(std::vector<FocusWidget *> &)
 
 void Widget::issue_auto_resize() {}
 
+void Widget::add_glyphs_to(GlyphPrewarmer &) const {}
+
 } // end of ksg namespace